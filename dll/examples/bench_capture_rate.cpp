@@ -0,0 +1,237 @@
+// Adaptive capture rate benchmark: replays a scripted match on a simulated
+// clock and compares fixed capture intervals with CaptureRatePolicy.
+//
+// The match is two minutes of warmup followed by rounds alternating between
+// a round decided by a plant, a post-plant clutch and a defuse, and a round
+// decided by eliminations. Rounds have a 15 s freezetime, buy time and 5 s
+// between rounds. Captures are the CPU cost (every capture reads game
+// memory). "detect" is the time from a change in the game to the first
+// capture that sees it, over all changes, over the plant itself and over
+// changes after the plant; "post-plant gap" is the longest time between two
+// captures while the bomb is down. The same comparison then runs on a server
+// nobody plays on.
+//
+// Usage: bench_capture_rate [rounds]
+
+#include "capture_rate_policy.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace CS16Capture;
+
+namespace {
+
+const int64_t kWarmupMs = 120000;
+const int64_t kFreezeMs = 15000;
+const int64_t kRoundEndDelayMs = 5000;
+const int64_t kIdleMs = 600000;     // Length of the run without rounds: a server nobody plays on
+const int64_t kFirstCaptureMs = 7;   // Keep captures off the round numbers of the script
+
+enum class Action { BUY, DEATH, PLANT, DEFUSE, END };
+
+struct ScriptStep {
+    int64_t atMs;       // From round start
+    Action action;
+    int slot;           // Slots 0-4 are terrorists, 5-9 counter-terrorists
+};
+
+const ScriptStep kPlantRound[] = {
+    {15300, Action::BUY, 0}, {15800, Action::BUY, 5}, {16400, Action::BUY, 1}, {17100, Action::BUY, 6},
+    {18600, Action::BUY, 2}, {19200, Action::BUY, 7}, {21300, Action::BUY, 3}, {22900, Action::BUY, 8},
+    {48130, Action::DEATH, 4}, {49570, Action::DEATH, 9}, {70210, Action::DEATH, 3},
+    {85330, Action::PLANT, 0},
+    {92040, Action::DEATH, 8}, {93110, Action::DEATH, 7}, {100470, Action::DEATH, 6},
+    {107290, Action::DEATH, 2}, {111830, Action::DEATH, 1},
+    {118650, Action::DEFUSE, 5}, {118650, Action::END, 0},
+};
+
+const ScriptStep kEliminationRound[] = {
+    {15200, Action::BUY, 1}, {15900, Action::BUY, 6}, {16300, Action::BUY, 0}, {17700, Action::BUY, 5},
+    {35410, Action::DEATH, 2}, {36230, Action::DEATH, 7}, {36990, Action::DEATH, 3},
+    {52170, Action::DEATH, 8}, {58020, Action::DEATH, 0}, {58930, Action::DEATH, 9},
+    {64360, Action::DEATH, 1}, {71080, Action::DEATH, 4}, {71080, Action::END, 0},
+};
+
+struct Round {
+    int64_t startMs;
+    int64_t endMs;          // Decided; the next round starts kRoundEndDelayMs later
+    const ScriptStep* steps;
+    size_t stepCount;
+};
+
+struct Change {
+    int64_t atMs;
+    bool plant;
+    bool postPlant;
+};
+
+std::vector<Round> buildMatch(int rounds) {
+    std::vector<Round> match;
+    int64_t start = kWarmupMs;
+    for (int i = 0; i < rounds; ++i) {
+        Round round;
+        round.startMs = start;
+        round.steps = i % 2 == 0 ? kPlantRound : kEliminationRound;
+        round.stepCount = i % 2 == 0 ? sizeof(kPlantRound) / sizeof(kPlantRound[0])
+                                     : sizeof(kEliminationRound) / sizeof(kEliminationRound[0]);
+        round.endMs = start + round.steps[round.stepCount - 1].atMs;
+        match.push_back(round);
+        start = round.endMs + kRoundEndDelayMs;
+    }
+    return match;
+}
+
+// State of the match at a time, rebuilt from the script
+void stateAt(const std::vector<Round>& match, int64_t timeMs, GameState& state) {
+    state.players.clear();
+    for (size_t slot = 0; slot < 10; ++slot) {
+        state.players.setPresent(slot, "Player", 6);
+        state.players.team[slot] = slot < 5 ? 1 : 2;
+        state.players.alive[slot] = 1;
+        state.players.money[slot] = 800;
+    }
+    state.bomb = BombData();
+    state.roundNumber = 0;
+    state.roundTime = 0.0f;
+
+    const Round* round = nullptr;
+    for (const Round& candidate : match) {
+        if (candidate.startMs <= timeMs) {
+            round = &candidate;
+        }
+    }
+    if (round == nullptr) {
+        return;
+    }
+
+    int64_t inRound = timeMs - round->startMs;
+    int64_t decided = round->endMs - round->startMs;
+    state.roundNumber = static_cast<int32_t>(round - match.data() + 1);
+    // Frozen during freezetime and once the round is decided
+    int64_t running = std::min(std::max<int64_t>(inRound - kFreezeMs, 0), decided - kFreezeMs);
+    state.roundTime = 105.0f - static_cast<float>(running) / 1000.0f;
+    int64_t plantedAt = 0;
+    for (size_t i = 0; i < round->stepCount && round->steps[i].atMs <= inRound; ++i) {
+        const ScriptStep& step = round->steps[i];
+        switch (step.action) {
+            case Action::BUY: state.players.money[step.slot] -= 650; break;
+            case Action::DEATH: state.players.alive[step.slot] = 0; ++state.players.deaths[step.slot]; break;
+            case Action::PLANT: state.bomb.planted = true; plantedAt = step.atMs; break;
+            case Action::DEFUSE: state.bomb.defused = true; break;
+            case Action::END: break;
+        }
+    }
+    if (state.bomb.planted) {
+        state.bomb.timeRemaining = std::max(0.0f, 35.0f - static_cast<float>(inRound - plantedAt) / 1000.0f);
+    }
+}
+
+std::vector<Change> changesOf(const std::vector<Round>& match) {
+    std::vector<Change> changes;
+    for (const Round& round : match) {
+        changes.push_back({round.startMs, false, false});
+        int64_t plantedAt = -1;
+        for (size_t i = 0; i < round.stepCount; ++i) {
+            const ScriptStep& step = round.steps[i];
+            if (step.action == Action::PLANT) {
+                plantedAt = step.atMs;
+            }
+            if (step.action != Action::END) {
+                changes.push_back({round.startMs + step.atMs, step.action == Action::PLANT,
+                                   plantedAt >= 0 && step.atMs > plantedAt});
+            }
+        }
+    }
+    return changes;
+}
+
+void run(const char* name, int rounds, const CaptureRateConfig* adaptive, uint32_t fixedMs) {
+    std::vector<Round> match = buildMatch(rounds);
+    CaptureRatePolicy policy(adaptive != nullptr ? *adaptive : CaptureRateConfig());
+    const int64_t endMs = match.empty() ? kIdleMs : match.back().endMs + kRoundEndDelayMs;
+    const CaptureRatePolicy::Clock::time_point origin;  // Any fixed point works for the policy
+
+    std::vector<int64_t> captures;
+    int64_t phaseMs[3] = {0, 0, 0};
+    GameState state;
+    for (int64_t now = kFirstCaptureMs; now < endMs + 1000; ) {
+        stateAt(match, now, state);
+        captures.push_back(now);
+        int64_t interval = fixedMs;
+        if (adaptive != nullptr) {
+            interval = policy.onCapture(state, origin + std::chrono::hours(1) + std::chrono::milliseconds(now)).count();
+            phaseMs[static_cast<size_t>(policy.getPhase())] += interval;
+        }
+        now += interval;
+    }
+
+    double detectAll = 0.0;
+    double detectPlant = 0.0;
+    double detectPostPlant = 0.0;
+    size_t plants = 0;
+    size_t postPlant = 0;
+    std::vector<Change> changes = changesOf(match);
+    for (const Change& change : changes) {
+        int64_t seen = *std::lower_bound(captures.begin(), captures.end(), change.atMs) - change.atMs;
+        detectAll += static_cast<double>(seen);
+        if (change.plant) {
+            detectPlant += static_cast<double>(seen);
+            ++plants;
+        }
+        if (change.postPlant) {
+            detectPostPlant += static_cast<double>(seen);
+            ++postPlant;
+        }
+    }
+
+    // Longest gap between captures while a bomb is down
+    int64_t postPlantGap = 0;
+    for (const Round& round : match) {
+        for (size_t i = 0; i < round.stepCount; ++i) {
+            if (round.steps[i].action != Action::PLANT) {
+                continue;
+            }
+            int64_t plantMs = round.startMs + round.steps[i].atMs;
+            auto first = std::lower_bound(captures.begin(), captures.end(), plantMs);
+            for (auto capture = first + 1; capture != captures.end() && *capture <= round.endMs; ++capture) {
+                postPlantGap = std::max(postPlantGap, *capture - *(capture - 1));
+            }
+        }
+    }
+
+    std::printf("%-20s %7zu captures (%5.1f/s) | detect avg %5.1f ms, plant %5.1f ms, post-plant %5.1f ms | "
+                "post-plant gap %3lld ms\n",
+                name, captures.size(), static_cast<double>(captures.size()) * 1000.0 / static_cast<double>(endMs),
+                detectAll / static_cast<double>(std::max<size_t>(changes.size(), 1)),
+                detectPlant / static_cast<double>(std::max<size_t>(plants, 1)),
+                detectPostPlant / static_cast<double>(std::max<size_t>(postPlant, 1)),
+                static_cast<long long>(postPlantGap));
+    if (adaptive != nullptr) {
+        double total = static_cast<double>(phaseMs[0] + phaseMs[1] + phaseMs[2]);
+        std::printf("%-20s time quiet %.0f%%, active %.0f%%, critical %.0f%%\n", "",
+                    100.0 * static_cast<double>(phaseMs[0]) / total, 100.0 * static_cast<double>(phaseMs[1]) / total,
+                    100.0 * static_cast<double>(phaseMs[2]) / total);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int rounds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 30;
+    Logger::getInstance().setDebugEnabled(false);
+
+    CaptureRateConfig adaptive;
+    std::printf("%d rounds after %lld s of warmup; adaptive %u/%u/%u ms, hold %u ms\n", rounds,
+                static_cast<long long>(kWarmupMs / 1000), adaptive.fastestIntervalMs, adaptive.baseIntervalMs,
+                adaptive.slowestIntervalMs, adaptive.holdMs);
+    run("fixed 100 ms", rounds, nullptr, 100);
+    run("fixed 50 ms", rounds, nullptr, 50);
+    run("adaptive", rounds, &adaptive, 0);
+    std::printf("Idle server for %lld s\n", static_cast<long long>(kIdleMs / 1000));
+    run("fixed 100 ms, idle", 0, nullptr, 100);
+    run("adaptive, idle", 0, &adaptive, 0);
+    return 0;
+}
@@ -0,0 +1,233 @@
+// Stream compression benchmark: compression ratio against CPU time per
+// frame for the codecs of StreamCompressor, over a simulated match.
+//
+// A 20-player frame is encoded every 50 ms and a ping every second, as a
+// collector sends them. Each case compresses the whole stream message by
+// message, then decompresses it fed in arbitrary 1400-byte pieces, as TCP
+// delivers it, and checks the text comes back unchanged. "no context" cases
+// start a new stream for every frame, which is what compression without
+// context takeover amounts to. The zstd dictionary is trained on frames of
+// a different match than the one measured.
+//
+// Usage: bench_compression [frames] [threshold]
+
+#include "logger.h"
+#include "name_table.h"
+#include "state_encoder.h"
+#include "stream_compressor.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace CS16Capture;
+
+namespace {
+
+const uint64_t kFrameIntervalNs = 50000000;  // 20 Hz
+const size_t kFramesPerPing = 20;
+const size_t kTcpChunk = 1400;
+const size_t kDictionarySize = 16 * 1024;
+
+uint32_t nextRandom(uint32_t& seed) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+// Frames and pings of one match, in send order
+std::vector<std::string> buildStream(size_t frames, uint32_t seed, NameTable& names) {
+    std::vector<std::string> messages;
+    StateEncoder encoder(4242);
+    GameState state;
+    state.nameTable = &names;
+    for (size_t slot = 0; slot < 20; ++slot) {
+        char name[24];
+        std::snprintf(name, sizeof(name), "Player_%u_%zu", seed % 1000, slot);
+        state.players.setPresent(slot, name, sizeof(name));
+        state.players.nameIds[slot] = names.internSlot(slot, name, sizeof(name));
+        state.players.team[slot] = static_cast<int32_t>(slot % 2 + 1);
+        state.players.money[slot] = 800;
+    }
+
+    std::string frame;
+    for (size_t i = 0; i < frames; ++i) {
+        // A round every 2000 frames: everyone alive, then random kills
+        if (i % 2000 == 0) {
+            ++state.roundNumber;
+            state.roundTime = 115.0f;
+            state.bomb = BombData();
+            for (size_t slot = 0; slot < 20; ++slot) {
+                state.players.alive[slot] = 1;
+                state.players.money[slot] = std::min(state.players.money[slot] + 2400, 16000);
+            }
+        }
+        state.events.clear();
+        state.roundTime = std::max(0.0f, state.roundTime - 0.05f);
+        if (nextRandom(seed) % 40 == 0) {
+            size_t killer = nextRandom(seed) % 20;
+            size_t victim = nextRandom(seed) % 20;
+            if (killer != victim && state.players.alive[victim]) {
+                ++state.players.kills[killer];
+                ++state.players.deaths[victim];
+                state.players.alive[victim] = 0;
+                state.players.money[killer] = std::min(state.players.money[killer] + 300, 16000);
+                state.events.push_back(GameEvent::PLAYER_KILLED);
+            }
+        }
+        if (i % 2000 == 900) {
+            state.bomb.planted = true;
+            state.bomb.timeRemaining = 35.0f;
+            state.events.push_back(GameEvent::BOMB_PLANTED);
+        }
+        if (state.bomb.planted) {
+            state.bomb.timeRemaining = std::max(0.0f, state.bomb.timeRemaining - 0.05f);
+        }
+        state.captureTimeNs = 81234560000000ull + i * kFrameIntervalNs;
+
+        encoder.encode(state, 1, frame, state.captureTimeNs);
+        messages.push_back(frame);
+        if (i % kFramesPerPing == 0) {
+            messages.push_back("{\"type\":\"ping\",\"id\":" + std::to_string(i / kFramesPerPing + 1) +
+                               ",\"t\":" + std::to_string(state.captureTimeNs / 1000) + "}\n");
+        }
+    }
+    return messages;
+}
+
+struct Case {
+    const char* label;
+    CompressionCodec codec;
+    int level;
+    bool contextTakeover;
+    bool dictionary;
+};
+
+void runCase(const Case& c, const std::vector<std::string>& messages, size_t frames, size_t threshold,
+             const std::string& dictionary) {
+    if (!isCompressionCodecAvailable(c.codec)) {
+        std::printf("%-28s not compiled in\n", c.label);
+        return;
+    }
+
+    CompressionConfig config;
+    config.codec = c.codec;
+    config.level = c.level;
+    config.threshold = threshold;
+    if (c.dictionary) {
+        config.dictionary = dictionary;
+    }
+
+    // Compress
+    StreamCompressor compressor;
+    compressor.reset(config);
+    std::string wire;
+    std::string record;
+    uint64_t plainBytes = 0;
+    uint64_t plainRecords = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string& message : messages) {
+        if (!c.contextTakeover) {
+            compressor.reset(config);
+        }
+        compressor.compress(message.data(), message.size(), record);
+        plainBytes += message.size();
+        wire.append(record);
+        plainRecords += record.size() == message.size() + CompressionWire::kRecordHeaderSize ? 1 : 0;
+    }
+    double compressNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    // Decompress, fed in pieces that split records anywhere
+    std::string decoded;
+    decoded.reserve(plainBytes);
+    double decompressNs = 0.0;
+    bool ok = true;
+    if (c.contextTakeover) {
+        StreamDecompressor decompressor;
+        decompressor.reset(c.codec, config.dictionary);
+        start = std::chrono::steady_clock::now();
+        for (size_t offset = 0; offset < wire.size() && ok; offset += kTcpChunk) {
+            ok = decompressor.feed(wire.data() + offset, std::min(kTcpChunk, wire.size() - offset), decoded);
+        }
+        decompressNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    } else {
+        // Every record is a stream of its own
+        StreamDecompressor decompressor;
+        start = std::chrono::steady_clock::now();
+        for (size_t offset = 0; offset < wire.size() && ok;) {
+            uint32_t header = 0;
+            for (size_t i = 0; i < CompressionWire::kRecordHeaderSize; ++i) {
+                header |= static_cast<uint32_t>(static_cast<unsigned char>(wire[offset + i])) << (8 * i);
+            }
+            size_t size = CompressionWire::kRecordHeaderSize + (header & ~CompressionWire::kCompressedFlag);
+            decompressor.reset(c.codec, config.dictionary);
+            ok = decompressor.feed(wire.data() + offset, size, decoded);
+            offset += size;
+        }
+        decompressNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::string expected;
+    expected.reserve(plainBytes);
+    for (const std::string& message : messages) {
+        expected.append(message);
+    }
+    ok = ok && decoded == expected;
+
+    std::printf("%-28s %7.2fx %8.0f B/frame %8.2f us %8.2f us %6llu  %s\n", c.label,
+                static_cast<double>(plainBytes) / static_cast<double>(wire.size()),
+                static_cast<double>(wire.size()) / static_cast<double>(frames), compressNs / 1000.0 / frames,
+                decompressNs / 1000.0 / frames, static_cast<unsigned long long>(plainRecords),
+                ok ? "ok" : "MISMATCH");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t frames = argc > 1 ? static_cast<size_t>(std::max(100, std::atoi(argv[1]))) : 12000;
+    size_t threshold = argc > 2 ? static_cast<size_t>(std::atoi(argv[2])) : CompressionConfig().threshold;
+    Logger::getInstance().setDebugEnabled(false);
+
+    NameTable names;
+    std::vector<std::string> messages = buildStream(frames, 7, names);
+    uint64_t plainBytes = 0;
+    for (const std::string& message : messages) {
+        plainBytes += message.size();
+    }
+
+    // Dictionary from another match: different names, kills and money
+    std::string dictionary;
+    if (isCompressionCodecAvailable(CompressionCodec::ZSTD)) {
+        NameTable otherNames;
+        std::vector<std::string> samples = buildStream(4000, 1234, otherNames);
+        if (trainCompressionDictionary(samples.data(), samples.size(), kDictionarySize, dictionary)) {
+            std::printf("zstd dictionary: %zu bytes, id %u\n", dictionary.size(),
+                        getCompressionDictionaryId(dictionary));
+        }
+    }
+
+    std::printf("%zu frames at 20 Hz + pings, %.0f B/frame plain, threshold %zu bytes\n", frames,
+                static_cast<double>(plainBytes) / static_cast<double>(frames), threshold);
+    std::printf("%-28s %8s %15s %11s %11s %6s\n", "", "ratio", "on the wire", "compress", "decompress", "plain");
+
+    const Case cases[] = {
+        {"deflate 1", CompressionCodec::DEFLATE, 1, true, false},
+        {"deflate 6", CompressionCodec::DEFLATE, 6, true, false},
+        {"deflate 9", CompressionCodec::DEFLATE, 9, true, false},
+        {"deflate 6, no context", CompressionCodec::DEFLATE, 6, false, false},
+        {"zstd 1", CompressionCodec::ZSTD, 1, true, false},
+        {"zstd 3", CompressionCodec::ZSTD, 3, true, false},
+        {"zstd 3 + dictionary", CompressionCodec::ZSTD, 3, true, true},
+        {"zstd 3, no context", CompressionCodec::ZSTD, 3, false, false},
+        {"zstd 3 + dict, no context", CompressionCodec::ZSTD, 3, false, true},
+    };
+    for (const Case& c : cases) {
+        if (c.dictionary && dictionary.empty()) {
+            continue;
+        }
+        runCase(c, messages, frames, threshold, dictionary);
+    }
+    std::printf("times per frame; plain = records sent uncompressed (below the threshold)\n");
+    return 0;
+}
@@ -0,0 +1,248 @@
+// Per-frame allocation check of the capture -> encode -> send pipeline.
+// Captures synthetic game structures living in this process, encodes them
+// and sends them to a local TCP sink, counting global operator new calls.
+//
+// Usage: bench_frame_allocs [frames]
+
+#include "game_data_capture.h"
+#include "logger.h"
+#include "player_layout.h"
+#include "state_encoder.h"
+#include "websocket_client.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+std::atomic<uint64_t> g_allocations(0);
+
+} // namespace
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+using namespace CS16Capture;
+using Layout = Steam8684Layout;
+
+namespace {
+
+struct FakeBomb {
+    uint8_t planted;
+    uint8_t pad[3];
+    float timer;
+    uint8_t defused;
+};
+
+struct FakeRound {
+    int32_t number;
+    float time;
+};
+
+// Accepts one connection and discards everything it receives
+class Sink {
+public:
+    Sink() : listenSocket_(-1), port_(0), received_(0) {}
+
+    bool start() {
+        listenSocket_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenSocket_ < 0) {
+            return false;
+        }
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t length = sizeof(addr);
+        if (bind(listenSocket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            listen(listenSocket_, 1) < 0 ||
+            getsockname(listenSocket_, reinterpret_cast<sockaddr*>(&addr), &length) < 0) {
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+
+        thread_ = std::thread([this] {
+            int client = accept(listenSocket_, nullptr, nullptr);
+            char buffer[65536];
+            ssize_t count;
+            while (client >= 0 && (count = recv(client, buffer, sizeof(buffer), 0)) > 0) {
+                received_ += static_cast<uint64_t>(count);
+            }
+            if (client >= 0) {
+                close(client);
+            }
+        });
+        return true;
+    }
+
+    void stop() {
+        if (listenSocket_ >= 0) {
+            shutdown(listenSocket_, SHUT_RDWR);
+            close(listenSocket_);
+            listenSocket_ = -1;
+        }
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    int getPort() const { return port_; }
+    uint64_t getReceived() const { return received_; }
+
+private:
+    int listenSocket_;
+    int port_;
+    std::atomic<uint64_t> received_;
+    std::thread thread_;
+};
+
+void fillSpan(std::vector<uint8_t>& span) {
+    for (size_t slot = 0; slot < 20; ++slot) {
+        uint8_t* raw = span.data() + slot * Layout::kStructSize;
+        std::string name = "Player" + std::to_string(slot);
+        std::memcpy(raw + Layout::kNameOffset, name.c_str(), name.size());
+        int32_t values[] = { 0, 0, 0, 800, int32_t(slot % 2 + 1) };
+        std::memcpy(raw + Layout::kKillsOffset, values, sizeof(values));
+        raw[Layout::kAliveOffset] = 1;
+    }
+}
+
+// Changes a few fields like a running match would
+void advance(std::vector<uint8_t>& span, FakeBomb& bomb, FakeRound& round, size_t frame) {
+    uint8_t* raw = span.data() + (frame % 20) * Layout::kStructSize;
+    int32_t money = 0;
+    std::memcpy(&money, raw + Layout::kMoneyOffset, sizeof(money));
+    money = (money + 300) % 16000;
+    std::memcpy(raw + Layout::kMoneyOffset, &money, sizeof(money));
+
+    round.time -= 0.1f;
+    if (round.time <= 0.0f) {
+        round.time = 115.0f;
+        ++round.number;
+    }
+    bomb.planted = (frame / 50) % 2;
+    bomb.timer = bomb.planted ? 35.0f - static_cast<float>(frame % 50) * 0.1f : 0.0f;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t frames = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    // Long enough for every send queue slot to have held a frame buffer
+    const size_t warmupFrames = 1000;
+    Logger::getInstance().setDebugEnabled(false);
+
+    std::vector<uint8_t> span(Layout::kStructSize * Layout::kMaxPlayers, 0);
+    FakeBomb bomb{};
+    FakeRound round{1, 115.0f};
+    fillSpan(span);
+
+    MemoryOffsets offsets;
+    offsets.playerListBase = reinterpret_cast<uintptr_t>(span.data());
+    offsets.bombBase = reinterpret_cast<uintptr_t>(&bomb);
+    offsets.gameStateBase = reinterpret_cast<uintptr_t>(&round);
+    offsets.playerStructSize = Layout::kStructSize;
+    offsets.maxPlayers = Layout::kMaxPlayers;
+    offsets.playerNameOffset = Layout::kNameOffset;
+    offsets.playerKillsOffset = Layout::kKillsOffset;
+    offsets.playerDeathsOffset = Layout::kDeathsOffset;
+    offsets.playerAssistsOffset = Layout::kAssistsOffset;
+    offsets.playerMoneyOffset = Layout::kMoneyOffset;
+    offsets.playerTeamOffset = Layout::kTeamOffset;
+    offsets.playerAliveOffset = Layout::kAliveOffset;
+    offsets.bombPlantedOffset = offsetof(FakeBomb, planted);
+    offsets.bombTimerOffset = offsetof(FakeBomb, timer);
+    offsets.bombDefusedOffset = offsetof(FakeBomb, defused);
+    offsets.roundNumberOffset = offsetof(FakeRound, number);
+    offsets.roundTimeOffset = offsetof(FakeRound, time);
+
+    GameDataCapture capture;
+    if (!capture.initialize(0, offsets)) {
+        std::fprintf(stderr, "capture initialization failed\n");
+        return 1;
+    }
+
+    Sink sink;
+    WebSocketClient client;
+    client.setAutoReconnect(false);
+    if (!sink.start() || !client.connect("127.0.0.1", sink.getPort())) {
+        std::fprintf(stderr, "local sink unavailable\n");
+        return 1;
+    }
+
+    GameState state;
+    StateEncoder encoder;
+    uint64_t warmupAllocations = 0;
+    uint64_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t frame = 0; frame < warmupFrames + frames; ++frame) {
+        if (frame == warmupFrames) {
+            warmupAllocations = g_allocations.load();
+            start = std::chrono::steady_clock::now();
+        }
+
+        advance(span, bomb, round, frame);
+        if (!capture.captureGameState(state)) {
+            std::fprintf(stderr, "capture failed at frame %zu\n", frame);
+            return 1;
+        }
+
+        std::string buffer = client.acquireBuffer();
+        encoder.encode(state, client.getConnectionGeneration(), buffer);
+        bytes += buffer.size();
+        client.sendMessage(std::move(buffer));
+
+        // Pace like a fast capture loop so the send thread keeps up
+        if (frame % 16 == 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    uint64_t allocations = g_allocations.load() - warmupAllocations;
+    double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    // Let the queue drain before tearing down
+    while (client.getPendingMessageCount() > 0 && client.isConnected()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    uint64_t dropped = client.getDroppedMessageCount();
+    client.disconnect();
+    sink.stop();
+
+    std::printf("%zu frames, %zu players, %.0f bytes/frame, %.2f us/frame\n",
+                frames, state.players.count(), static_cast<double>(bytes) / static_cast<double>(warmupFrames + frames),
+                elapsed / static_cast<double>(frames));
+    std::printf("allocations after warm-up: %llu (%.3f per frame), dropped frames: %llu, received: %llu bytes\n",
+                static_cast<unsigned long long>(allocations),
+                static_cast<double>(allocations) / static_cast<double>(frames),
+                static_cast<unsigned long long>(dropped),
+                static_cast<unsigned long long>(sink.getReceived()));
+
+    return allocations == 0 ? 0 : 1;
+}
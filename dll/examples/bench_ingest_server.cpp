@@ -0,0 +1,339 @@
+// Ingest server load test, in two parts.
+//
+// Scale: a forked load generator opens thousands of connections to an
+// IngestServer and sends collector frames on each at a fixed rate, like as
+// many collectors would. A frame that finds its socket full is dropped, as
+// WebSocketClient drops from a full queue, and still uses up its "seq", so
+// the gaps the server counts must equal the drops of the generator. The
+// generator runs in its own process because the connections take a
+// descriptor on both ends.
+//
+// Backpressure: real WebSocketClients send frames to a server that reads
+// half of the connections slowly and forces disconnects now and then. Slow
+// connections show a growing frame age (the kernel socket buffers absorb a
+// minute or more of frames before the client queue fills and drops), the
+// others none, and every client must reconnect after a forced disconnect.
+//
+// Usage: bench_ingest_server [connections] [frames/s per connection] [seconds] [clients]
+
+#include "ingest_server.h"
+#include "latency_tracker.h"
+#include "logger.h"
+#include "state_encoder.h"
+#include "websocket_client.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace CS16Capture;
+
+namespace {
+
+struct GeneratorResult {
+    uint64_t connected;
+    uint64_t failed;
+    uint64_t sent;
+    uint64_t dropped;
+    uint64_t bytes;
+};
+
+void raiseFileLimit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+GameState makeState(size_t players, NameTable& names) {
+    GameState state;
+    state.nameTable = &names;
+    for (size_t slot = 0; slot < players; ++slot) {
+        char name[24];
+        std::snprintf(name, sizeof(name), "Player%zu", slot + 1);
+        state.players.setPresent(slot, name, sizeof(name));
+        state.players.nameIds[slot] = names.internSlot(slot, name, sizeof(name));
+        state.players.kills[slot] = static_cast<int32_t>(slot);
+        state.players.money[slot] = 800 + static_cast<int32_t>(slot) * 100;
+        state.players.team[slot] = slot % 2 == 0 ? 1 : 2;
+        state.players.alive[slot] = 1;
+    }
+    state.roundNumber = 3;
+    state.roundTime = 87.5f;
+    return state;
+}
+
+// Everything of an encoded frame after "captureTime", which the generator rewrites
+std::string frameTail() {
+    NameTable names;
+    GameState state = makeState(10, names);
+    state.captureTimeNs = 1000;
+    StateEncoder encoder;
+    std::string frame;
+    encoder.encode(state, 1, frame);
+    size_t key = frame.find("\"captureTime\":");
+    size_t tail = frame.find(',', key);
+    return frame.substr(tail);
+}
+
+GeneratorResult runGenerator(int port, size_t connections, double rate, double seconds) {
+    raiseFileLimit();
+    GeneratorResult result = {0, 0, 0, 0, 0};
+
+    struct Peer {
+        int fd;
+        uint64_t seq;
+        uint64_t nextSendUs;
+        std::string pending;  // Rest of a partially written frame
+    };
+    std::vector<Peer> peers;
+    peers.reserve(connections);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    for (size_t i = 0; i < connections; ++i) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            ++result.failed;
+            if (fd >= 0) {
+                close(fd);
+            }
+            continue;
+        }
+        peers.push_back({fd, 0, 0, std::string()});
+    }
+    result.connected = peers.size();
+    if (peers.empty()) {
+        return result;
+    }
+
+    // Staggered so the frames of all connections are spread over the period
+    const uint64_t periodUs = static_cast<uint64_t>(1e6 / rate);
+    const uint64_t startUs = monotonicMicros();
+    const uint64_t endUs = startUs + static_cast<uint64_t>(seconds * 1e6);
+    for (size_t i = 0; i < peers.size(); ++i) {
+        peers[i].nextSendUs = startUs + periodUs * i / peers.size();
+    }
+
+    const std::string tail = frameTail();
+    std::string frame;
+    size_t next = 0;
+    for (;;) {
+        uint64_t nowUs = monotonicMicros();
+        if (nowUs >= endUs) {
+            break;
+        }
+        size_t sentNow = 0;
+        while (peers[next].nextSendUs <= nowUs && sentNow < peers.size()) {
+            Peer& peer = peers[next];
+            peer.nextSendUs += periodUs;
+            ++peer.seq;
+            ++sentNow;
+            next = (next + 1) % peers.size();
+
+            if (!peer.pending.empty()) {
+                ssize_t written = send(peer.fd, peer.pending.data(), peer.pending.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+                if (written > 0) {
+                    peer.pending.erase(0, static_cast<size_t>(written));
+                }
+                if (!peer.pending.empty()) {
+                    ++result.dropped;
+                    continue;
+                }
+            }
+
+            frame.assign("{\"instance\":");
+            frame.append(std::to_string(peer.fd));
+            frame.append(",\"seq\":");
+            frame.append(std::to_string(peer.seq));
+            frame.append(",\"captureTime\":");
+            frame.append(std::to_string(monotonicMicros()));
+            frame.append(tail);
+            ssize_t written = send(peer.fd, frame.data(), frame.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (written < 0) {
+                ++result.dropped;
+                continue;
+            }
+            if (static_cast<size_t>(written) < frame.size()) {
+                peer.pending.assign(frame, static_cast<size_t>(written), std::string::npos);
+            }
+            ++result.sent;
+            result.bytes += frame.size();
+        }
+        if (sentNow == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+    }
+
+    // Let partial frames finish so they are not counted as gaps
+    for (Peer& peer : peers) {
+        for (int attempt = 0; attempt < 100 && !peer.pending.empty(); ++attempt) {
+            ssize_t written = send(peer.fd, peer.pending.data(), peer.pending.size(), MSG_NOSIGNAL);
+            if (written <= 0) {
+                break;
+            }
+            peer.pending.erase(0, static_cast<size_t>(written));
+        }
+        close(peer.fd);
+    }
+    return result;
+}
+
+void runScale(size_t connections, double rate, double seconds) {
+    IngestServerConfig config;
+    config.port = 0;
+    IngestServer server(config);
+    if (!server.start()) {
+        return;
+    }
+
+    int channel[2];
+    if (pipe(channel) != 0) {
+        return;
+    }
+    pid_t child = fork();
+    if (child == 0) {
+        close(channel[0]);
+        GeneratorResult result = runGenerator(server.getPort(), connections, rate, seconds);
+        ssize_t written = write(channel[1], &result, sizeof(result));
+        _exit(written == static_cast<ssize_t>(sizeof(result)) ? 0 : 1);
+    }
+    close(channel[1]);
+
+    // Peak connection count, sampled while the generator runs
+    size_t peak = 0;
+    GeneratorResult result = {0, 0, 0, 0, 0};
+    ssize_t received = 0;
+    for (;;) {
+        int status = 0;
+        if (waitpid(child, &status, WNOHANG) == child) {
+            break;
+        }
+        peak = std::max(peak, server.getStats().connections);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    received = read(channel[0], &result, sizeof(result));
+    close(channel[0]);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    IngestServerStats stats = server.getStats();
+    server.stop();
+    if (received != static_cast<ssize_t>(sizeof(result))) {
+        std::printf("scale: generator failed\n");
+        return;
+    }
+    std::printf("scale: %llu connections (%llu failed), peak %zu open at the server\n",
+                static_cast<unsigned long long>(result.connected), static_cast<unsigned long long>(result.failed),
+                peak);
+    std::printf("  sent %llu frames (%.0f/s, %.1f MB/s), dropped on full sockets %llu\n",
+                static_cast<unsigned long long>(result.sent), static_cast<double>(result.sent) / seconds,
+                static_cast<double>(result.bytes) / seconds / 1e6, static_cast<unsigned long long>(result.dropped));
+    std::printf("  received %llu frames, gaps %llu (%s), malformed %llu | age p50 %.0f us, p99 %.0f us, max %llu us\n",
+                static_cast<unsigned long long>(stats.frames), static_cast<unsigned long long>(stats.gaps),
+                stats.gaps == result.dropped && stats.frames == result.sent ? "match" : "MISMATCH",
+                static_cast<unsigned long long>(stats.malformed), stats.latency.percentile(0.5),
+                stats.latency.percentile(0.99), static_cast<unsigned long long>(stats.latency.maxUs));
+}
+
+void runBackpressure(size_t clients, double seconds) {
+    IngestServerConfig config;
+    config.port = 0;
+    config.slowReadFraction = 0.5;
+    config.slowReadBytesPerSecond = 4 * 1024;
+    config.disconnectAfterMs = static_cast<uint32_t>(seconds * 1000.0);
+    IngestServer server(config);
+    if (!server.start()) {
+        return;
+    }
+
+    std::vector<std::unique_ptr<WebSocketClient>> senders;
+    for (size_t i = 0; i < clients; ++i) {
+        auto client = std::make_unique<WebSocketClient>();
+        client->setAutoReconnect(true);
+        if (client->connect("127.0.0.1", server.getPort())) {
+            senders.push_back(std::move(client));
+        }
+    }
+
+    // 20 players at 50 frames/s: about 90 KB/s per client, one thread each.
+    // Frames sent while a client reconnects in the background are refused
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    std::vector<std::thread> threads;
+    for (auto& client : senders) {
+        WebSocketClient* sender = client.get();
+        threads.emplace_back([sender, end]() {
+            NameTable names;
+            GameState state = makeState(20, names);
+            auto next = std::chrono::steady_clock::now();
+            while (next < end) {
+                state.captureTimeNs = monotonicMicros() * 1000;
+                sender->sendGameState(state);
+                next += std::chrono::milliseconds(20);
+                std::this_thread::sleep_until(next);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<IngestConnectionStats> connections = server.getConnectionStats();
+    IngestServerStats stats = server.getStats();
+    std::printf("backpressure: %zu clients, half read at %zu B/s, forced disconnects every %u ms on average\n",
+                senders.size(), config.slowReadBytesPerSecond, config.disconnectAfterMs);
+    for (const IngestConnectionStats& c : connections) {
+        std::printf("  #%-3llu%s %5.1f s | %6.1f frames/s %8.0f B/s | gaps %5llu, client dropped %5llu | "
+                    "age p50 %8.0f us, p99 %8.0f us\n",
+                    static_cast<unsigned long long>(c.id), c.slowRead ? " slow" : "     ", c.connectedSeconds,
+                    c.framesPerSecond, c.bytesPerSecond, static_cast<unsigned long long>(c.gaps),
+                    static_cast<unsigned long long>(c.clientDropped), c.p50Us, c.p99Us);
+    }
+    uint64_t dropped = 0;
+    uint64_t reconnects = 0;
+    for (auto& client : senders) {
+        dropped += client->getDroppedMessageCount();
+        reconnects += client->getConnectionGeneration() - 1;
+    }
+    std::printf("  clients dropped %llu frames, reconnected %llu times; server saw %llu forced disconnects, "
+                "%llu pongs\n",
+                static_cast<unsigned long long>(dropped), static_cast<unsigned long long>(reconnects),
+                static_cast<unsigned long long>(stats.injectedDisconnects),
+                static_cast<unsigned long long>(stats.pongs));
+
+    for (auto& client : senders) {
+        client->disconnect();
+    }
+    server.stop();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t connections = argc > 1 ? static_cast<size_t>(std::max(1, std::atoi(argv[1]))) : 10000;
+    double rate = argc > 2 ? std::max(0.1, std::atof(argv[2])) : 2.0;
+    double seconds = argc > 3 ? std::max(1.0, std::atof(argv[3])) : 10.0;
+    size_t clients = argc > 4 ? static_cast<size_t>(std::max(0, std::atoi(argv[4]))) : 8;
+    Logger::getInstance().setDebugEnabled(false);
+    raiseFileLimit();
+
+    runScale(connections, rate, seconds);
+    if (clients > 0) {
+        runBackpressure(clients, seconds);
+    }
+    return 0;
+}
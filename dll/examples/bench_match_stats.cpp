@@ -0,0 +1,250 @@
+// Match statistics benchmark: replays a generated match through MatchStats
+// at a fixed capture rate and measures the cost of update() per captured
+// frame and of encoding the summary line.
+//
+// Ten players play rounds that end either by elimination or after a plant
+// (defused or exploded); players buy at the start of a round and earn money
+// for kills and round results. Most frames change nothing but the timer,
+// which is what a capture stream mostly looks like. The script knows who
+// won each round, so the winners MatchStats derived are checked against it.
+//
+// Usage: bench_match_stats [rounds] [passes]
+
+#include "match_stats.h"
+#include "logger.h"
+#include "name_table.h"
+#include "state_encoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace CS16Capture;
+
+namespace {
+
+const int64_t kFrameMs = 50;
+const int64_t kFreezeMs = 5000;
+const int64_t kRoundEndDelayMs = 5000;
+const size_t kPlayers = 10;         // Slots 0-4 are terrorists, 5-9 counter-terrorists
+
+enum class Action { BUY, KILL, PLANT, DEFUSE };
+
+struct Step {
+    int64_t atMs;       // From round start
+    Action action;
+    int slot;           // Buyer, killer or defuser
+    int victim;
+    int32_t amount;     // Money spent by a purchase
+};
+
+struct Round {
+    std::vector<Step> steps;
+    int64_t lengthMs;
+    RoundWinner winner;
+};
+
+uint32_t nextRandom(uint32_t& seed) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+// Purchases are decided when the rounds are replayed, from the money players have
+std::vector<Round> buildMatch(int rounds) {
+    std::vector<Round> match;
+    uint32_t seed = 12345;
+    for (int r = 0; r < rounds; ++r) {
+        Round round;
+        bool terroristsWin = nextRandom(seed) % 2 == 0;
+        bool plant = nextRandom(seed) % 3 == 0;
+        int64_t now = kFreezeMs;
+        for (int slot = 0; slot < static_cast<int>(kPlayers); ++slot) {
+            round.steps.push_back({now - 4000 + slot * 300, Action::BUY, slot, 0, 0});
+        }
+
+        bool alive[kPlayers];
+        std::fill(alive, alive + kPlayers, true);
+        auto pick = [&](bool terrorists) {
+            std::vector<int> candidates;
+            for (int slot = terrorists ? 0 : 5; slot < (terrorists ? 5 : 10); ++slot) {
+                if (alive[slot]) {
+                    candidates.push_back(slot);
+                }
+            }
+            return candidates.empty() ? -1 : candidates[nextRandom(seed) % candidates.size()];
+        };
+        auto kill = [&](bool victimTerrorist) {
+            int victim = pick(victimTerrorist);
+            int killer = pick(!victimTerrorist);
+            if (victim < 0 || killer < 0) {
+                return false;
+            }
+            now += 2000 + static_cast<int64_t>(nextRandom(seed) % 8000);
+            alive[victim] = false;
+            round.steps.push_back({now, Action::KILL, killer, victim, 0});
+            return true;
+        };
+
+        if (plant) {
+            // Two trades, the plant, a few more deaths, then the defuse or the explosion
+            kill(true);
+            kill(false);
+            now += 5000;
+            round.steps.push_back({now, Action::PLANT, pick(true), 0, 0});
+            kill(!terroristsWin);
+            kill(terroristsWin);
+            if (terroristsWin) {
+                now += 35000;
+            } else {
+                now += 6000;
+                round.steps.push_back({now, Action::DEFUSE, pick(false), 0, 0});
+            }
+        } else {
+            // The losing side dies; the winners lose a player now and then, never the last
+            while (kill(!terroristsWin)) {
+                if (pick(!terroristsWin) >= 0 && nextRandom(seed) % 3 == 0) {
+                    kill(terroristsWin);
+                }
+            }
+        }
+        round.lengthMs = now;
+        round.winner = terroristsWin ? RoundWinner::TERRORISTS : RoundWinner::COUNTER_TERRORISTS;
+        match.push_back(round);
+    }
+    return match;
+}
+
+struct Replay {
+    uint64_t frames;
+    uint64_t changedFrames;
+    double seconds;
+    std::vector<RoundWinner> derived;
+};
+
+// Replays the match; with stats == nullptr it measures only the state updates
+Replay replay(const std::vector<Round>& match, MatchStats* stats, NameTable& names) {
+    Replay result = {0, 0, 0.0, {}};
+    GameState state;
+    state.nameTable = &names;
+    for (size_t slot = 0; slot < kPlayers; ++slot) {
+        char name[16];
+        std::snprintf(name, sizeof(name), "Player%zu", slot + 1);
+        state.players.setPresent(slot, name, sizeof(name));
+        state.players.nameIds[slot] = names.internSlot(slot, name, sizeof(name));
+        state.players.team[slot] = slot < 5 ? 1 : 2;
+        state.players.money[slot] = 800;
+    }
+
+    uint64_t finished = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < match.size(); ++r) {
+        const Round& round = match[r];
+        state.roundNumber = static_cast<int32_t>(r + 1);
+        state.bomb = BombData();
+        for (size_t slot = 0; slot < kPlayers; ++slot) {
+            state.players.alive[slot] = 1;
+        }
+
+        size_t next = 0;
+        for (int64_t now = 0; now < round.lengthMs + kRoundEndDelayMs; now += kFrameMs) {
+            bool changed = false;
+            for (; next < round.steps.size() && round.steps[next].atMs <= now; ++next) {
+                const Step& step = round.steps[next];
+                PlayerTable& players = state.players;
+                changed = true;
+                switch (step.action) {
+                    case Action::BUY: {
+                        int32_t money = players.money[step.slot];
+                        int32_t spend = money >= 4700 ? 4700 : money >= 2500 ? 2500 : std::min(money, 650);
+                        players.money[step.slot] -= spend;
+                        break;
+                    }
+                    case Action::KILL:
+                        ++players.kills[step.slot];
+                        ++players.deaths[step.victim];
+                        players.alive[step.victim] = 0;
+                        players.money[step.slot] = std::min(players.money[step.slot] + 300, 16000);
+                        break;
+                    case Action::PLANT: state.bomb.planted = true; break;
+                    case Action::DEFUSE: state.bomb.defused = true; break;
+                }
+            }
+            state.roundTime = static_cast<float>(std::max<int64_t>(round.lengthMs - now, 0)) / 1000.0f;
+            state.captureTimeNs = static_cast<uint64_t>(now + 1) * 1000000;
+            ++result.frames;
+            result.changedFrames += changed ? 1 : 0;
+            if (stats != nullptr) {
+                stats->update(state);
+            }
+        }
+
+        // Round rewards show up with the next round
+        for (size_t slot = 0; slot < kPlayers; ++slot) {
+            bool won = (slot < 5) == (round.winner == RoundWinner::TERRORISTS);
+            state.players.money[slot] = std::min(state.players.money[slot] + (won ? 3250 : 1400), 16000);
+        }
+        if (stats != nullptr && stats->getFinishedRounds() != finished) {
+            finished = stats->getFinishedRounds();
+            result.derived.push_back(stats->getRound(stats->getRoundCount() - 1).winner);
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int rounds = argc > 1 ? std::max(2, std::atoi(argv[1])) : 30;
+    int passes = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+    Logger::getInstance().setDebugEnabled(false);
+
+    // The first round is not recorded (its start is not seen) and the last
+    // one is finished by the round change of the next
+    std::vector<Round> match = buildMatch(rounds + 2);
+    NameTable names;
+
+    double baseline = 1e9;
+    double withStats = 1e9;
+    Replay last = {0, 0, 0.0, {}};
+    for (int pass = 0; pass < passes; ++pass) {
+        baseline = std::min(baseline, replay(match, nullptr, names).seconds);
+        MatchStats stats;
+        last = replay(match, &stats, names);
+        withStats = std::min(withStats, last.seconds);
+    }
+
+    MatchStats stats;
+    replay(match, &stats, names);
+    size_t wrong = 0;
+    for (size_t r = 0; r < last.derived.size(); ++r) {
+        wrong += last.derived[r] != match[r + 1].winner ? 1 : 0;
+    }
+
+    StateEncoder encoder(1);
+    std::string line;
+    const int encodes = 1000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < encodes; ++i) {
+        encoder.resync();
+        encoder.encodeStats(stats, &names, static_cast<uint64_t>(i + 1), line, 0);
+    }
+    double encodeUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() /
+                      encodes;
+
+    double perFrameNs = (withStats - baseline) * 1e9 / static_cast<double>(last.frames);
+    std::printf("%d rounds, %llu frames at %lld ms (%llu with changes)\n", rounds,
+                static_cast<unsigned long long>(last.frames), static_cast<long long>(kFrameMs),
+                static_cast<unsigned long long>(last.changedFrames));
+    std::printf("update: %.1f ns per frame (replay %.2f ms, with stats %.2f ms)\n", perFrameNs,
+                baseline * 1e3, withStats * 1e3);
+    std::printf("rounds recorded %zu, winners wrong %zu, score %d:%d\n", last.derived.size(), wrong,
+                stats.getRoundWins(RoundWinner::TERRORISTS), stats.getRoundWins(RoundWinner::COUNTER_TERRORISTS));
+    std::printf("summary: %zu bytes, %.1f us to encode\n", line.size(), encodeUs);
+    if (argc > 3) {
+        std::fputs(line.c_str(), stdout);
+    }
+    return wrong == 0 ? 0 : 1;
+}
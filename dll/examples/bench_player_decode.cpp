@@ -0,0 +1,110 @@
+// Player decode benchmark: per-field remote reads vs. one span read decoded
+// with the runtime offsets vs. the compile-time Steam8684Layout.
+//
+// Usage: bench_player_decode [iterations]
+
+#include "game_types.h"
+#include "memory_reader.h"
+#include "player_layout.h"
+#include "logger.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace CS16Capture;
+using Layout = Steam8684Layout;
+
+namespace {
+
+MemoryOffsets layoutOffsets() {
+    MemoryOffsets offsets;
+    offsets.playerStructSize = Layout::kStructSize;
+    offsets.maxPlayers = Layout::kMaxPlayers;
+    offsets.playerNameOffset = Layout::kNameOffset;
+    offsets.playerKillsOffset = Layout::kKillsOffset;
+    offsets.playerDeathsOffset = Layout::kDeathsOffset;
+    offsets.playerAssistsOffset = Layout::kAssistsOffset;
+    offsets.playerMoneyOffset = Layout::kMoneyOffset;
+    offsets.playerTeamOffset = Layout::kTeamOffset;
+    offsets.playerAliveOffset = Layout::kAliveOffset;
+    return offsets;
+}
+
+// 20 of 32 slots occupied, like a busy public server
+std::vector<uint8_t> makeSpan(size_t& playerCount) {
+    std::vector<uint8_t> span(Layout::kStructSize * Layout::kMaxPlayers, 0);
+    playerCount = 0;
+    for (size_t slot = 0; slot < Layout::kMaxPlayers; slot += (slot % 3 == 2) ? 2 : 1) {
+        uint8_t* raw = span.data() + slot * Layout::kStructSize;
+        std::string name = "Player" + std::to_string(slot);
+        std::memcpy(raw + Layout::kNameOffset, name.c_str(), name.size());
+        int32_t values[] = { int32_t(slot), 3, 1, 800 + int32_t(slot) * 100, int32_t(slot % 2 + 1) };
+        std::memcpy(raw + Layout::kKillsOffset, values, sizeof(values));
+        raw[Layout::kAliveOffset] = 1;
+        ++playerCount;
+    }
+    return span;
+}
+
+template<typename Func>
+double measure(const char* label, size_t iterations, size_t playerCount, Func func) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        func();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    double perPlayer = elapsed / static_cast<double>(iterations * playerCount);
+    std::printf("%-28s %10.1f ns/player\n", label, perPlayer);
+    return perPlayer;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    Logger::getInstance().setDebugEnabled(false);
+
+    size_t playerCount = 0;
+    std::vector<uint8_t> span = makeSpan(playerCount);
+    MemoryOffsets offsets = layoutOffsets();
+    PlayerTable players;
+    NameTable names;
+
+    std::printf("%zu players, %zu iterations\n", playerCount, iterations);
+
+    double runtime = measure("runtime MemoryOffsets", iterations, playerCount, [&] {
+        decodePlayersRuntime(offsets, span.data(), names, players);
+    });
+    double specialized = measure("compile-time layout", iterations, playerCount, [&] {
+        decodePlayers<Layout>(offsets, span.data(), names, players);
+    });
+    std::printf("speedup: %.2fx\n", runtime / specialized);
+
+    // Old capture path for reference: one remote read per field
+    MemoryReader reader;
+    if (reader.initialize()) {
+        uintptr_t base = reinterpret_cast<uintptr_t>(span.data());
+        size_t fieldIterations = iterations / 100 + 1;
+        measure("per-field reads (syscalls)", fieldIterations, playerCount, [&] {
+            players.clear();
+            for (size_t slot = 0; slot < offsets.maxPlayers; ++slot) {
+                uintptr_t address = base + slot * offsets.playerStructSize;
+                std::string name = reader.readString(address + offsets.playerNameOffset, 32);
+                if (name.empty()) {
+                    continue;
+                }
+                players.setPresent(slot, name.c_str(), name.size());
+                reader.readMemory(address + offsets.playerKillsOffset, players.kills[slot]);
+                reader.readMemory(address + offsets.playerDeathsOffset, players.deaths[slot]);
+                reader.readMemory(address + offsets.playerAssistsOffset, players.assists[slot]);
+                reader.readMemory(address + offsets.playerMoneyOffset, players.money[slot]);
+                reader.readMemory(address + offsets.playerTeamOffset, players.team[slot]);
+                reader.readMemory(address + offsets.playerAliveOffset, players.alive[slot]);
+            }
+        });
+    }
+
+    return players.count() == playerCount ? 0 : 1;
+}
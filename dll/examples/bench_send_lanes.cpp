@@ -0,0 +1,244 @@
+// Send lane benchmark: replays the output of several capture instances
+// through the send queue onto a simulated link that is congested for a
+// while, and compares one FIFO queue (what WebSocketClient had before the
+// lanes) with strict and weighted lanes.
+//
+// Every instance encodes a 20-player frame every 50 ms with a real
+// StateEncoder, now and then with a kill event, and a match summary every
+// ten seconds. The link sends one message at a time at a fixed byte rate,
+// which drops well below the offered load in the middle third of the run.
+// Reported delays are from queueing to the end of the write on the link, in
+// simulated time; frames of each instance must leave in "seq" order.
+//
+// Usage: bench_send_lanes [instances] [seconds] [congested KB/s]
+
+#include "logger.h"
+#include "name_table.h"
+#include "send_lanes.h"
+#include "state_encoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace CS16Capture;
+
+namespace {
+
+const uint64_t kStepUs = 1000;
+const uint64_t kFrameIntervalUs = 50000;
+const uint64_t kStatsIntervalUs = 10000000;
+const uint32_t kEventOneIn = 40;           // Frames per kill event, on average
+const double kClearBytesPerSecond = 2e6;
+const size_t kStatsBytes = 4096;
+
+enum class Mode { FIFO, STRICT, WEIGHTED };
+
+const char* modeName(Mode mode) {
+    switch (mode) {
+        case Mode::FIFO: return "fifo";
+        case Mode::STRICT: return "strict";
+        case Mode::WEIGHTED: return "weighted";
+    }
+    return "";
+}
+
+uint32_t nextRandom(uint32_t& seed) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+struct Delays {
+    std::vector<double> ms;
+
+    void add(uint64_t us) { ms.push_back(static_cast<double>(us) / 1000.0); }
+
+    double percentile(double fraction) {
+        if (ms.empty()) {
+            return 0.0;
+        }
+        size_t index = static_cast<size_t>(fraction * static_cast<double>(ms.size() - 1));
+        std::nth_element(ms.begin(), ms.begin() + static_cast<std::ptrdiff_t>(index), ms.end());
+        return ms[index];
+    }
+};
+
+struct Result {
+    Delays events;
+    Delays state;
+    Delays stats;
+    uint64_t dropped;
+    uint64_t superseded;
+    uint64_t refused;      // Event frames taken back by their encoder
+    uint64_t outOfOrder;
+    uint64_t sentBytes;
+    double queueNs;        // Wall time of push + pop per message
+};
+
+// Reads the number following key in a frame, 0 if missing
+uint64_t readNumber(const std::string& frame, const char* key) {
+    size_t at = frame.find(key);
+    return at == std::string::npos ? 0 : std::strtoull(frame.c_str() + at + std::strlen(key), nullptr, 10);
+}
+
+Result run(Mode mode, size_t instances, double seconds, double congestedBytesPerSecond) {
+    SendLaneConfig config;
+    if (mode == Mode::FIFO) {
+        config.capacity[static_cast<size_t>(SendLane::STATE)] = 256;
+    }
+    config.scheduling = mode == Mode::WEIGHTED ? LaneScheduling::WEIGHTED : LaneScheduling::STRICT;
+    SendLanes lanes(config);
+
+    NameTable names;
+    std::vector<StateEncoder> encoders;
+    std::vector<GameState> states(instances);
+    for (size_t i = 0; i < instances; ++i) {
+        encoders.emplace_back(static_cast<int64_t>(i + 1));
+        GameState& state = states[i];
+        state.nameTable = &names;
+        for (size_t slot = 0; slot < 20; ++slot) {
+            char name[48];  // "Player" and two size_t values
+            std::snprintf(name, sizeof(name), "Player%zu_%zu", i, slot);
+            state.players.setPresent(slot, name, sizeof(name));
+            state.players.nameIds[slot] = names.internSlot(slot, name, sizeof(name));
+            state.players.team[slot] = static_cast<int32_t>(slot % 2 + 1);
+            state.players.alive[slot] = 1;
+        }
+    }
+
+    Result result = {{}, {}, {}, 0, 0, 0, 0, 0, 0.0};
+    std::vector<uint64_t> lastSeq(instances, 0);
+    std::string message;
+    std::string stats;
+    uint32_t seed = 99;
+    uint64_t queueOps = 0;
+    std::chrono::steady_clock::duration queueTime(0);
+
+    // The message on the link and when its write completes
+    std::string onLink;
+    uint64_t onLinkCaptureUs = 0;
+    SendLane onLinkLane = SendLane::STATE;
+    double linkFreeUs = 0.0;
+    bool linkBusy = false;
+
+    const uint64_t endUs = static_cast<uint64_t>(seconds * 1e6);
+    for (uint64_t nowUs = 0; nowUs < endUs; nowUs += kStepUs) {
+        bool congested = nowUs >= endUs / 3 && nowUs < endUs * 2 / 3;
+        double bytesPerUs = (congested ? congestedBytesPerSecond : kClearBytesPerSecond) / 1e6;
+
+        for (size_t i = 0; i < instances; ++i) {
+            // Instances are spread evenly over the frame interval
+            uint64_t phaseUs = kFrameIntervalUs * i / instances;
+            if (nowUs % kFrameIntervalUs != phaseUs - phaseUs % kStepUs) {
+                continue;
+            }
+
+            GameState& state = states[i];
+            state.events.clear();
+            state.captureTimeNs = (nowUs + 1) * 1000;
+            state.roundTime = static_cast<float>(endUs - nowUs) / 1e6f;
+            for (size_t slot = 0; slot < 20; ++slot) {
+                state.players.money[slot] = static_cast<int32_t>((nowUs / 1000 + slot * 37) % 16000);
+            }
+            if (nextRandom(seed) % kEventOneIn == 0) {
+                state.events.push_back(GameEvent::PLAYER_KILLED);
+                ++state.players.kills[nextRandom(seed) % 20];
+            }
+
+            encoders[i].encode(state, 1, message, state.captureTimeNs);
+            SendLane lane = encoders[i].isFrameReplaceable() ? SendLane::STATE : SendLane::EVENTS;
+            auto start = std::chrono::steady_clock::now();
+            if (mode == Mode::FIFO) {
+                lanes.push(SendLane::STATE, message, state.captureTimeNs, 0, 0);
+            } else if (!lanes.push(lane, message, state.captureTimeNs, i + 1, encoders[i].getFrameTopics())) {
+                encoders[i].discardFrame();
+            }
+            queueTime += std::chrono::steady_clock::now() - start;
+            ++queueOps;
+
+            if (nowUs % kStatsIntervalUs == phaseUs - phaseUs % kStepUs) {
+                stats.assign(kStatsBytes - 1, ' ');
+                stats.insert(0, "{\"type\":\"stats\"}");
+                stats.resize(kStatsBytes - 1);
+                stats.push_back('\n');
+                lanes.push(mode == Mode::FIFO ? SendLane::STATE : SendLane::STATS, stats, state.captureTimeNs, 0,
+                           0);
+            }
+        }
+
+        // Finish the write on the link, then start the next one
+        while (true) {
+            if (linkBusy) {
+                if (linkFreeUs > static_cast<double>(nowUs + kStepUs)) {
+                    break;
+                }
+                uint64_t delayUs = static_cast<uint64_t>(linkFreeUs) - onLinkCaptureUs;
+                if (onLink.compare(0, 16, "{\"type\":\"stats\"}") == 0) {
+                    result.stats.add(delayUs);
+                } else {
+                    if (onLink.find("\"events\":[\"") != std::string::npos) {
+                        result.events.add(delayUs);
+                    } else {
+                        result.state.add(delayUs);
+                    }
+                    size_t instance = readNumber(onLink, "\"instance\":") - 1;
+                    uint64_t seq = readNumber(onLink, "\"seq\":");
+                    result.outOfOrder += seq <= lastSeq[instance] ? 1 : 0;
+                    lastSeq[instance] = seq;
+                }
+                result.sentBytes += onLink.size();
+                linkBusy = false;
+            }
+
+            uint64_t captureNs = 0;
+            auto start = std::chrono::steady_clock::now();
+            bool popped = lanes.pop(onLink, captureNs, onLinkLane);
+            queueTime += std::chrono::steady_clock::now() - start;
+            if (!popped) {
+                break;
+            }
+            onLinkCaptureUs = captureNs / 1000 - 1;
+            linkFreeUs = std::max(linkFreeUs, static_cast<double>(nowUs)) +
+                         static_cast<double>(onLink.size()) / bytesPerUs;
+            linkBusy = true;
+        }
+    }
+
+    result.dropped = lanes.getDroppedCount();
+    result.superseded = lanes.getSupersededCount();
+    result.refused = lanes.getStats(SendLane::EVENTS).refused;
+    result.queueNs = std::chrono::duration<double, std::nano>(queueTime).count() / static_cast<double>(queueOps);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t instances = argc > 1 ? static_cast<size_t>(std::max(1, std::atoi(argv[1]))) : 8;
+    double seconds = argc > 2 ? std::max(3.0, std::atof(argv[2])) : 30.0;
+    double congestedKBps = argc > 3 ? std::max(1.0, std::atof(argv[3])) : 150.0;
+    Logger::getInstance().setDebugEnabled(false);
+
+    std::printf("%zu instances at %llu ms, %.0f s, link %.0f KB/s congested in the middle third\n", instances,
+                static_cast<unsigned long long>(kFrameIntervalUs / 1000), seconds, congestedKBps);
+    std::printf("%-9s %26s %26s %18s %9s %10s %8s %6s %8s\n", "", "event frames p50/p99/max",
+                "state frames p50/p99/max", "stats p50/max", "dropped", "superseded", "refused", "order", "queue");
+
+    bool ordered = true;
+    for (Mode mode : {Mode::FIFO, Mode::STRICT, Mode::WEIGHTED}) {
+        Result r = run(mode, instances, seconds, congestedKBps * 1000.0);
+        std::printf("%-9s %8.1f/%8.1f/%8.1f %8.1f/%8.1f/%8.1f %8.1f/%8.1f %9llu %10llu %8llu %6llu %6.0fns\n",
+                    modeName(mode), r.events.percentile(0.5), r.events.percentile(0.99), r.events.percentile(1.0),
+                    r.state.percentile(0.5), r.state.percentile(0.99), r.state.percentile(1.0),
+                    r.stats.percentile(0.5), r.stats.percentile(1.0), static_cast<unsigned long long>(r.dropped),
+                    static_cast<unsigned long long>(r.superseded), static_cast<unsigned long long>(r.refused),
+                    static_cast<unsigned long long>(r.outOfOrder),
+                    r.queueNs);
+        ordered = ordered && r.outOfOrder == 0;
+    }
+    std::printf("delays in ms from queueing to written; order = frames sent behind a newer one of their instance\n");
+    return ordered ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+// Snapshot ring benchmark: a writer process publishes game states, a forked
+// reader process maps the ring read-only and consumes them.
+//
+// Phase 1 publishes back-to-back to measure throughput and frames lost by a
+// reader that cannot keep up. Phase 2 paces the writer and measures the
+// publish -> futex wakeup -> read latency.
+//
+// Usage: bench_snapshot_ring [frames]
+
+#include "game_types.h"
+#include "logger.h"
+#include "snapshot_ring.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace CS16Capture;
+
+namespace {
+
+struct ReaderResult {
+    uint64_t framesRead;
+    uint64_t framesLost;
+    uint64_t torn;          // visit() results discarded because of overwrites
+    double readNsPerFrame;  // Time inside visit()/next(), excluding waits
+    double latencyP50Us;
+    double latencyP99Us;
+    double latencyMaxUs;
+};
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+GameState makeState() {
+    GameState state;
+    for (size_t slot = 0; slot < 20; ++slot) {
+        std::string name = "Player" + std::to_string(slot);
+        state.players.setPresent(slot, name.c_str(), name.size());
+        state.players.kills[slot] = static_cast<int32_t>(slot);
+        state.players.money[slot] = 800;
+        state.players.team[slot] = static_cast<int32_t>(slot % 2 + 1);
+        state.players.alive[slot] = 1;
+    }
+    state.roundNumber = 1;
+    state.roundTime = 115.0f;
+    return state;
+}
+
+// Runs in the child process
+ReaderResult runReader(const std::string& ringName, uint64_t frames, int readyFd) {
+    ReaderResult result = {};
+    SnapshotReader reader;
+    char ready = reader.open(ringName) ? 1 : 0;
+    if (write(readyFd, &ready, 1) != 1 || !ready) {
+        return result;
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(frames);
+    uint64_t busyNs = 0;
+    int64_t checksum = 0;
+    SnapshotFrame frame;
+
+    while (result.framesRead + reader.getLostFrameCount() < frames) {
+        if (!reader.waitForFrame(2000)) {
+            break;
+        }
+
+        uint64_t start = nowNs();
+        uint64_t latest = reader.getLatestSequence();
+        if (!reader.next(frame)) {
+            continue;
+        }
+        ++result.framesRead;
+
+        // Zero-copy pass over the newest frame, as an overlay would do
+        int64_t money = 0;
+        SnapshotReadStatus status = reader.visit(latest, [&money](const SnapshotFrame& f) {
+            for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+                money += f.players.money[slot];
+            }
+        });
+        if (status == SnapshotReadStatus::OVERWRITTEN) {
+            ++result.torn;
+        } else {
+            checksum += money;
+        }
+        uint64_t end = nowNs();
+        busyNs += end - start;
+        latencies.push_back(static_cast<double>(end - frame.captureTimeNs) / 1000.0);
+    }
+
+    result.framesLost = reader.getLostFrameCount();
+    result.readNsPerFrame = result.framesRead ? static_cast<double>(busyNs) / static_cast<double>(result.framesRead) : 0.0;
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        result.latencyP50Us = latencies[latencies.size() / 2];
+        result.latencyP99Us = latencies[latencies.size() * 99 / 100];
+        result.latencyMaxUs = latencies.back();
+    }
+    return checksum >= 0 ? result : ReaderResult();
+}
+
+bool runPhase(const char* label, uint64_t frames, uint64_t paceNs) {
+    const std::string ringName = "/cs16-bench-" + std::to_string(getpid());
+    SnapshotWriter writer;
+    if (!writer.create(ringName)) {
+        return false;
+    }
+
+    int readyPipe[2];
+    int resultPipe[2];
+    if (pipe(readyPipe) < 0 || pipe(resultPipe) < 0) {
+        return false;
+    }
+
+    pid_t child = fork();
+    if (child == 0) {
+        ReaderResult result = runReader(ringName, frames, readyPipe[1]);
+        ssize_t written = write(resultPipe[1], &result, sizeof(result));
+        _exit(written == static_cast<ssize_t>(sizeof(result)) ? 0 : 1);
+    }
+
+    char ready = 0;
+    if (child < 0 || read(readyPipe[0], &ready, 1) != 1 || !ready) {
+        std::fprintf(stderr, "reader failed to open the ring\n");
+        return false;
+    }
+
+    GameState state = makeState();
+    uint64_t start = nowNs();
+    uint64_t nextPublish = start;
+    for (uint64_t i = 0; i < frames; ++i) {
+        if (paceNs > 0) {
+            while (nowNs() < nextPublish) {
+                std::this_thread::yield();
+            }
+            nextPublish += paceNs;
+        }
+        state.players.money[i % 20] = static_cast<int32_t>(i % 16000);
+        writer.publish(state, static_cast<uint32_t>(getpid()));
+    }
+    double writerNs = static_cast<double>(nowNs() - start);
+
+    ReaderResult result = {};
+    bool received = read(resultPipe[0], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result));
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (!received) {
+        std::fprintf(stderr, "reader did not report\n");
+        return false;
+    }
+
+    std::printf("%s\n", label);
+    std::printf("  writer: %.0f frames/s, %.0f ns/publish, %.1f MB/s of frames\n",
+                static_cast<double>(frames) * 1e9 / writerNs, writerNs / static_cast<double>(frames),
+                static_cast<double>(frames * sizeof(SnapshotFrame)) * 1e3 / writerNs);
+    std::printf("  reader: %llu read, %llu lost, %llu torn, %.0f ns/frame\n",
+                static_cast<unsigned long long>(result.framesRead),
+                static_cast<unsigned long long>(result.framesLost),
+                static_cast<unsigned long long>(result.torn), result.readNsPerFrame);
+    std::printf("  publish -> read latency: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+                result.latencyP50Us, result.latencyP99Us, result.latencyMaxUs);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    Logger::getInstance().setDebugEnabled(false);
+
+    std::printf("%zu-byte frames, %u slots\n", sizeof(SnapshotFrame), SnapshotWriter::kDefaultSlotCount);
+
+    bool ok = runPhase("back-to-back publish", frames, 0) &&
+              runPhase("paced publish (every 100 us)", std::min<uint64_t>(frames, 20000), 100000);
+    return ok ? 0 : 1;
+}
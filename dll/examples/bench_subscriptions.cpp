@@ -0,0 +1,95 @@
+// Subscription benchmark: bytes and encode time of narrow consumers compared
+// with the full stream, over a simulated 100 Hz capture.
+//
+// Usage: bench_subscriptions [seconds]
+
+#include "game_types.h"
+#include "json_value.h"
+#include "logger.h"
+#include "state_encoder.h"
+#include "subscription.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace CS16Capture;
+
+namespace {
+
+const uint64_t kFrameIntervalNs = 10000000;  // 100 Hz capture
+
+GameState makeState() {
+    GameState state;
+    for (size_t slot = 0; slot < 20; ++slot) {
+        std::string name = "Player" + std::to_string(slot);
+        state.players.setPresent(slot, name.c_str(), name.size());
+        state.players.money[slot] = 800;
+        state.players.team[slot] = static_cast<int32_t>(slot % 2 + 1);
+        state.players.alive[slot] = 1;
+    }
+    state.roundNumber = 1;
+    state.roundTime = 115.0f;
+    return state;
+}
+
+void runCase(const char* label, const char* subscribeMessage, uint64_t frames) {
+    Subscription subscription;
+    if (subscribeMessage != nullptr) {
+        JsonValue message;
+        std::string error;
+        if (!JsonValue::parse(subscribeMessage, message, error) ||
+            !parseSubscription(message, subscription, error)) {
+            std::printf("%-34s invalid subscription: %s\n", label, error.c_str());
+            return;
+        }
+    }
+
+    StateEncoder encoder;
+    encoder.setSubscription(subscription, 1);
+    GameState state = makeState();
+    std::string out;
+    uint64_t bytes = 0;
+    uint64_t messages = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        state.events.clear();
+        state.players.money[frame % 20] = static_cast<int32_t>((frame * 50) % 16000);
+        state.roundTime -= 0.01f;
+        if (frame % 500 == 250) {
+            state.bomb.planted = !state.bomb.planted;
+            state.events.push_back(state.bomb.planted ? GameEvent::BOMB_PLANTED : GameEvent::BOMB_EXPLODED);
+        }
+
+        encoder.encode(state, 1, out, frame * kFrameIntervalNs);
+        if (!out.empty()) {
+            bytes += out.size();
+            ++messages;
+        }
+    }
+    double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    double seconds = static_cast<double>(frames * kFrameIntervalNs) / 1e9;
+
+    std::printf("%-34s %8.0f B/s %7.1f msg/s %8.0f ns/frame\n", label,
+                static_cast<double>(bytes) / seconds, static_cast<double>(messages) / seconds,
+                elapsedNs / static_cast<double>(frames));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t seconds = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 600;
+    uint64_t frames = seconds * 1000000000ull / kFrameIntervalNs;
+    Logger::getInstance().setDebugEnabled(false);
+
+    std::printf("%llu s of 100 Hz capture, 20 players\n", static_cast<unsigned long long>(seconds));
+    runCase("full stream (default)", nullptr, frames);
+    runCase("scoreboard: name+money @ 1 Hz",
+            R"({"type":"subscribe","topics":{"players":{"fields":["name","money"],"maxRate":1}}})", frames);
+    runCase("bomb widget: bomb @ 10 Hz + events",
+            R"({"type":"subscribe","topics":{"bomb":{"maxRate":10},"events":{}}})", frames);
+    runCase("round clock @ 2 Hz",
+            R"({"type":"subscribe","topics":{"round":{"fields":["roundTime"],"maxRate":2}}})", frames);
+    return 0;
+}
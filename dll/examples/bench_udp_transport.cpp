@@ -0,0 +1,202 @@
+// UDP transport benchmark: a paced sender and a local receiver over
+// loopback, with datagrams and acks dropped at random by the receiver.
+//
+// Every decoded frame is compared with the state the sender captured for
+// that sequence, so the numbers below only count frames that decoded
+// correctly. Latency is capture -> decoded on the receiver, which shares the
+// sender's clock. The last case restarts the receiver halfway, so the
+// sender's deltas name a keyframe it no longer has until it asks for one.
+//
+// Usage: bench_udp_transport [frames]
+
+#include "game_types.h"
+#include "logger.h"
+#include "udp_transport.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace CS16Capture;
+
+namespace {
+
+const uint32_t kInstanceId = 7;
+const uint64_t kFrameIntervalNs = 1000000;  // 1 kHz, far above the game's rate
+const uint32_t kEventEvery = 50;
+
+struct ReceiverResult {
+    uint64_t frames;
+    uint64_t keyframes;
+    uint64_t mismatches;
+    uint64_t events;
+    uint32_t longestGap;  // Most frames in a row that never arrived
+    double latencyP50Us;
+    double latencyP99Us;
+    double latencyMaxUs;
+    UdpReceiverStats stats;
+};
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// State of frame number n, reproducible on the receiver side
+void fillState(uint32_t frame, GameState& state) {
+    state.events.clear();
+    for (size_t slot = 0; slot < 20; ++slot) {
+        if (frame == 0) {
+            std::string name = "Player" + std::to_string(slot);
+            state.players.setPresent(slot, name.c_str(), name.size());
+            state.players.team[slot] = static_cast<int32_t>(slot % 2 + 1);
+        }
+        state.players.kills[slot] = static_cast<int32_t>((frame + slot * 13) / 400);
+        state.players.deaths[slot] = static_cast<int32_t>((frame + slot * 29) / 500);
+        state.players.alive[slot] = ((frame / 300 + slot) % 3) != 0;
+    }
+    // A couple of players spend money every frame
+    state.players.money[frame % 20] = static_cast<int32_t>((frame * 50) % 16000);
+    state.players.money[(frame + 10) % 20] = static_cast<int32_t>((frame * 30) % 16000);
+    state.roundNumber = static_cast<int32_t>(frame / 2000);
+    state.roundTime = 115.0f - static_cast<float>(frame % 2000) * 0.05f;
+    state.bomb.planted = frame % 2000 > 1500;
+    if (frame > 0 && frame % kEventEvery == 0) {
+        state.events.push_back(GameEvent::PLAYER_KILLED);
+    }
+}
+
+bool samePlayers(const PlayerTable& a, const PlayerTable& b) {
+    if (a.presentMask != b.presentMask) {
+        return false;
+    }
+    for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+        if (!a.isPresent(slot)) {
+            continue;
+        }
+        if (a.kills[slot] != b.kills[slot] || a.deaths[slot] != b.deaths[slot] ||
+            a.assists[slot] != b.assists[slot] || a.money[slot] != b.money[slot] ||
+            a.team[slot] != b.team[slot] || a.alive[slot] != b.alive[slot] ||
+            std::string(a.names[slot]) != b.names[slot]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void runReceiver(UdpReceiver& receiver, uint32_t frames, uint32_t restartAt, ReceiverResult& result) {
+    std::vector<double> latencies;
+    latencies.reserve(frames);
+
+    // Expected states are rebuilt incrementally, as money columns depend on history
+    GameState expected;
+    uint32_t expectedFrame = 0;
+    fillState(0, expected);
+    uint32_t lastSequence = 0;
+
+    UdpFrameInfo info;
+    while (const GameState* state = receiver.receive(500, info)) {
+        uint64_t receivedNs = nowNs();
+        ++result.frames;
+        result.keyframes += info.keyframe ? 1 : 0;
+        result.events += state->events.size();
+        result.longestGap = std::max(result.longestGap, info.sequence - lastSequence - 1);
+        lastSequence = info.sequence;
+
+        if (restartAt != 0 && info.sequence >= restartAt) {
+            // Same port, no decoders; the counters below start over
+            receiver.bind(receiver.getPort());
+            restartAt = 0;
+        }
+
+        while (expectedFrame + 1 < info.sequence) {
+            fillState(++expectedFrame, expected);
+        }
+        if (!samePlayers(state->players, expected.players) || state->roundNumber != expected.roundNumber ||
+            state->bomb.planted != expected.bomb.planted) {
+            ++result.mismatches;
+        }
+
+        latencies.push_back(static_cast<double>(receivedNs - state->captureTimeNs) / 1000.0);
+        if (info.sequence >= frames) {
+            break;
+        }
+    }
+
+    result.stats = receiver.getStats();
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        result.latencyP50Us = latencies[latencies.size() / 2];
+        result.latencyP99Us = latencies[latencies.size() * 99 / 100];
+        result.latencyMaxUs = latencies.back();
+    }
+}
+
+bool runCase(double lossRate, size_t batchSize, uint32_t frames, bool restart = false) {
+    UdpReceiver receiver;
+    if (!receiver.bind(0)) {
+        return false;
+    }
+    receiver.setSimulatedLoss(lossRate, 42);
+
+    UdpClient client;
+    if (!client.open("127.0.0.1", receiver.getPort())) {
+        return false;
+    }
+    client.setBatchSize(batchSize);
+
+    ReceiverResult result = {};
+    std::thread receiverThread(runReceiver, std::ref(receiver), frames, restart ? frames / 2 : 0,
+                               std::ref(result));
+
+    GameState state;
+    uint64_t start = nowNs();
+    uint64_t nextFrame = start;
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+        while (nowNs() < nextFrame) {
+            std::this_thread::yield();
+        }
+        nextFrame += kFrameIntervalNs;
+
+        fillState(frame, state);
+        state.captureTimeNs = nowNs();
+        client.send(state, kInstanceId);
+    }
+    client.flush();
+    receiverThread.join();
+
+    UdpClientStats sent = client.getStats();
+    uint64_t expectedEvents = (frames - 1) / kEventEvery;
+    std::printf("loss %4.1f%%, batch %2zu%s: %5.1f%% frames decoded, %llu wrong | %4.0f B/datagram, %.1f%% keyframes, "
+                "%.2f datagrams/syscall | latency p50 %.0f us, p99 %.0f us, max %.0f us | "
+                "longest gap %u frames, %llu without base, %llu keyframe requests | events %llu/%llu\n",
+                lossRate * 100.0, batchSize, restart ? ", restart" : "", 100.0 * static_cast<double>(result.frames) / frames,
+                static_cast<unsigned long long>(result.mismatches),
+                static_cast<double>(sent.bytes) / static_cast<double>(std::max<uint64_t>(sent.datagrams, 1)),
+                100.0 * static_cast<double>(sent.keyframes) / static_cast<double>(std::max<uint64_t>(sent.datagrams, 1)),
+                static_cast<double>(sent.datagrams) / static_cast<double>(std::max<uint64_t>(sent.sendCalls, 1)),
+                result.latencyP50Us, result.latencyP99Us, result.latencyMaxUs, result.longestGap,
+                static_cast<unsigned long long>(result.stats.missingBase),
+                static_cast<unsigned long long>(sent.keyframeRequests),
+                static_cast<unsigned long long>(result.events), static_cast<unsigned long long>(expectedEvents));
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t frames = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 10000;
+    Logger::getInstance().setDebugEnabled(false);
+
+    std::printf("%u frames at 1 kHz, 20 players, %zu-byte datagram limit\n", frames, UdpWire::kMaxDatagramSize);
+    bool ok = runCase(0.0, 1, frames) &&
+              runCase(0.01, 1, frames) &&
+              runCase(0.05, 1, frames) &&
+              runCase(0.20, 1, frames) &&
+              runCase(0.0, 8, frames) &&
+              runCase(0.01, 1, frames, true);
+    return ok ? 0 : 1;
+}
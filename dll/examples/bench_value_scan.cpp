@@ -0,0 +1,109 @@
+// Value scanner benchmark: scans this process after filling a large buffer
+// with noise and a few planted values, the way one hunts for an offset in
+// the game.
+//
+// Half of the buffer holds small random numbers (so a first scan for one of
+// them keeps a sparse list), the other half zeros (so a first scan for 0
+// keeps dense bitmaps). Every scan is checked to still hold the planted
+// address; throughput counts the bytes actually read by the scan.
+//
+// Usage: bench_value_scan [megabytes] [threads]
+
+#include "logger.h"
+#include "memory_reader.h"
+#include "value_scanner.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace CS16Capture;
+
+namespace {
+
+uint32_t nextRandom(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+bool report(const char* name, ValueScanner& scanner, bool ok, uintptr_t planted) {
+    const ScanStats& stats = scanner.getLastStats();
+    std::vector<uintptr_t> candidates;
+    scanner.getCandidates(candidates, SIZE_MAX);
+    bool found = std::binary_search(candidates.begin(), candidates.end(), planted);
+
+    double seconds = stats.elapsedMs / 1000.0;
+    std::printf("%-28s %8.1f ms %8.0f MB/s | %10llu candidates, %3zu bitmap + %3zu list regions%s\n",
+                name, stats.elapsedMs,
+                seconds > 0.0 ? static_cast<double>(stats.bytesRead) / (1024.0 * 1024.0) / seconds : 0.0,
+                static_cast<unsigned long long>(stats.candidates), stats.bitmapRegions, stats.listRegions,
+                ok && found ? "" : "  <-- planted address lost");
+    return ok && found;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+    size_t threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+    Logger::getInstance().setDebugEnabled(false);
+
+    size_t count = megabytes * 1024 * 1024 / sizeof(int32_t);
+    std::vector<int32_t> memory(count);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < count / 2; ++i) {
+        memory[i] = static_cast<int32_t>(nextRandom(seed) % 1000);
+    }
+
+    // Keep the planted values off the noise so the last scans narrow to one
+    size_t healthIndex = count / 4 + 17;
+    size_t zeroIndex = count / 2 + count / 8 + 3;
+    memory[healthIndex] = 100;
+    float* origin = reinterpret_cast<float*>(memory.data() + count / 2 + 1001);
+    *origin = 1234.56f;
+    char* name = reinterpret_cast<char*>(memory.data() + count / 2 + 2001) + 1;
+    std::memcpy(name, "NamePlantedByBench", 18);
+
+    MemoryReader reader;
+    if (!reader.initialize()) {
+        std::printf("Could not read own memory\n");
+        return 1;
+    }
+    ValueScanner scanner(reader, threads);
+    uintptr_t healthAddress = reinterpret_cast<uintptr_t>(&memory[healthIndex]);
+    uintptr_t zeroAddress = reinterpret_cast<uintptr_t>(&memory[zeroIndex]);
+    bool ok = true;
+
+    std::printf("%zu MB buffer, half noise 0..999, half zeros\n", megabytes);
+
+    // Sparse path: a health value that drops
+    ok &= report("first int 100", scanner, scanner.firstScanInt(100), healthAddress);
+    memory[healthIndex] = 1073;
+    ok &= report("next int 1073", scanner, scanner.nextScanInt(1073), healthAddress);
+    memory[healthIndex] = 1042;
+    ok &= report("next decreased", scanner, scanner.nextScan(ScanCompare::DECREASED), healthAddress);
+    ok &= report("next unchanged", scanner, scanner.nextScan(ScanCompare::UNCHANGED), healthAddress);
+
+    // Dense path: a first scan for 0, then only a few zeros change
+    ok &= report("first int 0", scanner, scanner.firstScanInt(0), zeroAddress);
+    ok &= report("next unchanged (dense)", scanner, scanner.nextScan(ScanCompare::UNCHANGED), zeroAddress);
+    for (size_t i = count / 2; i < count; i += 4096) {
+        memory[i] = 5;
+    }
+    memory[zeroIndex] = 7;
+    ok &= report("next increased", scanner, scanner.nextScan(ScanCompare::INCREASED), zeroAddress);
+    memory[zeroIndex] = 9;
+    ok &= report("next changed", scanner, scanner.nextScan(ScanCompare::CHANGED), zeroAddress);
+
+    ok &= report("first float 1234.56", scanner, scanner.firstScanFloat(1234.56f), reinterpret_cast<uintptr_t>(origin));
+    *origin = 1250.0f;
+    ok &= report("next increased", scanner, scanner.nextScan(ScanCompare::INCREASED), reinterpret_cast<uintptr_t>(origin));
+
+    ok &= report("first string", scanner, scanner.firstScanString("NamePlantedByBench"), reinterpret_cast<uintptr_t>(name));
+    std::memcpy(name, "NameChangedByBench", 18);
+    ok &= report("next string", scanner, scanner.nextScanString("NameChangedByBench"), reinterpret_cast<uintptr_t>(name));
+
+    return ok ? 0 : 1;
+}
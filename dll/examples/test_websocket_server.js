@@ -5,13 +5,29 @@
  * 
  * Usage:
  * 1. npm install ws
- * 2. node test_websocket_server.js
+ * 2. node test_websocket_server.js [--scoreboard]
+ *
+ * With --scoreboard the server subscribes to player names and money only,
+ * at most once per second.
+ *
+ * Pings are answered with the server clock, so the client can report its
+ * capture-to-delivery latency; gaps in "seq" are counted as dropped frames.
  */
 
 const net = require('net');
 
 const PORT = 8080;
 
+// Server clock in microseconds, echoed in pongs
+const serverMicros = () => Math.round((performance.timeOrigin + performance.now()) * 1000);
+
+const SCOREBOARD_SUBSCRIPTION = {
+    type: 'subscribe',
+    topics: {
+        players: { fields: ['name', 'money'], maxRate: 1 }
+    }
+};
+
 console.log('===========================================');
 console.log('CS 1.6 Data Capture - Test Server');
 console.log('===========================================');
@@ -22,6 +38,14 @@ const server = net.createServer((socket) => {
     console.log(`[${new Date().toISOString()}] Client connected from ${socket.remoteAddress}:${socket.remotePort}`);
     
     let buffer = '';
+    const names = new Map(); // nameId -> name, sent once per connection
+    const lastSeq = new Map(); // instance -> last "seq", each instance counts its own
+    let missedFrames = 0;
+    let clockOffsetUs = null; // Server clock minus the client's capture clock
+
+    if (process.argv.includes('--scoreboard')) {
+        socket.write(JSON.stringify(SCOREBOARD_SUBSCRIPTION) + '\n');
+    }
 
     socket.on('data', (data) => {
         buffer += data.toString();
@@ -34,27 +58,75 @@ const server = net.createServer((socket) => {
             if (message.trim()) {
                 try {
                     const gameData = JSON.parse(message);
+                    const receivedUs = serverMicros();
+                    if (gameData.type === 'ping') {
+                        socket.write(JSON.stringify({ type: 'pong', id: gameData.id, t: gameData.t, serverTime: receivedUs }) + '\n');
+                        return;
+                    }
+                    if (gameData.type === 'latency') {
+                        if (gameData.clockOffsetUs === undefined) {
+                            // Counters only: sent before the first pong
+                            return;
+                        }
+                        clockOffsetUs = gameData.clockOffsetUs;
+                        console.log(`[latency] rtt ${gameData.rttUs}us | capture->delivery p50 ${gameData.p50Us}us ` +
+                                    `p90 ${gameData.p90Us}us p99 ${gameData.p99Us}us max ${gameData.maxUs}us | ` +
+                                    `dropped by client ${gameData.dropped}, superseded ${gameData.superseded}`);
+                        return;
+                    }
+                    if (gameData.type === 'stats') {
+                        console.log(`[stats] instance ${gameData.instance} | score T ${gameData.score.t} : CT ${gameData.score.ct} ` +
+                                    `after ${gameData.finishedRounds} rounds`);
+                        gameData.players.forEach((player) => {
+                            console.log(`  ${player.name || 'slot ' + player.slot}: ${player.kills}/${player.deaths}/${player.assists} ` +
+                                        `(KDA ${player.kda.toFixed(2)}), spent $${player.spent}`);
+                        });
+                        return;
+                    }
+                    if (gameData.seq !== undefined) {
+                        const previous = lastSeq.get(gameData.instance) || 0;
+                        if (previous !== 0 && gameData.seq > previous + 1) {
+                            missedFrames += gameData.seq - previous - 1;
+                        }
+                        lastSeq.set(gameData.instance, gameData.seq);
+                    }
+                    (gameData.names || []).forEach((entry) => names.set(entry.id, entry.name));
                     console.log('\n--- Game State Received ---');
-                    console.log(`Time: ${new Date().toLocaleTimeString()}`);
-                    console.log(`Round: ${gameData.roundNumber} | Time: ${gameData.roundTime.toFixed(1)}s`);
+                    console.log(`Time: ${new Date().toLocaleTimeString()} | Frame #${gameData.seq ?? '-'} (missed ${missedFrames})`);
+                    if (clockOffsetUs !== null && gameData.captureTime !== undefined) {
+                        const ageMs = (receivedUs - (gameData.captureTime + clockOffsetUs)) / 1000;
+                        console.log(`Age on arrival: ${ageMs.toFixed(2)}ms`);
+                    }
+                    // Topics the server did not subscribe to are absent
+                    if (gameData.roundNumber !== undefined || gameData.roundTime !== undefined) {
+                        console.log(`Round: ${gameData.roundNumber ?? '-'} | Time: ${gameData.roundTime?.toFixed(1) ?? '-'}s`);
+                    }
                     
                     // Display player info
-                    console.log(`\nPlayers (${gameData.players.length}):`);
-                    gameData.players.forEach((player, index) => {
-                        const alive = player.isAlive ? '✓' : '✗';
-                        const team = player.team === 1 ? 'T' : 'CT';
-                        console.log(`  ${index + 1}. [${team}] ${alive} ${player.name} - K:${player.kills} D:${player.deaths} A:${player.assists} $${player.money}`);
+                    const players = gameData.players || [];
+                    console.log(`\nPlayers (${players.length}):`);
+                    players.forEach((player, index) => {
+                        const alive = player.isAlive === undefined ? '' : (player.isAlive ? '✓ ' : '✗ ');
+                        const team = player.team === undefined ? '' : (player.team === 1 ? '[T] ' : '[CT] ');
+                        const name = player.name ?? names.get(player.nameId) ?? `#${player.nameId}`;
+                        const stats = [
+                            player.kills !== undefined ? `K:${player.kills}` : null,
+                            player.deaths !== undefined ? `D:${player.deaths}` : null,
+                            player.assists !== undefined ? `A:${player.assists}` : null,
+                            player.money !== undefined ? `$${player.money}` : null
+                        ].filter(Boolean).join(' ');
+                        console.log(`  ${index + 1}. ${team}${alive}${name} - ${stats}`);
                     });
                     
                     // Display bomb info
-                    if (gameData.bomb.planted) {
-                        console.log(`\n💣 BOMB: Planted | Time: ${gameData.bomb.timeRemaining.toFixed(1)}s`);
-                    } else {
+                    if (gameData.bomb?.planted) {
+                        console.log(`\n💣 BOMB: Planted | Time: ${gameData.bomb.timeRemaining?.toFixed(1) ?? '-'}s`);
+                    } else if (gameData.bomb) {
                         console.log('\n💣 BOMB: Not planted');
                     }
                     
                     // Display events
-                    if (gameData.events.length > 0) {
+                    if (gameData.events?.length > 0) {
                         console.log('\n🎮 Events:');
                         gameData.events.forEach(event => {
                             console.log(`  - ${event}`);
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include "game_types.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief How much is going on in a game, from the captured state alone
+ */
+enum class CapturePhase {
+    QUIET,      // Nothing but timer and money changed for a while, and the round timer is
+                // stopped (warmup, freezetime, round over) or in the buy window
+    ACTIVE,     // A round in play, or its last seconds
+    CRITICAL    // Bomb planted, a clutch, or players dying in quick succession
+};
+
+/**
+ * @brief Settings of CaptureRatePolicy
+ */
+struct CaptureRateConfig {
+    uint32_t fastestIntervalMs;   // Ceiling rate, used while CRITICAL
+    uint32_t baseIntervalMs;      // Rate while ACTIVE
+    uint32_t slowestIntervalMs;   // Floor rate, used while QUIET
+    uint32_t quietAfterMs;        // Time without changes before a game counts as QUIET
+    uint32_t holdMs;              // Hysteresis: a calmer phase must last this long before slowing down
+    int32_t clutchAlivePlayers;   // A side down to this many after losing players is a clutch
+    uint32_t fightWindowMs;       // Two deaths this close together are a fight
+    float buyWindowSeconds;       // Start of a running round that may still be QUIET
+    float roundEndSeconds;        // Round time left that is never QUIET
+
+    CaptureRateConfig()
+        : fastestIntervalMs(50), baseIntervalMs(100), slowestIntervalMs(500),
+          quietAfterMs(2000), holdMs(1500), clutchAlivePlayers(2),
+          fightWindowMs(3000), buyWindowSeconds(15.0f), roundEndSeconds(10.0f) {}
+};
+
+/**
+ * @brief Figures of CaptureRatePolicy
+ */
+struct CaptureRateStats {
+    uint64_t captures[3];         // Per CapturePhase
+    uint64_t phaseChanges;
+};
+
+/**
+ * @brief Picks the capture interval of one game from what it just captured
+ *
+ * Speeding up is immediate: the capture that sees the bomb planted already
+ * returns the fastest interval. Slowing down waits until the calmer phase has
+ * been observed for holdMs, so a quiet second in a live round or a flicker of
+ * the alive count does not make the rate flap.
+ * Not thread-safe; call from the thread that owns the capture.
+ */
+class CaptureRatePolicy {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit CaptureRatePolicy(const CaptureRateConfig& config = CaptureRateConfig());
+
+    /**
+     * @brief Account for a captured state
+     * @param state State just captured
+     * @param now Time of the capture
+     * @return Interval until the next capture
+     */
+    std::chrono::milliseconds onCapture(const GameState& state, Clock::time_point now);
+
+    /**
+     * @brief Forget the previous state, e.g. after re-attaching
+     */
+    void reset();
+
+    CapturePhase getPhase() const;
+    std::chrono::milliseconds getInterval() const;
+    const CaptureRateStats& getStats() const;
+
+private:
+    CapturePhase classify(const GameState& state, Clock::time_point now);
+
+    CaptureRateConfig config_;
+    CapturePhase phase_;
+
+    // Previous capture, to see what changed
+    PlayerTable previousPlayers_;
+    BombData previousBomb_;
+    int32_t previousRound_;
+    bool hasPrevious_;
+    float previousRoundTime_;        // Of the last capture, changed or not
+    float timerStart_;               // Value the round timer last started from
+    Clock::time_point lastChange_;
+    Clock::time_point lastDeath_;
+    Clock::time_point priorDeath_;   // Death before lastDeath_
+
+    // When a calmer phase than phase_ was first seen (hysteresis)
+    bool calmerPending_;
+    Clock::time_point calmerSince_;
+
+    CaptureRateStats stats_;
+};
+
+} // namespace CS16Capture
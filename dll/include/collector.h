@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "capture_rate_policy.h"
+#include "game_data_capture.h"
+#include "game_types.h"
+#include "match_stats.h"
+#include "process_watcher.h"
+#include "snapshot_ring.h"
+#include "state_encoder.h"
+#include "thread_pool.h"
+#include "udp_transport.h"
+#include "websocket_client.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Settings of the standalone multi-instance collector
+ */
+struct CollectorConfig {
+    std::string host;
+    int port;
+    std::vector<std::string> processNames;  // Executables to attach to
+    uint32_t captureIntervalMs;             // Capture period of every instance
+    bool adaptiveRate;                      // Vary the period with the game phase
+    uint32_t fastestIntervalMs;             // Adaptive period bounds
+    uint32_t slowestIntervalMs;
+    uint32_t scanIntervalMs;                // Period of process start/exit detection
+    size_t workerThreads;                   // 0 = one per hardware thread
+    std::string snapshotRing;               // Shared-memory ring prefix, empty = off
+    int udpPort;                            // UDP receiver port on host, 0 = off
+    size_t udpBatchSize;                    // Datagrams per sendmmsg() call
+    bool softDirtyTracking;                 // Re-read only written pages (Linux)
+    LaneScheduling laneScheduling;          // Order of the send lanes on a congested link
+    CompressionConfig compression;          // Stream compression of the uplink, codec NONE = off
+    MemoryOffsets offsets;                  // Game memory layout; sections with base 0 and no chain are skipped
+
+    CollectorConfig()
+        : host("127.0.0.1"), port(8080), processNames({"hlds_linux"}),
+          captureIntervalMs(100), adaptiveRate(false), fastestIntervalMs(50), slowestIntervalMs(500),
+          scanIntervalMs(1000), workerThreads(0),
+          udpPort(0), udpBatchSize(1), softDirtyTracking(false), laneScheduling(LaneScheduling::STRICT),
+          offsets(GameDataCapture::getDefaultOffsets()) {}
+};
+
+/**
+ * @brief Captures many game server processes from one daemon
+ *
+ * A scheduler thread keeps a capture deadline per attached instance and hands
+ * due ticks to a work-stealing pool. All instances share one transport;
+ * each has its own encoder tagging frames with the instance process id.
+ * Optionally each instance also publishes into its own snapshot ring
+ * "<snapshotRing>-<pid>" for consumers on the same machine, and every frame
+ * is also sent as a datagram to a UDP receiver. Batched datagrams are
+ * flushed by the scheduler on each wake-up. With adaptiveRate each instance
+ * has a CaptureRatePolicy that moves its period between the fastest and
+ * slowest interval as the game goes from freezetime to a post-plant clutch.
+ * Every instance also aggregates MatchStats from its captures, sent as a
+ * summary line per finished round to servers subscribed to "stats".
+ * Frames with events jump the send queue ahead of plain state frames of all
+ * instances, and the summaries go last (see SendLanes).
+ */
+class Collector {
+public:
+    explicit Collector(const CollectorConfig& config);
+    ~Collector();
+
+    Collector(const Collector&) = delete;
+    Collector& operator=(const Collector&) = delete;
+
+    /**
+     * @brief Connect the transport and start scheduling captures
+     * @return true if the collector was started; false also when the offsets
+     *         have no section to capture
+     */
+    bool start();
+
+    /**
+     * @brief Stop scheduling and wait for running captures
+     */
+    void stop();
+
+    /**
+     * @brief Check if the collector is running
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Get the number of attached game instances
+     */
+    size_t getInstanceCount() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Per-process capture state, owned by at most one worker at a time
+     */
+    struct Instance {
+        uint32_t processId;
+        GameDataCapture capture;
+        GameState state;
+        StateEncoder encoder;
+        SnapshotWriter snapshots;
+        CaptureRatePolicy ratePolicy;
+        MatchStats stats;
+        std::string statsLine;                  // Reused buffer of the stats summary
+        Clock::time_point lastTick;             // Scheduler only
+        std::atomic<uint32_t> intervalMs;       // Set by the worker from ratePolicy
+        std::atomic<bool> busy;
+        std::atomic<uint32_t> failedTicks;
+
+        Instance(uint32_t id, const CaptureRateConfig& rate)
+            : processId(id), encoder(id), ratePolicy(rate), intervalMs(rate.baseIntervalMs),
+              busy(false), failedTicks(0) {}
+    };
+
+    void schedulerLoop();
+
+    /**
+     * @brief Attach to started processes and drop exited ones
+     */
+    void refreshInstances();
+
+    /**
+     * @brief Capture and send one frame of an instance (runs on the pool)
+     */
+    void captureTick(const std::shared_ptr<Instance>& instance);
+
+    CollectorConfig config_;
+    CaptureRateConfig rateConfig_;
+    ProcessWatcher watcher_;
+    WebSocketClient client_;
+    UdpClient udp_;
+    std::unique_ptr<ThreadPool> pool_;
+
+    std::unordered_map<uint32_t, std::shared_ptr<Instance>> instances_;
+    mutable std::mutex instancesMutex_;
+
+    std::atomic<bool> running_;
+    std::unique_ptr<std::thread> schedulerThread_;
+};
+
+} // namespace CS16Capture
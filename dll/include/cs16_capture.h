@@ -1,45 +1,33 @@
 #ifndef CS16_CAPTURE_H
 #define CS16_CAPTURE_H
 
-#include <string>
-#include <vector>
-#include <memory>
+#include "game_data_capture.h"
+#include "game_types.h"
 
-struct PlayerData {
-    std::string name;
-    int kills = 0;
-    int deaths = 0;
-    int assists = 0;
-    int money = 0;
-};
-
-struct BombData {
-    bool planted = false;
-    float timeRemaining = 0.0f;
-};
+namespace CS16Capture {
 
-struct GameData {
-    std::vector<PlayerData> players;
-    BombData bomb;
-    std::vector<std::string> events;
-};
-
-class CS16Capture {
+/**
+ * @brief Capture entry point of the injected DLL (reads its host process)
+ */
+class CaptureSystem {
 public:
-    static CS16Capture& getInstance();
+    static CaptureSystem& getInstance();
     
     bool initialize();
     void shutdown();
-    bool captureGameData(GameData& outData);
+    bool captureGameData(GameState& outState);
     
-    CS16Capture(const CS16Capture&) = delete;
-    CS16Capture& operator=(const CS16Capture&) = delete;
+    CaptureSystem(const CaptureSystem&) = delete;
+    CaptureSystem& operator=(const CaptureSystem&) = delete;
 
 private:
-    CS16Capture();
-    ~CS16Capture();
+    CaptureSystem();
+    ~CaptureSystem();
     
+    GameDataCapture capture_;
     bool initialized_;
 };
 
+} // namespace CS16Capture
+
 #endif // CS16_CAPTURE_H
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "memory_reader.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Figures of DirtyPageTracker, averages in microseconds per tick
+ */
+struct DirtyTrackingStats {
+    uint64_t ticks;
+    uint64_t trackedTicks;      // Ticks that re-read only soft-dirty pages
+    uint64_t resyncs;           // Ticks that cleared the bits and read everything
+    uint64_t pagesChecked;
+    uint64_t pagesRead;
+    double plainCostUs;         // Reading every span
+    double trackedCostUs;       // Pagemap query, clearing the bits and reading dirty pages
+    bool tracking;              // Current mode
+};
+
+/**
+ * @brief Keeps copies of memory spans up to date reading only written pages
+ *
+ * Linux only. Writing "4" to /proc/<pid>/clear_refs clears the soft-dirty
+ * bit of every page of the process; the kernel sets it again on the next
+ * write, and /proc/<pid>/pagemap reports it. A tracked tick reads the
+ * pagemap entries of the spans, clears the bits and re-reads just the pages
+ * that were dirty; the other pages keep their cached copies.
+ *
+ * clear_refs walks the page tables of the whole process, so on a big
+ * process it can cost more than reading a few pages directly. Both costs are
+ * averaged, and tracking is only used while it is cheaper than plain reads;
+ * otherwise every span is read as a whole and tracking is tried again every
+ * kProbeInterval ticks. A write that lands between the pagemap query and
+ * clearing the bits is missed, so a resync every kResyncInterval ticks bounds
+ * how long such a page can stay stale.
+ * Not thread-safe; all spans are refreshed by one update() per tick.
+ */
+class DirtyPageTracker {
+public:
+    static constexpr uint32_t kResyncInterval = 256;
+    static constexpr uint32_t kProbeInterval = 512;
+    static constexpr uint32_t kMinSamples = 8;      // Tracked ticks before the costs are compared
+
+    explicit DirtyPageTracker(MemoryReader& reader);
+    ~DirtyPageTracker();
+
+    DirtyPageTracker(const DirtyPageTracker&) = delete;
+    DirtyPageTracker& operator=(const DirtyPageTracker&) = delete;
+
+    /**
+     * @brief Open the pagemap and clear_refs files of the process
+     * @return false if the kernel does not track soft-dirty pages or the
+     *         files cannot be opened; update() then always reads plainly
+     */
+    bool enable();
+
+    bool isEnabled() const;
+
+    /**
+     * @brief Add a span to keep up to date
+     * @return Handle for setSpan() and getData()
+     */
+    size_t addSpan(uintptr_t address, size_t size);
+
+    /**
+     * @brief Point a span elsewhere; it is read whole on the next update()
+     */
+    void setSpan(size_t span, uintptr_t address, size_t size);
+
+    /**
+     * @brief Bring the copies of all spans up to date
+     * @return false if a span could not be read
+     */
+    bool update();
+
+    /**
+     * @brief Copy of a span as of the last update()
+     */
+    const uint8_t* getData(size_t span) const;
+
+    DirtyTrackingStats getStats() const;
+
+private:
+    struct Span {
+        uintptr_t address;
+        size_t size;
+        bool stale;                  // Needs a whole read
+        std::vector<uint8_t> data;
+    };
+
+    // Run of dirty pages to re-read, clipped to its span
+    struct PendingRead {
+        size_t span;
+        size_t offset;
+        size_t size;
+    };
+
+    bool readPlain(bool clearFirst);
+    bool readTracked();
+    bool clearSoftDirty();
+
+    MemoryReader& reader_;
+    std::vector<Span> spans_;
+    std::vector<uint64_t> pagemap_;  // Scratch for pagemap entries
+    std::vector<PendingRead> reads_;
+
+    int pagemapFd_;
+    int clearRefsFd_;
+    size_t pageSize_;
+
+    bool tracking_;
+    uint32_t ticksSinceResync_;
+    uint32_t ticksSinceProbe_;
+    uint32_t trackedSamples_;
+    DirtyTrackingStats stats_;
+};
+
+} // namespace CS16Capture
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "dirty_page_tracker.h"
+#include "game_types.h"
+#include "memory_reader.h"
+#include "name_table.h"
+#include "player_layout.h"
+#include "pointer_resolver.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Reads the game state of one CS 1.6 process
+ *
+ * Works either in-process (DLL injected into hl.exe) or against another
+ * process by id (standalone collector attached to HLDS instances).
+ */
+class GameDataCapture {
+public:
+    GameDataCapture();
+    ~GameDataCapture();
+
+    GameDataCapture(const GameDataCapture&) = delete;
+    GameDataCapture& operator=(const GameDataCapture&) = delete;
+
+    /**
+     * @brief Initialize memory access and resolve offsets
+     * @param processId Process to capture (0 = current process)
+     * @return true if initialization was successful
+     */
+    bool initialize(uint32_t processId = 0);
+
+    /**
+     * @brief Initialize memory access with known offsets
+     *
+     * Skips the built-in offsets; useful when the offsets come from a config
+     * file. Flat bases still count from the game module base. Without a game
+     * module, initializing fails for another process (not loaded yet) and
+     * takes the base as 0 for the current one (e.g. a benchmark handing in
+     * addresses of its own memory).
+     * @param processId Process to capture (0 = current process)
+     * @param offsets Module-relative base addresses and structure offsets
+     * @return true if initialization was successful
+     */
+    bool initialize(uint32_t processId, const MemoryOffsets& offsets);
+
+    /**
+     * @brief Capture the current game state
+     *
+     * Reuses the capacity of outState, so capturing into the same state
+     * every frame does not allocate once names are interned.
+     * @param outState State to fill; events are derived from the previous capture
+     * @return true if capture was successful
+     */
+    bool captureGameState(GameState& outState);
+
+    /**
+     * @brief Replace the offsets resolved by initializeOffsets()
+     * @param offsets Module-relative base addresses and structure offsets
+     */
+    void setOffsets(const MemoryOffsets& offsets);
+
+    /**
+     * @brief Get the offsets currently in use
+     */
+    const MemoryOffsets& getOffsets() const;
+
+    /**
+     * @brief Get the built-in offsets used by initialize(processId)
+     *
+     * Only the structure layout is filled in; every base address is 0.
+     */
+    static MemoryOffsets getDefaultOffsets();
+
+    /**
+     * @brief Get the id of the captured process
+     */
+    uint32_t getProcessId() const;
+
+    /**
+     * @brief Get cache statistics of the pointer chain resolver
+     */
+    PointerResolverStats getResolverStats() const;
+
+    /**
+     * @brief Re-read only the written pages of the player array (Linux)
+     *
+     * Call after initialize(). See DirtyPageTracker for the cost model that
+     * falls back to plain reads when tracking does not pay off.
+     * @return false if the kernel or permissions do not allow it
+     */
+    bool enableSoftDirtyTracking();
+
+    /**
+     * @brief Get figures of soft-dirty tracking (zeros when not enabled)
+     */
+    DirtyTrackingStats getDirtyTrackingStats() const;
+
+    /**
+     * @brief Get the table resolving PlayerTable::nameIds of captured states
+     */
+    const NameTable& getNameTable() const;
+
+private:
+    /**
+     * @brief Resolve base addresses for the loaded game build
+     */
+    bool initializeOffsets();
+
+    /**
+     * @brief Register the pointer chains of offsets_ with the resolver and
+     *        pick the player decoder matching its layout
+     */
+    void applyOffsets();
+
+    /**
+     * @brief Resolve this frame's structure addresses (chain or flat base)
+     */
+    bool resolveBaseAddresses();
+
+    bool capturePlayers(GameState& state);
+    bool captureBomb(GameState& state);
+    bool captureRound(GameState& state);
+
+    /**
+     * @brief Derive events from the difference with the previous capture
+     */
+    void detectEvents(GameState& state);
+
+    std::unique_ptr<MemoryReader> memoryReader_;
+    MemoryOffsets offsets_;
+    PointerResolver resolver_;
+
+    // Resolver handles of the pointer chains in offsets_ (kNoPath if flat)
+    size_t playerListPath_;
+    size_t bombPath_;
+    size_t gameStatePath_;
+
+    // Raw copy of the whole player array, decoded by playerDecoder_
+    PlayerDecoder playerDecoder_;
+    std::vector<uint8_t> playerSpan_;
+    NameTable nameTable_;
+
+    // Set by enableSoftDirtyTracking(); keeps its own copy of the player array
+    std::unique_ptr<DirtyPageTracker> dirtyTracker_;
+    size_t playerSpanHandle_;
+
+    // Load address of the game module in the captured process, which the
+    // flat bases of offsets_ are relative to
+    uintptr_t moduleBase_;
+
+    // Structure addresses used by the current capture
+    uintptr_t playerListAddress_;
+    uintptr_t bombAddress_;
+    uintptr_t gameStateAddress_;
+
+    GameState previousState_;
+    bool hasPreviousState_;
+    bool isInitialized_;
+};
+
+} // namespace CS16Capture
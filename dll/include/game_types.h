@@ -2,26 +2,124 @@
 
 #include <string>
 #include <vector>
+#include <bitset>
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 namespace CS16Capture {
 
+class NameTable;
+
 /**
- * @brief Player data structure
+ * @brief Fixed-capacity player table, one column per field
+ *
+ * Slot i of every array belongs to the player in game slot i; bit i of
+ * presentMask tells whether the slot is occupied. Names are stored inline,
+ * so the whole table is one flat block that is copied, diffed and cleared
+ * without touching the heap. Fields of free slots are zero and their names
+ * empty; names are NUL-terminated, bytes after the terminator are unspecified.
  */
-struct PlayerData {
-    std::string name;
-    int32_t kills;
-    int32_t deaths;
-    int32_t assists;
-    int32_t money;
-    int32_t team;  // 1 = Terrorist, 2 = Counter-Terrorist
-    bool isAlive;
-
-    PlayerData()
-        : kills(0), deaths(0), assists(0), money(0), team(0), isAlive(false) {}
+struct PlayerTable {
+    static constexpr size_t kMaxPlayers = 32;
+    static constexpr size_t kNameLength = 32;  // Including the terminating NUL
+
+    uint32_t presentMask;
+    int32_t kills[kMaxPlayers];
+    int32_t deaths[kMaxPlayers];
+    int32_t assists[kMaxPlayers];
+    int32_t money[kMaxPlayers];
+    int32_t team[kMaxPlayers];  // 1 = Terrorist, 2 = Counter-Terrorist
+    uint8_t alive[kMaxPlayers];
+    uint16_t nameIds[kMaxPlayers];  // Ids in GameState::nameTable, or 0xFFFF
+    char names[kMaxPlayers][kNameLength];
+
+    PlayerTable() {
+        clear();
+    }
+
+    /**
+     * @brief Mark every slot free and zero all fields
+     */
+    void clear() {
+        std::memset(this, 0, sizeof(*this));
+        std::memset(nameIds, 0xFF, sizeof(nameIds));
+    }
+
+    bool isPresent(size_t slot) const {
+        return (presentMask >> slot) & 1u;
+    }
+
+    /**
+     * @brief Get the number of occupied slots
+     */
+    size_t count() const {
+        return static_cast<size_t>(std::bitset<kMaxPlayers>(presentMask).count());
+    }
+
+    /**
+     * @brief Occupy a slot and copy its raw name (truncated to kNameLength - 1)
+     */
+    void setPresent(size_t slot, const char* name, size_t maxLength) {
+        if (maxLength >= kNameLength) {
+            // Fixed-size copy compiles to a few vector moves
+            std::memcpy(names[slot], name, kNameLength);
+            names[slot][kNameLength - 1] = '\0';
+        } else {
+            size_t length = strnlen(name, maxLength);
+            std::memcpy(names[slot], name, length);
+            names[slot][length] = '\0';
+        }
+        presentMask |= 1u << slot;
+    }
+
+    /**
+     * @brief Free a slot and zero its fields
+     */
+    void setAbsent(size_t slot) {
+        presentMask &= ~(1u << slot);
+        kills[slot] = 0;
+        deaths[slot] = 0;
+        assists[slot] = 0;
+        money[slot] = 0;
+        team[slot] = 0;
+        alive[slot] = 0;
+        nameIds[slot] = 0xFFFF;
+        names[slot][0] = '\0';
+    }
 };
 
+static_assert(std::is_trivially_copyable<PlayerTable>::value, "PlayerTable must stay a flat block");
+
+/**
+ * @brief Get the slots whose column value differs between two tables
+ *
+ * Branch-free over all slots so the compiler can vectorize it; mask the
+ * result with presentMask to ignore free slots.
+ */
+template<typename T>
+inline uint32_t changedSlots(const T (&current)[PlayerTable::kMaxPlayers],
+                             const T (&previous)[PlayerTable::kMaxPlayers]) {
+    uint32_t mask = 0;
+    for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+        mask |= static_cast<uint32_t>(current[slot] != previous[slot]) << slot;
+    }
+    return mask;
+}
+
+/**
+ * @brief Get the slots whose column value grew since the previous table
+ */
+template<typename T>
+inline uint32_t increasedSlots(const T (&current)[PlayerTable::kMaxPlayers],
+                               const T (&previous)[PlayerTable::kMaxPlayers]) {
+    uint32_t mask = 0;
+    for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+        mask |= static_cast<uint32_t>(current[slot] > previous[slot]) << slot;
+    }
+    return mask;
+}
+
 /**
  * @brief Bomb status data structure
  */
@@ -51,14 +149,38 @@ enum class GameEvent {
  * @brief Complete game state
  */
 struct GameState {
-    std::vector<PlayerData> players;
+    PlayerTable players;
     BombData bomb;
     std::vector<GameEvent> events;
     int32_t roundNumber;
     float roundTime;
+    const NameTable* nameTable;  // Resolves PlayerTable::nameIds; owned by the capture
+    uint64_t captureTimeNs;      // steady_clock when the game memory was read (0 = unknown)
     
     GameState()
-        : roundNumber(0), roundTime(0.0f) {}
+        : roundNumber(0), roundTime(0.0f), nameTable(nullptr), captureTimeNs(0) {}
+};
+
+/**
+ * @brief Multi-level pointer chain to a game structure
+ *
+ * Resolves as: address = moduleBase + moduleOffset, then for each offset
+ * address = *address + offset. The result is the structure address itself.
+ */
+struct PointerPath {
+    std::string moduleName;
+    uintptr_t moduleOffset;
+    std::vector<int32_t> offsets;
+
+    // Optional cheap validity check: 32-bit value expected at finalAddress + sentinelOffset
+    bool hasSentinel;
+    int32_t sentinelOffset;
+    uint32_t sentinelValue;
+
+    PointerPath()
+        : moduleOffset(0), hasSentinel(false), sentinelOffset(0), sentinelValue(0) {}
+
+    bool isSet() const { return !moduleName.empty(); }
 };
 
 /**
@@ -66,11 +188,20 @@ struct GameState {
  * These offsets may need to be updated based on the game version
  */
 struct MemoryOffsets {
-    // Base addresses (relative to module base)
+    // Base addresses relative to the game module base (0 = section not captured)
     uintptr_t playerListBase;
     uintptr_t bombBase;
     uintptr_t gameStateBase;
+
+    // Pointer chains; when set they take precedence over the flat bases above
+    PointerPath playerListPath;
+    PointerPath bombPath;
+    PointerPath gameStatePath;
     
+    // Player array layout
+    size_t playerStructSize;
+    size_t maxPlayers;
+
     // Player offsets
     size_t playerNameOffset;
     size_t playerKillsOffset;
@@ -84,13 +215,23 @@ struct MemoryOffsets {
     size_t bombPlantedOffset;
     size_t bombTimerOffset;
     size_t bombDefusedOffset;
+
+    // Round offsets
+    size_t roundNumberOffset;
+    size_t roundTimeOffset;
     
     MemoryOffsets()
         : playerListBase(0), bombBase(0), gameStateBase(0),
-          playerNameOffset(0), playerKillsOffset(0), playerDeathsOffset(0),
+          playerStructSize(0), maxPlayers(0), playerNameOffset(0), playerKillsOffset(0), playerDeathsOffset(0),
           playerAssistsOffset(0), playerMoneyOffset(0), playerTeamOffset(0),
           playerAliveOffset(0), bombPlantedOffset(0), bombTimerOffset(0),
-          bombDefusedOffset(0) {}
+          bombDefusedOffset(0), roundNumberOffset(0), roundTimeOffset(0) {}
+
+    // True if at least one section has a base address or pointer chain
+    bool hasSection() const {
+        return playerListBase != 0 || bombBase != 0 || gameStateBase != 0 ||
+               playerListPath.isSet() || bombPath.isSet() || gameStatePath.isSet();
+    }
 };
 
 } // namespace CS16Capture
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "stream_compressor.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Settings of IngestServer
+ */
+struct IngestServerConfig {
+    int port;                         // 0 = any free port, see IngestServer::getPort()
+    size_t shards;                    // Event loop threads, 0 = one per hardware thread
+    bool answerPings;                 // Reply to client pings, which enables latency reports
+    std::string subscribeMessage;     // Line sent to every new connection, empty = none
+    std::string compressionDictionary; // zstd dictionary of compressing clients, empty = none
+
+    // Fault injection
+    double slowReadFraction;          // Share of connections read slowly (0..1)
+    size_t slowReadBytesPerSecond;    // Read rate of those connections
+    uint32_t disconnectAfterMs;       // Mean lifetime before a forced disconnect, 0 = never
+    uint32_t seed;                    // Picks slow connections and disconnect times
+
+    IngestServerConfig()
+        : port(8080), shards(0), answerPings(true),
+          slowReadFraction(0.0), slowReadBytesPerSecond(16 * 1024), disconnectAfterMs(0), seed(1) {}
+};
+
+/**
+ * @brief Log-linear histogram of latencies in microseconds
+ *
+ * Four buckets per power of two, so percentiles are within 25% of the true
+ * value, in a fixed 160-counter block cheap enough to keep per connection.
+ */
+struct LatencyHistogram {
+    static constexpr size_t kSubBuckets = 4;
+    static constexpr size_t kBuckets = kSubBuckets + 39 * kSubBuckets;
+
+    uint32_t counts[kBuckets];
+    uint64_t total;
+    uint64_t maxUs;
+
+    LatencyHistogram() { clear(); }
+
+    void clear();
+    void record(uint64_t us);
+    void merge(const LatencyHistogram& other);
+
+    /**
+     * @brief Get the upper bound of the bucket holding a percentile
+     * @param fraction Percentile as a fraction (0.99 = p99)
+     */
+    double percentile(double fraction) const;
+};
+
+/**
+ * @brief What the server saw of one connection
+ */
+struct IngestConnectionStats {
+    uint64_t id;                 // Accept order over the server lifetime
+    size_t shard;
+    uint16_t peerPort;
+    bool slowRead;               // Picked for slow reads by fault injection
+    CompressionCodec codec;      // Announced by the client's compression hello
+    double connectedSeconds;
+    uint64_t bytes;              // As received
+    uint64_t plainBytes;         // After decompression
+    uint64_t frames;             // Lines carrying "seq"
+    uint64_t messages;           // Other lines: pings, latency and stats reports
+    uint64_t gaps;               // Frames missing from the "seq" of an instance, less clientSuperseded;
+                                 // may run ahead by the frames superseded since that report (< 0.25 s)
+    uint64_t clientDropped;      // Dropped frames the client reported itself
+    uint64_t clientSuperseded;   // Frames the client replaced by newer ones, as it last reported
+    uint64_t malformed;
+    double bytesPerSecond;
+    double framesPerSecond;
+    double p50Us;                // Capture to receive, by "captureTime"
+    double p99Us;
+    double maxUs;
+};
+
+/**
+ * @brief Totals over all shards since start
+ */
+struct IngestServerStats {
+    size_t connections;          // Open now
+    uint64_t accepted;
+    uint64_t closed;             // By the peer or an error
+    uint64_t injectedDisconnects;
+    uint64_t bytes;
+    uint64_t plainBytes;
+    uint64_t frames;
+    uint64_t messages;
+    uint64_t gaps;               // As IngestConnectionStats::gaps
+    uint64_t clientSuperseded;
+    uint64_t malformed;
+    uint64_t pongs;
+    LatencyHistogram latency;
+};
+
+/**
+ * @brief Native receiving end of WebSocketClient for load tests (Linux)
+ *
+ * Speaks the same newline-delimited JSON as the test server: frames are
+ * counted and checked for "seq" gaps per "instance" (one collector
+ * connection carries several) and their "captureTime" gives the age
+ * at receive time, pings are answered with the monotonic clock (so clients
+ * on the same host report a clock offset near zero) and latency reports
+ * refine the offset. Clients that announce stream compression are
+ * decompressed (see stream_compressor.h). Connections are spread over shards, each an epoll
+ * loop on its own thread with its own SO_REUSEPORT listening socket, so the
+ * kernel balances accepts and no state is shared between shards.
+ *
+ * Fault injection exercises the backpressure of clients: slow connections
+ * are read at a capped rate, which fills their socket buffers and send
+ * queues, and forced disconnects make clients reconnect.
+ */
+class IngestServer {
+public:
+    explicit IngestServer(const IngestServerConfig& config = IngestServerConfig());
+    ~IngestServer();
+
+    IngestServer(const IngestServer&) = delete;
+    IngestServer& operator=(const IngestServer&) = delete;
+
+    /**
+     * @brief Bind the shards and start their threads
+     * @return true if the server was started
+     */
+    bool start();
+
+    /**
+     * @brief Close every connection and join the shards
+     */
+    void stop();
+
+    bool isRunning() const;
+
+    /**
+     * @brief Get the bound port
+     */
+    int getPort() const;
+
+    IngestServerStats getStats() const;
+
+    /**
+     * @brief Get the statistics of every open connection
+     */
+    std::vector<IngestConnectionStats> getConnectionStats() const;
+
+private:
+    struct Connection;
+    struct Shard;
+
+    void shardLoop(Shard& shard);
+    void acceptConnections(Shard& shard, uint64_t nowUs);
+    void readConnection(Shard& shard, Connection& connection, uint64_t nowUs);
+    size_t handleText(Shard& shard, Connection& connection, const char* data, size_t length, uint64_t nowUs);
+    void handleLine(Shard& shard, Connection& connection, const char* line, size_t length, uint64_t nowUs);
+    void closeConnection(Shard& shard, int fd, bool injected);
+    void runTimers(Shard& shard, uint64_t nowUs);
+
+    IngestServerConfig config_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> nextConnectionId_;
+    int port_;
+};
+
+} // namespace CS16Capture
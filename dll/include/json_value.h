@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace CS16Capture {
+
+struct JsonMember;
+
+/**
+ * @brief Parsed JSON document, for the small control messages servers send
+ *
+ * Not meant for hot paths: parsing allocates freely.
+ */
+struct JsonValue {
+    enum class Type {
+        NUL,
+        BOOLEAN,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT
+    };
+
+    Type type;
+    bool boolean;
+    double number;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<JsonMember> object;
+
+    JsonValue()
+        : type(Type::NUL), boolean(false), number(0.0) {}
+
+    bool isObject() const { return type == Type::OBJECT; }
+    bool isArray() const { return type == Type::ARRAY; }
+    bool isString() const { return type == Type::STRING; }
+    bool isNumber() const { return type == Type::NUMBER; }
+
+    /**
+     * @brief Find a member of an object
+     * @return Member value, or nullptr if missing or not an object
+     */
+    const JsonValue* find(const std::string& key) const;
+
+    /**
+     * @brief Get a string member, or fallback if missing or not a string
+     */
+    std::string getString(const std::string& key, const std::string& fallback = std::string()) const;
+
+    /**
+     * @brief Get a number member, or fallback if missing or not a number
+     */
+    double getNumber(const std::string& key, double fallback = 0.0) const;
+
+    /**
+     * @brief Parse one JSON document
+     * @param text JSON text; trailing whitespace is allowed
+     * @param outValue Parsed document
+     * @param error Position and reason of a failure
+     * @return true if text is valid JSON
+     */
+    static bool parse(const std::string& text, JsonValue& outValue, std::string& error);
+};
+
+/**
+ * @brief Key/value pair of a JSON object, in document order
+ */
+struct JsonMember {
+    std::string key;
+    JsonValue value;
+};
+
+} // namespace CS16Capture
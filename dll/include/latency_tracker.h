@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace CS16Capture {
+
+/**
+ * @brief Snapshot of the latency probes of one connection
+ *
+ * Times are microseconds. Delivery latency is capture -> written to the
+ * socket plus half the round-trip time, i.e. an estimate of when the
+ * server had the frame.
+ */
+struct LatencyStats {
+    uint64_t samples;        // Frames measured since the connection started
+    uint64_t pongs;          // Ping replies received
+    double rttUs;            // Lowest round-trip time of recent pings
+    double clockOffsetUs;    // Server clock minus our monotonic clock
+    bool hasClockOffset;
+    double p50Us;
+    double p90Us;
+    double p99Us;
+    double maxUs;
+
+    LatencyStats()
+        : samples(0), pongs(0), rttUs(0.0), clockOffsetUs(0.0), hasClockOffset(false),
+          p50Us(0.0), p90Us(0.0), p99Us(0.0), maxUs(0.0) {}
+};
+
+/**
+ * @brief Ping/pong round trips, clock offset and per-frame delivery latency
+ *
+ * Pings carry our send time; the server echoes it with its own clock in a
+ * pong. The offset is estimated NTP-style from the ping with the lowest
+ * round trip among the last few, which is the one least skewed by queueing.
+ * Thread-safe: the send thread records frames and pings, the receive
+ * thread reports pongs.
+ */
+class LatencyTracker {
+public:
+    static constexpr size_t kMaxSamples = 1024;
+    static constexpr size_t kRttWindow = 8;
+
+    LatencyTracker();
+
+    /**
+     * @brief Forget everything (new connection)
+     */
+    void reset();
+
+    /**
+     * @brief Write a ping message and remember when it was sent
+     * @param nowUs Monotonic time of the send
+     * @param out Receives one newline-terminated JSON line
+     */
+    void makePing(uint64_t nowUs, std::string& out);
+
+    /**
+     * @brief Account for a pong
+     * @param id Echoed ping id
+     * @param sentUs Echoed send time of the ping
+     * @param serverTimeUs Server clock when it answered
+     * @param nowUs Monotonic time of the receive
+     * @return false if the pong does not match an outstanding ping
+     */
+    bool onPong(uint64_t id, uint64_t sentUs, double serverTimeUs, uint64_t nowUs);
+
+    /**
+     * @brief Record one frame written to the socket
+     * @param captureTimeUs Monotonic capture time of the frame (0 = unknown)
+     * @param sentUs Monotonic time the write completed
+     */
+    void recordFrame(uint64_t captureTimeUs, uint64_t sentUs);
+
+    /**
+     * @brief Compute percentiles over the recent frames
+     */
+    LatencyStats getStats() const;
+
+    /**
+     * @brief Write a latency report message for the server
+     *
+     * Without a clock offset yet only the frame counters are written.
+     * @param droppedFrames Frames dropped by the send queue so far
+     * @param supersededFrames Frames replaced in the send queue by a newer one so far
+     * @param out Receives one newline-terminated JSON line
+     */
+    void makeReport(uint64_t droppedFrames, uint64_t supersededFrames, std::string& out) const;
+
+private:
+    mutable std::mutex mutex_;
+
+    uint64_t nextPingId_;
+    uint64_t pendingPingId_;
+    uint64_t pendingPingSentUs_;
+
+    // Recent round trips and the offsets measured with them
+    double rtts_[kRttWindow];
+    double offsets_[kRttWindow];
+    size_t rttCount_;
+    size_t rttNext_;
+    uint64_t pongs_;
+
+    // Ring of recent delivery latencies (us)
+    uint32_t samples_[kMaxSamples];
+    size_t sampleNext_;
+    uint64_t sampleCount_;
+};
+
+/**
+ * @brief Monotonic clock in microseconds, shared by capture and transport
+ */
+uint64_t monotonicMicros();
+
+} // namespace CS16Capture
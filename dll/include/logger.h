@@ -5,6 +5,7 @@
 #include <fstream>
 #include <mutex>
 #include <iostream>
+#include <atomic>
 
 enum class LogLevel {
     INFO,
@@ -23,6 +24,9 @@ public:
     void logError(const std::string& message);
     void logDebug(const std::string& message);
 
+    void setDebugEnabled(bool enable);
+    bool isDebugEnabled() const;
+
 private:
     Logger();
     ~Logger();
@@ -31,9 +35,22 @@ private:
     
     std::ofstream logFile_;
     std::mutex mutex_;
+    std::atomic<bool> debugEnabled_;
     
     std::string getLevelString(LogLevel level);
     std::string getTimestamp();
 };
 
+#define LOG_INFO(message)    Logger::getInstance().logInfo(message)
+#define LOG_WARNING(message) Logger::getInstance().logWarning(message)
+#define LOG_ERROR(message)   Logger::getInstance().logError(message)
+
+// Debug messages are often built per frame; skip formatting them when disabled
+#define LOG_DEBUG(message)                                  \
+    do {                                                    \
+        if (Logger::getInstance().isDebugEnabled()) {       \
+            Logger::getInstance().logDebug(message);        \
+        }                                                   \
+    } while (0)
+
 #endif
\ No newline at end of file
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "game_types.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Side of a round result (values match PlayerTable::team)
+ */
+enum class RoundWinner : uint8_t {
+    NONE = 0,
+    TERRORISTS = 1,
+    COUNTER_TERRORISTS = 2
+};
+
+enum class RoundEndReason : uint8_t {
+    UNKNOWN,
+    ELIMINATION,
+    BOMB_EXPLODED,
+    BOMB_DEFUSED,
+    TIME_EXPIRED
+};
+
+/**
+ * @brief Spending of a side in a round, from the average money spent per player
+ */
+enum class BuyType : uint8_t {
+    ECO,        // Under 1000
+    FORCE,      // Under 3500
+    FULL
+};
+
+/**
+ * @brief Aggregates of the player in one slot since the player took it
+ */
+struct PlayerMatchStats {
+    uint16_t nameId;            // NameTable::kInvalidId while the slot is free
+    int32_t team;
+    int32_t kills;              // Since the slot was taken, not the scoreboard
+    int32_t deaths;
+    int32_t assists;
+    int32_t roundsPlayed;
+    int32_t roundsSurvived;
+    int32_t multiKillRounds[4]; // Rounds with 2, 3, 4 and 5+ kills
+    int64_t moneySpent;
+    int64_t moneyEarned;
+
+    /**
+     * @brief (kills + assists) / deaths, deaths counted as at least 1
+     */
+    double kda() const {
+        return static_cast<double>(kills + assists) / static_cast<double>(deaths > 0 ? deaths : 1);
+    }
+};
+
+/**
+ * @brief One finished round; money columns are per slot
+ */
+struct RoundRecord {
+    int32_t roundNumber;
+    RoundWinner winner;
+    RoundEndReason reason;
+    bool bombPlanted;
+    float durationSeconds;      // From the first to the last capture of the round
+    int32_t teamStartMoney[2];  // Terrorists, counter-terrorists
+    int32_t teamSpent[2];
+    BuyType teamBuy[2];
+    uint32_t presentMask;       // Slots that played the round
+    uint32_t survivedMask;
+    uint16_t nameIds[PlayerTable::kMaxPlayers];  // Who played each slot
+    int32_t startMoney[PlayerTable::kMaxPlayers];
+    int32_t spent[PlayerTable::kMaxPlayers];
+    uint8_t kills[PlayerTable::kMaxPlayers];
+};
+
+/**
+ * @brief Incremental match statistics of one capture stream
+ *
+ * Fed every captured state, it compares the columns with the previous state
+ * and only does work for the slots whose kills, deaths, assists, money or
+ * team changed, so a frame where nothing happened costs one memcmp. A round ends when the round number goes up; its result (winner
+ * from the bomb and the sides left alive) and per-slot money, spending and
+ * kills go into a ring of the last kRoundHistory rounds, which are also the
+ * money curves of the players. The round running when the stats started is
+ * not recorded, its start was not seen. A lower round number starts a new
+ * match. Players and rounds refer to names by NameTable id; when the table
+ * resets (new epoch) the ids are carried over by slot, so a player keeps
+ * the stats of the slot across the reset. Fixed-size storage: updating
+ * never allocates.
+ * Not thread-safe; feed it from the thread that captures.
+ */
+class MatchStats {
+public:
+    static constexpr size_t kRoundHistory = 30;   // A full MR15 match
+    static constexpr int32_t kEcoSpend = 1000;
+    static constexpr int32_t kForceSpend = 3500;
+
+    MatchStats();
+
+    /**
+     * @brief Account for a captured state
+     */
+    void update(const GameState& state);
+
+    /**
+     * @brief Forget everything, e.g. after re-attaching
+     */
+    void reset();
+
+    /**
+     * @brief Get the aggregates of a slot; valid for slots in getPresentMask()
+     */
+    const PlayerMatchStats& getPlayer(size_t slot) const;
+
+    /**
+     * @brief Get the slots occupied in the last state
+     */
+    uint32_t getPresentMask() const;
+
+    /**
+     * @brief Get the number of rounds kept (at most kRoundHistory)
+     */
+    size_t getRoundCount() const;
+
+    /**
+     * @brief Get a kept round, 0 = oldest
+     */
+    const RoundRecord& getRound(size_t index) const;
+
+    /**
+     * @brief Get the rounds won by a side since the match started
+     */
+    int32_t getRoundWins(RoundWinner side) const;
+
+    /**
+     * @brief Get the number of rounds finished since the match started
+     *
+     * Grows by one at each round end; compare with an earlier value to send
+     * a summary once per round.
+     */
+    uint64_t getFinishedRounds() const;
+
+private:
+    void accountPlayers(const PlayerTable& players);
+    void startRound(const GameState& state);
+    void finishRound();
+    void resetSlot(size_t slot, const PlayerTable& players);
+    void remapNames(const PlayerTable& players);
+
+    PlayerMatchStats players_[PlayerTable::kMaxPlayers];
+
+    // Round in progress
+    RoundRecord current_;
+    bool roundObserved_;        // Its start was seen, so it is recorded
+    bool bombDefused_;
+    uint64_t roundStartNs_;
+    uint64_t lastCaptureNs_;
+
+    RoundRecord rounds_[kRoundHistory];
+    size_t nextRound_;
+    size_t roundCount_;
+    int32_t wins_[2];
+    uint64_t finishedRounds_;
+
+    PlayerTable previous_;
+    int32_t previousRound_;
+    bool hasPrevious_;
+
+    // Name table the ids above belong to
+    const NameTable* nameTable_;
+    uint32_t nameEpoch_;
+};
+
+} // namespace CS16Capture
@@ -7,10 +7,20 @@
 
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <sys/types.h>
 #endif
 
 namespace CS16Capture {
 
+/**
+ * @brief A committed, writable mapping of the target process
+ */
+struct MemoryRegion {
+    uintptr_t base;
+    size_t size;
+};
+
 /**
  * @brief Memory reader for safe reading from game memory
  */
@@ -19,12 +29,37 @@ public:
     MemoryReader();
     ~MemoryReader();
 
+    MemoryReader(const MemoryReader&) = delete;
+    MemoryReader& operator=(const MemoryReader&) = delete;
+
     /**
-     * @brief Initialize the memory reader
+     * @brief Initialize the memory reader for the current process
      * @return true if initialization was successful
      */
     bool initialize();
 
+    /**
+     * @brief Initialize the memory reader for another process
+     * @param processId Id of the process to read from
+     * @return true if the process could be opened for reading
+     */
+    bool attach(uint32_t processId);
+
+    /**
+     * @brief Get the id of the process being read
+     * @return Process id (0 if not initialized)
+     */
+    uint32_t getProcessId() const;
+
+    /**
+     * @brief Read a block of raw bytes from memory
+     * @param address Memory address to read from
+     * @param buffer Destination buffer of at least size bytes
+     * @param size Number of bytes to read
+     * @return true if all bytes were read
+     */
+    bool readBuffer(uintptr_t address, void* buffer, size_t size);
+
     /**
      * @brief Read a value from memory
      * @tparam T Type of value to read
@@ -57,6 +92,13 @@ public:
      */
     uintptr_t getModuleBase(const std::string& moduleName);
 
+    /**
+     * @brief List the writable memory of the process, where game state lives
+     * @param outRegions Receives the regions in ascending address order
+     * @return false if the memory map could not be read
+     */
+    bool getWritableRegions(std::vector<MemoryRegion>& outRegions);
+
     /**
      * @brief Find a pattern in memory
      * @param pattern Byte pattern to search for
@@ -72,6 +114,7 @@ public:
 
 private:
     bool isInitialized_;
+    uint32_t processId_;
 #ifdef _WIN32
     HANDLE processHandle_;
 #endif
@@ -80,11 +123,11 @@ private:
 // Template implementation
 template<typename T>
 bool MemoryReader::readMemory(uintptr_t address, T& outValue) {
+#ifdef _WIN32
     if (!isInitialized_ || !isValidAddress(address)) {
         return false;
     }
 
-#ifdef _WIN32
     SIZE_T bytesRead;
     return ReadProcessMemory(processHandle_, 
                            reinterpret_cast<LPCVOID>(address),
@@ -92,8 +135,8 @@ bool MemoryReader::readMemory(uintptr_t address, T& outValue) {
                            sizeof(T), 
                            &bytesRead) && bytesRead == sizeof(T);
 #else
-    // Linux implementation would go here
-    return false;
+    // process_vm_readv fails cleanly on unmapped pages, so no separate probe
+    return readBuffer(address, &outValue, sizeof(T));
 #endif
 }
 
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace CS16Capture {
+
+/**
+ * @brief Interns player names into small stable ids
+ *
+ * Each player slot remembers the raw name bytes it last saw, so a name is
+ * only decoded and looked up again when those bytes change. Ids stay stable
+ * until the table fills up and is reset, which bumps the epoch. Decoders
+ * call beginFrame() first, so the reset happens between frames and every id
+ * of one frame belongs to the same epoch.
+ */
+class NameTable {
+public:
+    static constexpr uint16_t kInvalidId = 0xFFFF;
+    static constexpr size_t kMaxNameLength = 32;
+    static constexpr size_t kMaxNames = 4096;
+
+    NameTable();
+
+    /**
+     * @brief Prepare for interning the slots of one frame
+     *
+     * Resets the table now if maxNewNames more names might not fit, rather
+     * than halfway through the frame, where slots interned before the reset
+     * would keep ids of the old epoch.
+     * @param maxNewNames Most names one frame can add (its slot count)
+     */
+    void beginFrame(size_t maxNewNames);
+
+    /**
+     * @brief Get the id of the name stored in a player slot
+     * @param slot Player slot index
+     * @param raw Raw name buffer of the slot (NUL-terminated or maxLength bytes)
+     * @param maxLength Size of the raw buffer
+     * @return Name id
+     */
+    uint16_t internSlot(size_t slot, const char* raw, size_t maxLength);
+
+    /**
+     * @brief Get the id of a name, adding it if needed
+     */
+    uint16_t intern(const char* name, size_t length);
+
+    /**
+     * @brief Get the name of an id (empty for unknown ids)
+     */
+    const std::string& getName(uint16_t id) const;
+
+    /**
+     * @brief Get the number of interned names
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the table epoch; ids of different epochs are unrelated
+     */
+    uint32_t getEpoch() const;
+
+    /**
+     * @brief Get the number of times slot bytes changed and had to be decoded
+     */
+    uint64_t getDecodeCount() const;
+
+private:
+    struct SlotCache {
+        char raw[kMaxNameLength];
+        uint16_t id;
+        bool valid;
+    };
+
+    void reset();
+
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, uint16_t> ids_;
+    std::vector<SlotCache> slots_;
+    uint32_t epoch_;
+    uint64_t decodeCount_;
+};
+
+} // namespace CS16Capture
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include "game_types.h"
+#include "json_value.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Read memory offsets from a JSON document, e.g. an offsets file
+ *
+ * Keys are the member names of MemoryOffsets; members left out keep their
+ * value in inOutOffsets, so a file can name just the base addresses found
+ * for a game build on top of the built-in layout:
+ *   {"playerListBase":"0x1B5A20",
+ *    "bombPath":{"module":"cs.so","moduleOffset":"0x2A1F40","offsets":["0x7C",16],
+ *                "sentinelOffset":0,"sentinelValue":1},
+ *    "playerStructSize":"0x200","playerKillsOffset":64}
+ * Values are JSON integers or strings in decimal or 0x hex, since JSON has
+ * no hex numbers. Only the "offsets" of a pointer chain may be negative.
+ * @param document Parsed JSON object
+ * @param inOutOffsets Offsets to update (unchanged on failure)
+ * @param error Reason of a failure
+ * @return true if every key was known and every value valid
+ */
+bool parseMemoryOffsets(const JsonValue& document, MemoryOffsets& inOutOffsets, std::string& error);
+
+} // namespace CS16Capture
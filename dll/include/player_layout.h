@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include "game_types.h"
+#include "name_table.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Player structure layout of CS 1.6 Steam build 8684
+ *
+ * Offsets as documented in MEMORY_OFFSETS_GUIDE.md. A layout is a type with
+ * constexpr members so decodePlayers<Layout> compiles to fixed-offset loads.
+ */
+struct Steam8684Layout {
+    static constexpr size_t kStructSize = 0x200;
+    static constexpr size_t kMaxPlayers = 32;
+    static constexpr size_t kNameOffset = 0x04;
+    static constexpr size_t kNameLength = 32;
+    static constexpr size_t kKillsOffset = 0x40;
+    static constexpr size_t kDeathsOffset = 0x44;
+    static constexpr size_t kAssistsOffset = 0x48;
+    static constexpr size_t kMoneyOffset = 0x4C;
+    static constexpr size_t kTeamOffset = 0x50;
+    static constexpr size_t kAliveOffset = 0x54;
+};
+
+/**
+ * @brief Decodes the raw player array (maxPlayers * structSize bytes) into players
+ *
+ * Every slot of the table is written: occupied game slots are copied and
+ * their names interned into the name table, all others are marked free.
+ * @return false if the decoder cannot handle the given offsets
+ */
+using PlayerDecoder = bool (*)(const MemoryOffsets& offsets,
+                               const uint8_t* span,
+                               NameTable& names,
+                               PlayerTable& outPlayers);
+
+template<typename T>
+inline T loadField(const uint8_t* address) {
+    T value;
+    std::memcpy(&value, address, sizeof(T));
+    return value;
+}
+
+/**
+ * @brief Check if runtime offsets describe exactly the given layout
+ */
+template<typename Layout>
+bool matchesLayout(const MemoryOffsets& offsets) {
+    return offsets.playerStructSize == Layout::kStructSize &&
+           offsets.maxPlayers == Layout::kMaxPlayers &&
+           offsets.playerNameOffset == Layout::kNameOffset &&
+           offsets.playerKillsOffset == Layout::kKillsOffset &&
+           offsets.playerDeathsOffset == Layout::kDeathsOffset &&
+           offsets.playerAssistsOffset == Layout::kAssistsOffset &&
+           offsets.playerMoneyOffset == Layout::kMoneyOffset &&
+           offsets.playerTeamOffset == Layout::kTeamOffset &&
+           offsets.playerAliveOffset == Layout::kAliveOffset;
+}
+
+/**
+ * @brief Decoder specialized for a compile-time layout; offsets are ignored
+ */
+template<typename Layout>
+bool decodePlayers(const MemoryOffsets&, const uint8_t* span, NameTable& names, PlayerTable& outPlayers) {
+    static_assert(Layout::kMaxPlayers <= PlayerTable::kMaxPlayers, "Layout exceeds the player table");
+
+    for (size_t slot = 0; slot < Layout::kMaxPlayers; ++slot) {
+        const uint8_t* raw = span + slot * Layout::kStructSize;
+        const char* name = reinterpret_cast<const char*>(raw + Layout::kNameOffset);
+        if (name[0] == '\0') {
+            outPlayers.setAbsent(slot);  // Free slot
+            continue;
+        }
+
+        outPlayers.setPresent(slot, name, Layout::kNameLength);
+        outPlayers.nameIds[slot] = names.internSlot(slot, name, Layout::kNameLength);
+        outPlayers.kills[slot] = loadField<int32_t>(raw + Layout::kKillsOffset);
+        outPlayers.deaths[slot] = loadField<int32_t>(raw + Layout::kDeathsOffset);
+        outPlayers.assists[slot] = loadField<int32_t>(raw + Layout::kAssistsOffset);
+        outPlayers.money[slot] = loadField<int32_t>(raw + Layout::kMoneyOffset);
+        outPlayers.team[slot] = loadField<int32_t>(raw + Layout::kTeamOffset);
+        outPlayers.alive[slot] = raw[Layout::kAliveOffset] != 0;
+    }
+    for (size_t slot = Layout::kMaxPlayers; slot < PlayerTable::kMaxPlayers; ++slot) {
+        outPlayers.setAbsent(slot);
+    }
+    return true;
+}
+
+/**
+ * @brief Generic decoder reading every offset from MemoryOffsets
+ */
+bool decodePlayersRuntime(const MemoryOffsets& offsets, const uint8_t* span, NameTable& names,
+                          PlayerTable& outPlayers);
+
+/**
+ * @brief Pick the specialized decoder of a known layout, or the runtime one
+ */
+PlayerDecoder selectPlayerDecoder(const MemoryOffsets& offsets);
+
+} // namespace CS16Capture
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "game_types.h"
+#include "memory_reader.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Cache statistics of a PointerResolver
+ */
+struct PointerResolverStats {
+    uint64_t hits;          // Resolved from cache after a cheap revalidation
+    uint64_t misses;        // Full chain walks
+    uint64_t walkFailures;  // Walks that hit a null or unreadable pointer
+
+    PointerResolverStats()
+        : hits(0), misses(0), walkFailures(0) {}
+};
+
+/**
+ * @brief Resolves PointerPath chains and caches the intermediate pointers
+ *
+ * A cached chain is revalidated with one read of its root pointer plus the
+ * optional sentinel, instead of one read per level. It is walked again only
+ * when validation fails or the generation was bumped (e.g., on map change).
+ */
+class PointerResolver {
+public:
+    /**
+     * @param reader Reader of the target process
+     * @param pointerSize Pointer width of the target process (4 for the 32-bit game)
+     */
+    explicit PointerResolver(MemoryReader& reader, size_t pointerSize = 4);
+
+    /**
+     * @brief Register a chain to resolve
+     * @return Handle for resolve()
+     */
+    size_t addPath(const PointerPath& path);
+
+    /**
+     * @brief Forget all registered chains and cached module bases
+     */
+    void clear();
+
+    /**
+     * @brief Get the final address of a chain
+     * @param handle Handle returned by addPath()
+     * @param outAddress Resolved structure address
+     * @return true if the chain could be resolved
+     */
+    bool resolve(size_t handle, uintptr_t& outAddress);
+
+    /**
+     * @brief Invalidate every cached chain (bumps the generation)
+     */
+    void invalidate();
+
+    PointerResolverStats getStats() const;
+    void resetStats();
+
+private:
+    struct CachedChain {
+        PointerPath path;
+        std::vector<uintptr_t> links;  // Pointer value read at each level
+        uintptr_t rootAddress;         // Slot holding links[0]
+        uintptr_t finalAddress;
+        uint64_t generation;
+        bool valid;
+
+        CachedChain()
+            : rootAddress(0), finalAddress(0), generation(0), valid(false) {}
+    };
+
+    bool readPointer(uintptr_t address, uintptr_t& outValue);
+    bool revalidate(const CachedChain& chain);
+    bool checkSentinel(const CachedChain& chain);
+    bool walk(CachedChain& chain);
+    uintptr_t getModuleBase(const std::string& moduleName, bool refresh);
+
+    MemoryReader& reader_;
+    size_t pointerSize_;
+    std::vector<CachedChain> chains_;
+    std::unordered_map<std::string, uintptr_t> moduleBases_;
+    uint64_t generation_;
+    PointerResolverStats stats_;
+};
+
+} // namespace CS16Capture
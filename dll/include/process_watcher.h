@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace CS16Capture {
+
+/**
+ * @brief Detects game server processes starting and exiting
+ */
+class ProcessWatcher {
+public:
+    /**
+     * @param processNames Executable names to watch (e.g., "hlds_linux")
+     */
+    explicit ProcessWatcher(const std::vector<std::string>& processNames);
+
+    /**
+     * @brief Rescan the process list
+     * @param started Receives ids of processes that appeared since the last poll
+     * @param exited Receives ids of processes that are gone since the last poll
+     */
+    void poll(std::vector<uint32_t>& started, std::vector<uint32_t>& exited);
+
+    /**
+     * @brief Forget a process so the next poll reports it as started again
+     * @param processId Process id to forget
+     */
+    void forget(uint32_t processId);
+
+private:
+    /**
+     * @brief List ids of all running processes with a watched name
+     */
+    void listProcesses(std::unordered_set<uint32_t>& outIds) const;
+
+    bool isWatchedName(const std::string& name) const;
+
+    std::vector<std::string> processNames_;
+    std::unordered_set<uint32_t> knownProcesses_;
+};
+
+} // namespace CS16Capture
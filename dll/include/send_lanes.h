@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace CS16Capture {
+
+/**
+ * @brief Priority class of an outgoing message, highest first
+ */
+enum class SendLane : uint8_t {
+    EVENTS,   // Frames that carry events or names, which later frames do not repeat
+    STATE,    // Plain state frames, made obsolete by the next frame of their stream
+    STATS     // Match statistics summaries and other bulk lines
+};
+
+constexpr size_t kSendLaneCount = 3;
+
+/**
+ * @brief How the sender picks the next lane
+ */
+enum class LaneScheduling : uint8_t {
+    STRICT,   // Always the highest non-empty lane
+    WEIGHTED  // Non-empty lanes share the link by weight, so no lane starves
+};
+
+/**
+ * @brief Bounds and scheduling of SendLanes
+ */
+struct SendLaneConfig {
+    LaneScheduling scheduling;
+    size_t capacity[kSendLaneCount];  // Queued messages per lane, see SendLanes::push()
+    uint32_t weight[kSendLaneCount];  // Messages per scheduling round with WEIGHTED
+
+    SendLaneConfig()
+        : scheduling(LaneScheduling::STRICT), capacity{256, 256, 64}, weight{8, 4, 1} {}
+};
+
+/**
+ * @brief Counters of one lane since the queue was created
+ */
+struct SendLaneStats {
+    size_t pending;
+    uint64_t queued;
+    uint64_t sent;
+    uint64_t dropped;       // Oldest message dropped from a full lane
+    uint64_t superseded;    // State frame replaced by a newer one of its stream
+    uint64_t refused;       // Push into a full events lane, left to the producer
+};
+
+/**
+ * @brief Outgoing message queue with one bounded ring per priority lane
+ *
+ * Frames may name the stream they belong to (the capture instance) and the
+ * topics they carry as a mask of 1 << Topic. A newer frame of a stream
+ * supersedes a queued state frame whose topics it all carries: a state frame
+ * takes the queued one's place, keeping its turn, and an events frame simply
+ * removes it. Frames of one stream still leave in the order they were
+ * encoded whatever the scheduling, since a frame waits for older frames of
+ * its stream in the other lane.
+ *
+ * A full state or stats lane drops its oldest message: a later frame or
+ * summary repeats what it carried. Events frames carry names and events
+ * that are sent once, so a full events lane never drops; it refuses the
+ * new frame and the producer takes it back (StateEncoder::discardFrame()).
+ *
+ * Ring slots swap their buffers with the messages passing through, so
+ * buffers keep their capacity and the queue does not allocate once warm.
+ * Not thread-safe; WebSocketClient guards it with its queue mutex.
+ */
+class SendLanes {
+public:
+    explicit SendLanes(const SendLaneConfig& config = SendLaneConfig());
+
+    /**
+     * @brief Replace bounds and scheduling; drops everything queued
+     */
+    void configure(const SendLaneConfig& config);
+
+    const SendLaneConfig& getConfig() const;
+
+    /**
+     * @brief Drop everything queued, keeping bounds, counters and buffers
+     */
+    void clear();
+
+    /**
+     * @brief Queue a message
+     * @param lane Priority lane
+     * @param message Message to queue; receives a spent buffer in exchange
+     * @param captureTimeNs Capture time of the frame (0 = not a frame)
+     * @param stream Stream of a frame for superseding and ordering (0 = none)
+     * @param topics Topics the frame carries, 1 << Topic each
+     * @return false if the events lane is full; message is left untouched
+     */
+    bool push(SendLane lane, std::string& message, uint64_t captureTimeNs, uint64_t stream, uint32_t topics);
+
+    /**
+     * @brief Take the next message to send
+     * @param message Receives the message; its old buffer goes into the queue
+     * @param captureTimeNs Receives the capture time passed to push()
+     * @param lane Receives the lane it came from
+     * @return false if nothing is queued
+     */
+    bool pop(std::string& message, uint64_t& captureTimeNs, SendLane& lane);
+
+    size_t size() const;
+    bool empty() const;
+
+    uint64_t getDroppedCount() const;
+    uint64_t getSupersededCount() const;
+    SendLaneStats getStats(SendLane lane) const;
+
+private:
+    struct Entry {
+        std::string message;
+        uint64_t captureTimeNs;
+        uint64_t stream;
+        uint32_t topics;
+        uint64_t order;     // Push counter, orders entries of different lanes
+    };
+
+    struct Lane {
+        std::vector<Entry> slots;
+        size_t head;
+        size_t size;
+        int64_t credit;     // Smooth weighted round robin
+        SendLaneStats stats;
+
+        Entry& at(size_t index) { return slots[(head + index) % slots.size()]; }
+        const Entry& at(size_t index) const { return slots[(head + index) % slots.size()]; }
+    };
+
+    size_t findStream(const Lane& lane, uint64_t stream) const;
+    size_t findSuperseded(const Lane& lane, uint64_t stream, uint32_t topics) const;
+    void erase(Lane& lane, size_t index);
+    size_t pickLane();
+    void take(Lane& lane, size_t index, std::string& message, uint64_t& captureTimeNs);
+
+    SendLaneConfig config_;
+    Lane lanes_[kSendLaneCount];
+    uint64_t nextOrder_;
+    size_t size_;
+};
+
+} // namespace CS16Capture
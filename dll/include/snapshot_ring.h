@@ -0,0 +1,218 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "game_types.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Version of the shared-memory layout below; bump on any change
+ */
+constexpr uint32_t kSnapshotLayoutVersion = 1;
+constexpr uint32_t kSnapshotMagic = 0x36315343;  // "CS16"
+constexpr size_t kMaxSnapshotEvents = 16;
+
+/**
+ * @brief One published game state, plain data only
+ *
+ * Readers see names inline in players.names; players.nameIds refer to the
+ * writer's name table and are only stable within one writer run.
+ */
+struct SnapshotFrame {
+    uint64_t sequence;        // Publish counter of the ring, starts at 1
+    uint64_t captureTimeNs;   // steady_clock of the writer at capture (or publish) time
+    uint32_t instanceId;      // Captured process id
+    int32_t roundNumber;
+    float roundTime;
+    float bombTimeRemaining;
+    uint8_t bombPlanted;
+    uint8_t bombDefused;
+    uint8_t eventCount;       // Events beyond kMaxSnapshotEvents are dropped
+    uint8_t reserved;
+    uint8_t events[kMaxSnapshotEvents];  // GameEvent values
+    PlayerTable players;
+};
+
+/**
+ * @brief Ring slot guarded by a per-slot sequence (seqlock)
+ *
+ * sequence is 0 while the writer fills the slot and the frame sequence once
+ * it is complete. A reader checks it before and after looking at the frame.
+ */
+struct alignas(64) SnapshotSlot {
+    std::atomic<uint64_t> sequence;
+    SnapshotFrame frame;
+};
+
+/**
+ * @brief Start of the shared-memory object, followed by slotCount slots
+ */
+struct alignas(64) SnapshotRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotSize;
+    std::atomic<uint64_t> writeSequence;  // Last published frame (0 = none)
+    std::atomic<uint32_t> wakeCounter;    // Futex word, bumped on every publish
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared counters must be lock-free");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared counters must be lock-free");
+static_assert(std::is_trivially_copyable<SnapshotFrame>::value, "SnapshotFrame must be plain data");
+
+/**
+ * @brief Publishes game states into a named shared-memory ring
+ *
+ * Single writer. Publishing never blocks and never fails on slow readers:
+ * the oldest slot is overwritten and readers notice by its sequence.
+ */
+class SnapshotWriter {
+public:
+    static constexpr uint32_t kDefaultSlotCount = 64;
+
+    SnapshotWriter();
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    /**
+     * @brief Create (or replace) the shared-memory ring
+     * @param name Object name, e.g. "/cs16-snapshots" (leading '/' optional)
+     * @param slotCount Number of frames kept for readers
+     * @return true if the ring is ready
+     */
+    bool create(const std::string& name, uint32_t slotCount = kDefaultSlotCount);
+
+    /**
+     * @brief Unmap and remove the ring
+     */
+    void close();
+
+    bool isOpen() const;
+
+    /**
+     * @brief Publish one state and wake waiting readers
+     * @param state Captured state
+     * @param instanceId Process id written into the frame
+     * @return Sequence of the published frame (0 if the ring is not open)
+     */
+    uint64_t publish(const GameState& state, uint32_t instanceId);
+
+    /**
+     * @brief Get the sequence of the last published frame
+     */
+    uint64_t getSequence() const;
+
+private:
+    std::string name_;
+    SnapshotRingHeader* header_;
+    SnapshotSlot* slots_;
+    size_t mappedSize_;
+#ifdef _WIN32
+    void* mappingHandle_;
+#endif
+};
+
+/**
+ * @brief Outcome of reading one sequence from the ring
+ */
+enum class SnapshotReadStatus {
+    OK,
+    NOT_YET,      // Not published yet
+    OVERWRITTEN   // The writer reused the slot before or during the read
+};
+
+/**
+ * @brief Maps a snapshot ring read-only and consumes its frames
+ *
+ * Reading costs no syscalls: frames are looked at in place and validated by
+ * their slot sequence. Only waitForFrame() sleeps in the kernel.
+ */
+class SnapshotReader {
+public:
+    SnapshotReader();
+    ~SnapshotReader();
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    /**
+     * @brief Map an existing ring and check its layout version
+     * @param name Object name given to SnapshotWriter::create()
+     * @return true if the ring was mapped
+     */
+    bool open(const std::string& name);
+
+    void close();
+
+    bool isOpen() const;
+
+    /**
+     * @brief Get the sequence of the last published frame
+     */
+    uint64_t getLatestSequence() const;
+
+    /**
+     * @brief Call visitor on a frame in place, without copying it
+     *
+     * The frame may be overwritten while the visitor runs; in that case the
+     * result is OVERWRITTEN and whatever the visitor computed must be dropped.
+     */
+    template<typename Visitor>
+    SnapshotReadStatus visit(uint64_t sequence, Visitor&& visitor) const {
+        if (sequence == 0 || sequence > getLatestSequence()) {
+            return SnapshotReadStatus::NOT_YET;
+        }
+
+        const SnapshotSlot& slot = slots_[sequence % header_->slotCount];
+        if (slot.sequence.load(std::memory_order_acquire) != sequence) {
+            return SnapshotReadStatus::OVERWRITTEN;
+        }
+
+        visitor(slot.frame);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+            return SnapshotReadStatus::OVERWRITTEN;
+        }
+        return SnapshotReadStatus::OK;
+    }
+
+    /**
+     * @brief Copy one frame out of the ring
+     */
+    SnapshotReadStatus read(uint64_t sequence, SnapshotFrame& outFrame) const;
+
+    /**
+     * @brief Copy the next unread frame, skipping frames lost to overwrites
+     * @return false if no new frame is available
+     */
+    bool next(SnapshotFrame& outFrame);
+
+    /**
+     * @brief Sleep until a frame newer than the last one read is published
+     * @param timeoutMs Maximum wait
+     * @return true if a new frame is available
+     */
+    bool waitForFrame(uint32_t timeoutMs);
+
+    /**
+     * @brief Get the number of frames skipped because the reader fell behind
+     */
+    uint64_t getLostFrameCount() const;
+
+private:
+    const SnapshotRingHeader* header_;
+    const SnapshotSlot* slots_;
+    size_t mappedSize_;
+    uint64_t nextSequence_;
+    uint64_t lostFrames_;
+#ifdef _WIN32
+    void* mappingHandle_;
+#endif
+};
+
+} // namespace CS16Capture
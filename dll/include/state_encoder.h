@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "game_types.h"
+#include "match_stats.h"
+#include "name_table.h"
+#include "subscription.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Encodes game states of one capture stream into JSON frames
+ *
+ * Frames are written with plain appends into a reused buffer, so encoding
+ * does not allocate once the buffer has grown to the frame size.
+ * Only the topics and fields of the subscription are written, each at most
+ * at its requested rate; events of skipped frames are carried over so none
+ * is lost.
+ * Every frame carries "seq", counting frames of the connection from 1, and
+ * "captureTime", the monotonic capture time in microseconds (see the ping
+ * messages of WebSocketClient for mapping it to the server clock).
+ * Players refer to their name by "nameId". A name is written once in the
+ * "names" section of the first frame using it, and again after a resync
+ * (new connection, name table reset or explicit request).
+ * Match statistics go out as separate {"type":"stats"} lines without "seq",
+ * see encodeStats().
+ */
+class StateEncoder {
+public:
+    /**
+     * @param instanceId Source instance written into every frame (-1 = none)
+     */
+    explicit StateEncoder(int64_t instanceId = -1);
+
+    /**
+     * @brief Encode one frame as a single newline-terminated JSON line
+     * @param state Game state to encode
+     * @param connectionGeneration Transport connection counter; a change
+     *        means the receiver lost all previously sent names
+     * @param out Buffer receiving the frame; cleared first, capacity is reused.
+     *        Left empty when the subscription has nothing due this frame.
+     */
+    void encode(const GameState& state, uint64_t connectionGeneration, std::string& out);
+
+    /**
+     * @brief Encode one frame at an explicit time (steady clock, ns)
+     */
+    void encode(const GameState& state, uint64_t connectionGeneration, std::string& out, uint64_t nowNs);
+
+    /**
+     * @brief Encode the match statistics summary if the stats topic is due
+     *
+     * Due once per finished round, on a new connection or subscription, and
+     * at the topic rate when the subscription sets one.
+     * @param stats Aggregates of the stream
+     * @param names Table resolving the name ids of the players (may be null)
+     * @param connectionGeneration Transport connection counter
+     * @param out Buffer receiving one newline-terminated {"type":"stats"}
+     *        line; cleared first, left empty when the summary is not due
+     */
+    void encodeStats(const MatchStats& stats, const NameTable* names, uint64_t connectionGeneration,
+                     std::string& out);
+
+    /**
+     * @brief Encode the match statistics summary at an explicit time (steady clock, ns)
+     */
+    void encodeStats(const MatchStats& stats, const NameTable* names, uint64_t connectionGeneration,
+                     std::string& out, uint64_t nowNs);
+
+    /**
+     * @brief Replace the topics, fields and rates to encode
+     *
+     * Events not sent yet are kept if the events topic stays subscribed.
+     * @param subscription Subscription of the receiving server
+     * @param version Version of the subscription, see getSubscriptionVersion()
+     */
+    void setSubscription(const Subscription& subscription, uint64_t version);
+
+    /**
+     * @brief Get the version passed with the current subscription (0 = default)
+     */
+    uint64_t getSubscriptionVersion() const;
+
+    /**
+     * @brief Get the connection generation the last frame was encoded for
+     */
+    uint64_t getConnectionGeneration() const;
+
+    /**
+     * @brief Get the topics the last frame carried, 1 << Topic each
+     *
+     * The events topic counts only when the frame carried an event.
+     */
+    uint32_t getFrameTopics() const;
+
+    /**
+     * @brief Check whether a later frame with the same topics makes the last one obsolete
+     *
+     * False when the last frame carried events or names, which are sent once.
+     */
+    bool isFrameReplaceable() const;
+
+    /**
+     * @brief Send every name again with the next frame
+     */
+    void resync();
+
+    /**
+     * @brief Take back the last frame, which could not be queued
+     *
+     * Its names and events go out with the next frame instead and its "seq"
+     * is reused, so the receiver sees neither a gap nor unknown name ids.
+     * Only valid right after encode() produced a frame.
+     */
+    void discardFrame();
+
+    /**
+     * @brief Convert game event to string
+     */
+    static const char* gameEventToString(GameEvent event);
+
+private:
+    static constexpr size_t kMaxPendingEvents = 256;
+
+    bool isNameSent(uint16_t id) const;
+    void markNameSent(uint16_t id);
+    void encodePlayers(const PlayerTable& players, const NameTable* table, uint32_t fields, std::string& out);
+
+    int64_t instanceId_;
+
+    // What the receiver already knows about the name table
+    uint64_t connectionGeneration_;
+    uint64_t frameSequence_;  // Last "seq" written on this connection
+    const NameTable* nameTable_;
+    uint32_t nameEpoch_;
+    std::vector<bool> sentNames_;
+    std::vector<uint16_t> newNames_;
+
+    // What the last frame carried
+    uint32_t frameTopics_;
+    bool frameReplaceable_;
+    std::vector<GameEvent> frameEvents_;
+
+    // Requested topics and when each was last written
+    Subscription subscription_;
+    uint64_t subscriptionVersion_;
+    uint64_t lastSentNs_[kTopicCount];
+    bool topicSent_[kTopicCount];
+
+    // What the receiver has of the match statistics
+    uint64_t statsGeneration_;
+    uint64_t statsRoundsSent_;
+
+    // Events captured while the events topic was not due yet
+    std::vector<GameEvent> pendingEvents_;
+};
+
+} // namespace CS16Capture
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace CS16Capture {
+
+/**
+ * @brief Compression of the transport stream
+ *
+ * A client that compresses starts its connection with one plain line
+ *   {"type":"compression","codec":"deflate","dictId":0}
+ * and from then on sends records instead of lines: a u32 little-endian
+ * header holding the payload length in the low 31 bits and a "compressed"
+ * flag in the top bit, then the payload. A payload is one or more whole
+ * newline-terminated lines, as they would have been sent plain, or the
+ * same compressed against everything compressed before on the connection
+ * (context takeover): frames are almost identical to the previous ones, so
+ * most of a frame becomes references into the history.
+ *
+ * deflate payloads are raw deflate flushed with Z_SYNC_FLUSH, without the
+ * trailing 00 00 ff ff, as in the WebSocket permessage-deflate extension.
+ * zstd payloads are flushed blocks of one zstd stream, optionally primed
+ * with a trained dictionary whose id is announced in "dictId".
+ */
+namespace CompressionWire {
+
+constexpr size_t kRecordHeaderSize = 4;
+constexpr uint32_t kCompressedFlag = 0x80000000u;
+constexpr uint32_t kMaxRecordSize = 16 * 1024 * 1024;
+
+} // namespace CompressionWire
+
+enum class CompressionCodec : uint8_t {
+    NONE,
+    DEFLATE,    // Needs zlib at build time
+    ZSTD        // Needs libzstd at build time
+};
+
+/**
+ * @brief Get the name used in the hello line and on the command line
+ */
+const char* compressionCodecToString(CompressionCodec codec);
+
+/**
+ * @brief Parse a codec name ("none", "deflate", "zstd")
+ */
+bool parseCompressionCodec(const std::string& name, CompressionCodec& outCodec);
+
+/**
+ * @brief Check whether the codec was compiled in
+ */
+bool isCompressionCodecAvailable(CompressionCodec codec);
+
+/**
+ * @brief Get the id a zstd dictionary announces itself with (0 = none or not zstd)
+ */
+uint32_t getCompressionDictionaryId(const std::string& dictionary);
+
+/**
+ * @brief Train a zstd dictionary from sample frames
+ * @param samples Frames as sent, newline included
+ * @param maxSize Upper bound on the dictionary size in bytes
+ * @param outDictionary Receives the dictionary
+ * @return false without zstd or if there were too few samples
+ */
+bool trainCompressionDictionary(const std::string* samples, size_t count, size_t maxSize,
+                                std::string& outDictionary);
+
+/**
+ * @brief Settings of StreamCompressor
+ */
+struct CompressionConfig {
+    CompressionCodec codec;
+    int level;                  // 0 = codec default (deflate 6, zstd 3)
+    size_t threshold;           // Messages shorter than this are sent plain
+    std::string dictionary;     // zstd only, see trainCompressionDictionary()
+
+    CompressionConfig() : codec(CompressionCodec::NONE), level(0), threshold(256) {}
+};
+
+/**
+ * @brief Sending end of a compressed stream, one per connection
+ *
+ * Buffers are reused, so compressing does not allocate once they have grown
+ * to the largest record.
+ */
+class StreamCompressor {
+public:
+    StreamCompressor();
+    ~StreamCompressor();
+
+    StreamCompressor(const StreamCompressor&) = delete;
+    StreamCompressor& operator=(const StreamCompressor&) = delete;
+
+    /**
+     * @brief Start a new stream (new connection), forgetting the history
+     * @return false if the codec is not available or failed to initialize
+     */
+    bool reset(const CompressionConfig& config);
+
+    bool isEnabled() const;
+
+    /**
+     * @brief Write the hello line announcing the codec
+     */
+    void makeHello(std::string& out) const;
+
+    /**
+     * @brief Turn one message into a record
+     * @param out Receives the record; cleared first
+     * @return false if the compressor failed; the stream is then unusable
+     */
+    bool compress(const char* data, size_t length, std::string& out);
+
+    uint64_t getPlainBytes() const;       // Messages passed to compress()
+    uint64_t getRecordBytes() const;      // Records written, headers included
+    uint64_t getCompressedRecords() const;
+    uint64_t getPlainRecords() const;     // Below the threshold
+
+private:
+    void release();
+
+    CompressionConfig config_;
+    void* stream_;              // z_stream or ZSTD_CCtx
+    std::string scratch_;
+    uint64_t plainBytes_;
+    uint64_t recordBytes_;
+    uint64_t compressedRecords_;
+    uint64_t plainRecords_;
+};
+
+/**
+ * @brief Receiving end of a compressed stream
+ */
+class StreamDecompressor {
+public:
+    StreamDecompressor();
+    ~StreamDecompressor();
+
+    StreamDecompressor(const StreamDecompressor&) = delete;
+    StreamDecompressor& operator=(const StreamDecompressor&) = delete;
+
+    /**
+     * @brief Start a new stream with the codec of a hello line
+     * @param dictionary zstd dictionary the sender announced, empty = none
+     */
+    bool reset(CompressionCodec codec, const std::string& dictionary);
+
+    /**
+     * @brief Consume received bytes, which may split records anywhere
+     * @param out Receives the plain text of the complete records; appended to
+     * @return false on a corrupt record; the stream is then unusable
+     */
+    bool feed(const char* data, size_t length, std::string& out);
+
+private:
+    bool inflateRecord(const char* data, size_t length, std::string& out);
+    void release();
+
+    CompressionCodec codec_;
+    void* stream_;              // z_stream or ZSTD_DCtx
+    std::string pending_;       // Incomplete record
+};
+
+} // namespace CS16Capture
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "json_value.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Parts of a frame a server can subscribe to
+ */
+enum class Topic : uint8_t {
+    PLAYERS = 0,
+    BOMB,
+    EVENTS,
+    ROUND,
+    STATS       // Match statistics summary, see StateEncoder::encodeStats()
+};
+
+constexpr size_t kTopicCount = 5;
+
+/**
+ * @brief Field bits of the players topic ("name" also covers "nameId")
+ */
+namespace PlayerFields {
+enum : uint32_t {
+    NAME = 1u << 0,
+    KILLS = 1u << 1,
+    DEATHS = 1u << 2,
+    ASSISTS = 1u << 3,
+    MONEY = 1u << 4,
+    TEAM = 1u << 5,
+    IS_ALIVE = 1u << 6,
+    ALL = (1u << 7) - 1
+};
+}
+
+/**
+ * @brief Field bits of the bomb topic
+ */
+namespace BombFields {
+enum : uint32_t {
+    PLANTED = 1u << 0,
+    TIME_REMAINING = 1u << 1,
+    DEFUSED = 1u << 2,
+    ALL = (1u << 3) - 1
+};
+}
+
+/**
+ * @brief Field bits of the round topic
+ */
+namespace RoundFields {
+enum : uint32_t {
+    NUMBER = 1u << 0,
+    TIME = 1u << 1,
+    ALL = (1u << 2) - 1
+};
+}
+
+/**
+ * @brief What a server wants of one topic
+ */
+struct TopicSubscription {
+    bool enabled;
+    uint32_t fields;          // Topic field bits
+    uint64_t minIntervalNs;   // 0 = every captured frame
+
+    TopicSubscription()
+        : enabled(true), fields(~0u), minIntervalNs(0) {}
+};
+
+/**
+ * @brief Topics, fields and rates requested by the server of a connection
+ *
+ * The default subscription is everything at the capture rate, which is what
+ * servers that never send a subscription get.
+ *
+ * Servers subscribe with one JSON line that replaces the whole subscription:
+ *   {"type":"subscribe","topics":{"players":{"fields":["name","money"],"maxRate":1},
+ *                                 "events":{}}}
+ * Topics left out are not sent; a topic without "fields" gets all fields and
+ * one without "maxRate" (Hz) is sent with every captured frame. A subscribe
+ * message without "topics" restores the default.
+ * The "stats" topic has no fields; its summary is sent once per finished
+ * round, and with "maxRate" also periodically in between.
+ */
+struct Subscription {
+    TopicSubscription topics[kTopicCount];
+
+    const TopicSubscription& get(Topic topic) const {
+        return topics[static_cast<size_t>(topic)];
+    }
+
+    TopicSubscription& get(Topic topic) {
+        return topics[static_cast<size_t>(topic)];
+    }
+};
+
+/**
+ * @brief Read a subscribe message
+ * @param message Parsed JSON line received from the server
+ * @param outSubscription Parsed subscription (unchanged on failure)
+ * @param error Reason of a failure
+ * @return true if the message was a valid subscribe message
+ */
+bool parseSubscription(const JsonValue& message, Subscription& outSubscription, std::string& error);
+
+} // namespace CS16Capture
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CS16Capture {
+
+/**
+ * @brief Fixed-size work-stealing thread pool
+ *
+ * Every worker owns a task deque. Tasks submitted from a worker go to its own
+ * deque (LIFO, cache-warm); tasks from outside are spread round-robin. Idle
+ * workers steal from the front of other deques before going to sleep.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Start the worker threads
+     * @param threadCount Number of workers (0 = one per hardware thread)
+     */
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queue a task for execution
+     * @param task Task to run on one of the workers
+     */
+    void submit(Task task);
+
+    /**
+     * @brief Stop accepting tasks, finish queued ones and join the workers
+     */
+    void shutdown();
+
+    /**
+     * @brief Get the number of worker threads
+     */
+    size_t getThreadCount() const;
+
+    /**
+     * @brief Get the number of tasks taken from another worker's deque
+     */
+    uint64_t getStealCount() const;
+
+private:
+    struct WorkQueue {
+        std::deque<Task> tasks;
+        std::mutex mutex;
+    };
+
+    void workerLoop(size_t index);
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t index, Task& task);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::atomic<size_t> nextQueue_;
+    std::atomic<size_t> pendingTasks_;
+    std::atomic<uint64_t> stealCount_;
+    std::atomic<bool> stopping_;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+};
+
+} // namespace CS16Capture
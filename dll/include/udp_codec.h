@@ -0,0 +1,226 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "game_types.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Datagram format of the UDP transport
+ *
+ * Every datagram starts with the same header, integers little-endian:
+ *   u16 magic, u8 version, u8 type, u8 flags, u32 instance, u32 sequence,
+ *   u32 base sequence, u64 capture time (us, steady clock)
+ *
+ * A KEYFRAME is a whole snapshot. A DELTA holds only the player slots and
+ * fields that differ from the keyframe named by its base sequence, which is
+ * always one the receiver has acknowledged, so any single datagram can be
+ * decoded on its own: losing one never delays the next. Round and bomb
+ * state, and the events of the last few frames, are written whole in both.
+ * Receivers answer with ACK datagrams naming the newest keyframe they hold,
+ * and with a KEYFRAME_REQUEST naming the base of a delta they cannot decode
+ * (e.g. after a restart). Keyframes flagged REFRESH are not kept by the
+ * sender: receivers decode them but never keep or acknowledge them as bases.
+ */
+namespace UdpWire {
+
+constexpr uint16_t kMagic = 0x4353;  // "CS"
+constexpr uint8_t kVersion = 2;
+
+// Fits the smallest common path MTU with room for tunnels; a keyframe of
+// 32 players without names always fits
+constexpr size_t kMaxDatagramSize = 1200;
+constexpr size_t kHeaderSize = 25;
+
+enum PacketType : uint8_t {
+    KEYFRAME = 1,
+    DELTA = 2,
+    ACK = 3,
+    KEYFRAME_REQUEST = 4
+};
+
+enum Flags : uint8_t {
+    NAMES_OMITTED = 1u << 0,  // Names did not fit; the receiver keeps its own
+    REFRESH = 1u << 1         // Keyframe that is no base for deltas
+};
+
+struct Header {
+    uint8_t type;
+    uint8_t flags;
+    uint32_t instanceId;
+    uint32_t sequence;
+    uint32_t baseSequence;      // Keyframe a delta applies to, 0 for keyframes
+    uint64_t captureTimeUs;
+};
+
+/**
+ * @brief Read the header of a datagram
+ * @return false if it is not a datagram of this version
+ */
+bool readHeader(const uint8_t* data, size_t size, Header& outHeader);
+
+/**
+ * @brief Write an ACK datagram
+ * @return Size of the datagram
+ */
+size_t writeAck(uint32_t instanceId, uint32_t keyframeSequence, uint32_t highestSequence, uint8_t* out);
+
+/**
+ * @brief Read an ACK datagram
+ */
+bool readAck(const uint8_t* data, size_t size, uint32_t& instanceId, uint32_t& keyframeSequence,
+             uint32_t& highestSequence);
+
+/**
+ * @brief Write a KEYFRAME_REQUEST datagram
+ * @param missingBase Base sequence of the delta that could not be decoded
+ * @return Size of the datagram
+ */
+size_t writeKeyframeRequest(uint32_t instanceId, uint32_t missingBase, uint8_t* out);
+
+/**
+ * @brief Read a KEYFRAME_REQUEST datagram
+ */
+bool readKeyframeRequest(const uint8_t* data, size_t size, uint32_t& instanceId, uint32_t& missingBase);
+
+} // namespace UdpWire
+
+/**
+ * @brief Encodes the frames of one instance into keyframe/delta datagrams
+ *
+ * Until the receiver acknowledges a keyframe every datagram is a keyframe.
+ * After that frames are deltas against the newest acknowledged keyframe and
+ * a fresh keyframe is sent every kKeyframeInterval frames so deltas stay
+ * small as the match drifts away from the base.
+ *
+ * Only those periodic keyframes, and the first one after the base is lost,
+ * are kept as candidate bases; the keyframes in between go out as REFRESH.
+ * So the history spans kKeyframeHistory intervals, and an ack arriving
+ * many frames late still names a keyframe the encoder holds. The keyframe
+ * in use as base is never evicted.
+ */
+class UdpSnapshotEncoder {
+public:
+    static constexpr size_t kKeyframeHistory = 8;
+    static constexpr uint32_t kKeyframeInterval = 64;
+    static constexpr uint32_t kEventRepeatFrames = 8;   // Events survive this many losses in a row
+    static constexpr size_t kMaxRecentEvents = 16;
+
+    explicit UdpSnapshotEncoder(uint32_t instanceId);
+
+    /**
+     * @brief Encode the next frame
+     * @param state Captured game state
+     * @param out Buffer of at least UdpWire::kMaxDatagramSize bytes
+     * @return Size of the datagram
+     */
+    size_t encode(const GameState& state, uint8_t* out);
+
+    /**
+     * @brief Account for an ACK of the receiver
+     */
+    void onAck(uint32_t keyframeSequence);
+
+    /**
+     * @brief Account for a KEYFRAME_REQUEST of the receiver
+     *
+     * Drops the base if the request names it, so keyframes go out until the
+     * receiver acknowledges one. Requests naming an earlier base are late
+     * and ignored.
+     */
+    void onKeyframeRequest(uint32_t missingBase);
+
+    /**
+     * @brief Forget acknowledgements, e.g. when the receiver restarted
+     */
+    void reset();
+
+    uint32_t getSequence() const;
+    uint32_t getAckedKeyframe() const;  // 0 = none yet
+
+private:
+    struct Keyframe {
+        uint32_t sequence;
+        PlayerTable players;
+    };
+
+    struct RecentEvent {
+        GameEvent event;
+        uint32_t frameSequence;
+    };
+
+    const Keyframe* findKeyframe(uint32_t sequence) const;
+
+    uint32_t instanceId_;
+    uint32_t sequence_;
+    uint32_t lastKeyframeKept_;     // Newest candidate base, 0 = none since the base was lost
+    uint32_t ackedKeyframe_;
+
+    Keyframe keyframes_[kKeyframeHistory];
+    size_t nextKeyframe_;
+
+    // Events of the last frames with their global numbering
+    RecentEvent recentEvents_[kMaxRecentEvents];
+    uint32_t eventCount_;
+};
+
+/**
+ * @brief Result of decoding one datagram
+ */
+enum class UdpDecodeResult {
+    UPDATED,        // State now reflects the datagram
+    STALE,          // Older than the state already decoded (reordered)
+    MISSING_BASE,   // Delta against a keyframe that was never received
+    MALFORMED
+};
+
+/**
+ * @brief Rebuilds the game state of one instance from its datagrams
+ */
+class UdpSnapshotDecoder {
+public:
+    static constexpr size_t kKeyframeHistory = 8;
+    static constexpr uint32_t kRestartWindow = 1024;  // Keyframes this far back restart the stream
+
+    UdpSnapshotDecoder();
+
+    /**
+     * @brief Apply one KEYFRAME or DELTA datagram
+     * @param data Datagram
+     * @param size Datagram size
+     * @param header Header read with UdpWire::readHeader()
+     */
+    UdpDecodeResult decode(const uint8_t* data, size_t size, const UdpWire::Header& header);
+
+    /**
+     * @brief Decoded state; events are those first seen in the last update
+     */
+    const GameState& getState() const;
+
+    uint32_t getSequence() const;           // Sequence of the decoded state
+    uint32_t getNewestKeyframe() const;     // Newest base keyframe, 0 = none received
+    uint64_t getLostCount() const;          // Sequence gaps
+    uint64_t getMissedEventCount() const;   // Events lost beyond the repeat window
+
+private:
+    struct Keyframe {
+        uint32_t sequence;
+        PlayerTable players;
+    };
+
+    const Keyframe* findKeyframe(uint32_t sequence) const;
+
+    GameState state_;
+    uint32_t sequence_;
+    uint32_t newestKeyframe_;
+    Keyframe keyframes_[kKeyframeHistory];
+    size_t nextKeyframe_;
+
+    bool eventsSynced_;
+    uint32_t nextEvent_;
+    uint64_t lost_;
+    uint64_t missedEvents_;
+};
+
+} // namespace CS16Capture
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "game_types.h"
+#include "udp_codec.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Counters of a UdpClient
+ */
+struct UdpClientStats {
+    uint64_t datagrams;
+    uint64_t keyframes;
+    uint64_t bytes;
+    uint64_t sendCalls;   // sendmmsg()/sendto() calls, less than datagrams when batching
+    uint64_t acks;
+    uint64_t keyframeRequests;
+    uint64_t sendErrors;
+};
+
+/**
+ * @brief Low-latency alternative to WebSocketClient over UDP
+ *
+ * Each frame becomes one datagram of at most UdpWire::kMaxDatagramSize bytes
+ * that decodes on its own (see udp_codec.h), so a lost packet costs one
+ * frame instead of stalling the frames behind it as on TCP. Nothing is
+ * retransmitted. Acks arrive on the same socket and are drained on every
+ * send. Thread-safe.
+ *
+ * With a batch size above 1 datagrams are collected and handed to the
+ * kernel with one sendmmsg() call when the batch is full or on flush(),
+ * trading latency for fewer system calls.
+ */
+class UdpClient {
+public:
+    static constexpr size_t kMaxBatch = 32;
+
+    UdpClient();
+    ~UdpClient();
+
+    UdpClient(const UdpClient&) = delete;
+    UdpClient& operator=(const UdpClient&) = delete;
+
+    /**
+     * @brief Create the socket and set its destination
+     * @param host Receiver address (IPv4)
+     * @param port Receiver port
+     * @return true if the socket is ready
+     */
+    bool open(const std::string& host, int port);
+
+    /**
+     * @brief Flush pending datagrams and close the socket
+     */
+    void close();
+
+    bool isOpen() const;
+
+    /**
+     * @brief Set the number of datagrams sent per system call (1..kMaxBatch)
+     */
+    void setBatchSize(size_t batchSize);
+
+    /**
+     * @brief Encode a frame of an instance and send or queue it
+     * @return false on a send error
+     */
+    bool send(const GameState& state, uint32_t instanceId);
+
+    /**
+     * @brief Send the queued datagrams now
+     */
+    bool flush();
+
+    UdpClientStats getStats() const;
+
+private:
+    bool flushLocked();  // Requires mutex_
+    void drainAcks();    // Requires mutex_
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint32_t, std::unique_ptr<UdpSnapshotEncoder>> encoders_;
+
+    // Batch of datagrams waiting for one system call
+    std::vector<uint8_t> batch_;
+    size_t batchLengths_[kMaxBatch];
+    size_t batchCount_;
+    size_t batchSize_;
+
+    UdpClientStats stats_;
+
+#ifdef _WIN32
+    void* socket_;  // SOCKET type
+#else
+    int socket_;
+#endif
+};
+
+/**
+ * @brief Counters of a UdpReceiver
+ */
+struct UdpReceiverStats {
+    uint64_t datagrams;
+    uint64_t updates;
+    uint64_t stale;
+    uint64_t missingBase;
+    uint64_t malformed;
+    uint64_t lost;            // Sequence gaps over all instances
+    uint64_t missedEvents;
+    uint64_t acksSent;
+    uint64_t keyframeRequestsSent;
+    uint64_t simulatedDrops;  // Datagrams, acks and requests dropped by setSimulatedLoss()
+};
+
+/**
+ * @brief What receive() delivered
+ */
+struct UdpFrameInfo {
+    uint32_t instanceId;
+    uint32_t sequence;
+    bool keyframe;
+};
+
+/**
+ * @brief Local receiving end of UdpClient, for overlays and benchmarks
+ *
+ * Decodes the datagrams of every instance and acknowledges keyframes (and
+ * every kAckInterval-th frame, so a lost ack is repaired quickly). A delta
+ * against a keyframe it does not hold, e.g. after a restart, is answered
+ * with a keyframe request. A simulated loss rate drops incoming datagrams
+ * and outgoing acks and requests at random to measure the transport on a
+ * perfect local network.
+ */
+class UdpReceiver {
+public:
+    static constexpr uint32_t kAckInterval = 16;
+
+    UdpReceiver();
+    ~UdpReceiver();
+
+    UdpReceiver(const UdpReceiver&) = delete;
+    UdpReceiver& operator=(const UdpReceiver&) = delete;
+
+    /**
+     * @brief Bind to a local port
+     * @param port Port to listen on, 0 for any free port (see getPort())
+     */
+    bool bind(int port);
+
+    void close();
+
+    /**
+     * @brief Get the bound port
+     */
+    int getPort() const;
+
+    /**
+     * @brief Drop this fraction of datagrams and acks (0..1)
+     */
+    void setSimulatedLoss(double rate, uint32_t seed = 1);
+
+    /**
+     * @brief Wait for the next datagram that updates a state
+     * @param timeoutMs Longest wait
+     * @param outInfo Instance and sequence of the update
+     * @return Decoded state of the instance, or nullptr on timeout. Valid
+     *         until the next call.
+     */
+    const GameState* receive(int timeoutMs, UdpFrameInfo& outInfo);
+
+    UdpReceiverStats getStats() const;
+
+private:
+    void sendAck(const UdpWire::Header& header, const UdpSnapshotDecoder& decoder, const void* address,
+                 size_t addressLength);
+    void sendKeyframeRequest(const UdpWire::Header& header, const void* address, size_t addressLength);
+
+    /**
+     * @brief Send an ack or request unless the simulated loss drops it
+     * @return false if it was dropped
+     */
+    bool sendControl(const uint8_t* data, size_t length, const void* address, size_t addressLength);
+
+    std::unordered_map<uint32_t, std::unique_ptr<UdpSnapshotDecoder>> decoders_;
+    UdpReceiverStats stats_;
+    double lossRate_;
+    std::mt19937 random_;
+    int port_;
+    std::vector<uint8_t> buffer_;
+
+#ifdef _WIN32
+    void* socket_;  // SOCKET type
+#else
+    int socket_;
+#endif
+};
+
+} // namespace CS16Capture
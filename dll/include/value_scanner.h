@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "memory_reader.h"
+#include "thread_pool.h"
+
+namespace CS16Capture {
+
+/**
+ * @brief Kind of value searched for
+ */
+enum class ScanValueType {
+    INT32,
+    FLOAT,
+    STRING
+};
+
+/**
+ * @brief How a next scan compares a candidate with its value of the previous scan
+ */
+enum class ScanCompare {
+    CHANGED,
+    UNCHANGED,
+    INCREASED,
+    DECREASED
+};
+
+/**
+ * @brief Figures of the last scan
+ */
+struct ScanStats {
+    uint64_t bytesRead;
+    uint64_t unreadableBytes;   // Pages that vanished or could not be read
+    uint64_t candidates;
+    size_t bitmapRegions;
+    size_t listRegions;
+    double elapsedMs;
+};
+
+/**
+ * @brief First-scan/next-scan search for values in the writable memory of a process
+ *
+ * The offset-discovery loop of MEMORY_OFFSETS_GUIDE.md without Cheat Engine:
+ * a first scan finds every address holding a value, next scans keep those
+ * whose value is now equal to a new one, or changed, increased, ... since the
+ * previous scan, until a handful of addresses is left.
+ *
+ * Numbers are searched at 4-byte alignment, strings at any byte. Regions are
+ * split into chunks scanned in parallel with branch-free compare loops the
+ * compiler vectorizes. Candidates of a region are kept as a bitmap over its
+ * slots plus a copy of its bytes while dense, and as a sorted list of slots
+ * with their last values once fewer than 1 in kListDensity slots match, so a
+ * first scan for 0 and one for a rare value both stay affordable.
+ * Not thread-safe; scans themselves use the internal pool.
+ */
+class ValueScanner {
+public:
+    static constexpr size_t kChunkSize = 1 << 20;
+    static constexpr size_t kListDensity = 16;
+    static constexpr size_t kListTaskSize = 16384;     // Candidates per task of a list region
+    static constexpr size_t kReadWindow = 64 * 1024;   // Span read at once around listed candidates
+
+    /**
+     * @param reader Reader attached to the process to scan
+     * @param threadCount Scan threads (0 = one per hardware thread)
+     */
+    explicit ValueScanner(MemoryReader& reader, size_t threadCount = 0);
+    ~ValueScanner();
+
+    ValueScanner(const ValueScanner&) = delete;
+    ValueScanner& operator=(const ValueScanner&) = delete;
+
+    /**
+     * @brief Start over with every writable address holding a value
+     * @return false if the memory map could not be read
+     */
+    bool firstScanInt(int32_t value);
+    bool firstScanFloat(float value, float tolerance = 0.01f);
+    bool firstScanString(const std::string& value);
+
+    /**
+     * @brief Keep the candidates now holding a value
+     * @return false without a first scan of the same type
+     */
+    bool nextScanInt(int32_t value);
+    bool nextScanFloat(float value);  // Uses the tolerance of the first scan
+    bool nextScanString(const std::string& value);
+
+    /**
+     * @brief Keep the candidates whose value compares so with the previous scan
+     *
+     * Strings only support CHANGED and UNCHANGED, compared with the text
+     * searched last.
+     */
+    bool nextScan(ScanCompare compare);
+
+    /**
+     * @brief Drop all candidates
+     */
+    void reset();
+
+    bool hasScan() const;
+    ScanValueType getValueType() const;
+    uint64_t getCandidateCount() const;
+
+    /**
+     * @brief Get candidate addresses in ascending order
+     * @param outAddresses Receives up to limit addresses
+     * @param limit Most addresses to return
+     */
+    void getCandidates(std::vector<uintptr_t>& outAddresses, size_t limit) const;
+
+    const ScanStats& getLastStats() const;
+
+private:
+    struct Region;
+    struct ChunkResult;
+    struct Matcher;
+
+    bool runScan(const Matcher& matcher, bool first);
+    void scanBitmapChunk(const Matcher& matcher, Region& region, ChunkResult& result, bool first);
+    void scanListRange(const Matcher& matcher, const Region& region, ChunkResult& result);
+    void scanStringChunk(const Matcher& matcher, const Region& region, ChunkResult& result);
+    void finishRegion(Region& region, std::vector<ChunkResult>& chunks);
+    void runTasks(std::vector<ThreadPool::Task>& tasks);
+
+    MemoryReader& reader_;
+    std::unique_ptr<ThreadPool> pool_;
+
+    std::vector<Region> regions_;
+    bool hasScan_;
+    ScanValueType type_;
+    float tolerance_;
+    std::string lastText_;
+    ScanStats stats_;
+};
+
+} // namespace CS16Capture
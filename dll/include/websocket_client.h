@@ -5,13 +5,42 @@
 #include <atomic>
 #include <thread>
 #include <mutex>
-#include <queue>
+#include <vector>
+#include <condition_variable>
+#include <cstdint>
 #include "game_types.h"
+#include "latency_tracker.h"
+#include "send_lanes.h"
+#include "state_encoder.h"
+#include "stream_compressor.h"
+#include "subscription.h"
 
 namespace CS16Capture {
 
 /**
  * @brief WebSocket client for sending game data
+ *
+ * Frames are newline-delimited JSON in both directions; the server may send
+ * subscribe messages to narrow what it receives (see subscription.h).
+ *
+ * Once a second the client sends {"type":"ping","id":N,"t":us} and expects
+ * {"type":"pong","id":N,"t":us,"serverTime":us} back, "t" echoed and
+ * "serverTime" read from any server clock in microseconds. The round trips
+ * give the clock offset and the delivery latency of frames, which the client
+ * reports every few seconds in a {"type":"latency",...} message. Servers that
+ * never answer pings get neither. The same message also carries the frames
+ * the send queue dropped or superseded on this connection; it goes out within
+ * a quarter second of those counters changing, pong or not, and then holds
+ * only "samples", "dropped" and "superseded" until a pong gives a clock offset.
+ *
+ * Outgoing messages wait in priority lanes (see SendLanes): frames with
+ * events or names go ahead of plain state frames, which go ahead of match
+ * statistics, and a queued state frame is replaced by the next frame of its
+ * stream instead of both going out late on a congested link.
+ *
+ * With compression set, the connection starts with a hello line and
+ * everything after it goes out as records of one compressed stream (see
+ * stream_compressor.h); the server's messages stay plain.
  */
 class WebSocketClient {
 public:
@@ -27,7 +56,7 @@ public:
     bool connect(const std::string& host, int port);
 
     /**
-     * @brief Disconnect from the WebSocket server
+     * @brief Disconnect from the WebSocket server and stop reconnecting
      */
     void disconnect();
 
@@ -47,12 +76,50 @@ public:
     /**
      * @brief Send a raw JSON message
      * @param jsonMessage JSON message to send
+     * @param lane Priority lane of the message
      * @return true if send was successful
      */
-    bool sendMessage(const std::string& jsonMessage);
+    bool sendMessage(const std::string& jsonMessage, SendLane lane = SendLane::STATE);
+
+    /**
+     * @brief Queue a message without copying it
+     *
+     * Use a buffer from acquireBuffer() to avoid allocations: the queue hands
+     * back a previously sent buffer of similar capacity in exchange.
+     * @param message Message to send; left in an unspecified state
+     * @param captureTimeNs Capture time of the frame it carries (steady
+     *        clock, 0 = not a frame), used to measure delivery latency
+     * @param lane Priority lane of the message
+     * @return true if the message was queued
+     */
+    bool sendMessage(std::string&& message, uint64_t captureTimeNs = 0, SendLane lane = SendLane::STATE);
+
+    /**
+     * @brief Queue a frame just written by an encoder
+     *
+     * The encoder tells the lane (events lane for frames with events or
+     * names) and which queued frame of the stream the new one supersedes.
+     * @param frame Frame to send; left in an unspecified state
+     * @param encoder Encoder that wrote the frame; takes it back with
+     *        StateEncoder::discardFrame() when it cannot be queued
+     * @param captureTimeNs Capture time of the frame (steady clock)
+     * @param stream Capture stream of the frame, e.g. the instance (non-zero)
+     * @return true if the frame was queued; false when disconnected, the
+     *         frame was encoded for an earlier connection or the events
+     *         lane is full
+     */
+    bool sendFrame(std::string&& frame, StateEncoder& encoder, uint64_t captureTimeNs, uint64_t stream);
+
+    /**
+     * @brief Get an empty buffer that kept the capacity of an earlier message
+     */
+    std::string acquireBuffer();
 
     /**
      * @brief Set auto-reconnect on disconnect
+     *
+     * Reconnects happen on a background thread with exponential backoff;
+     * messages sent meanwhile fail at once instead of waiting for it.
      * @param enable Enable/disable auto-reconnect
      */
     void setAutoReconnect(bool enable);
@@ -63,16 +130,73 @@ public:
      */
     size_t getPendingMessageCount() const;
 
-private:
     /**
-     * @brief Convert game state to JSON string
+     * @brief Compress what is sent from the next connect() on
+     * @return false if the codec was not compiled in; nothing changes then
+     */
+    bool setCompression(const CompressionConfig& config);
+
+    /**
+     * @brief Set the bounds and scheduling of the send lanes
+     *
+     * Call before connect(): messages still queued are dropped.
+     */
+    void setLaneConfig(const SendLaneConfig& config);
+
+    /**
+     * @brief Get the number of messages dropped because their lane was full
      */
-    std::string gameStateToJson(const GameState& state);
+    uint64_t getDroppedMessageCount() const;
 
     /**
-     * @brief Convert game event to string
+     * @brief Get the number of state frames replaced by a newer one while queued
      */
-    std::string gameEventToString(GameEvent event);
+    uint64_t getSupersededMessageCount() const;
+
+    /**
+     * @brief Get the counters of one send lane
+     */
+    SendLaneStats getLaneStats(SendLane lane) const;
+
+    /**
+     * @brief Get round-trip time, clock offset and capture-to-delivery latency
+     */
+    LatencyStats getLatencyStats() const;
+
+    /**
+     * @brief Get the number of successful connects so far
+     *
+     * Encoders compare it between frames: a change means the server lost any
+     * per-connection state such as already sent names.
+     */
+    uint64_t getConnectionGeneration() const;
+
+    /**
+     * @brief Get the version of the subscription sent by the server
+     *
+     * Bumped on every accepted subscribe message and on every new connection
+     * (which falls back to the default subscription).
+     */
+    uint64_t getSubscriptionVersion() const;
+
+    /**
+     * @brief Get the subscription sent by the server of this connection
+     */
+    Subscription getSubscription() const;
+
+    /**
+     * @brief Hand the current subscription to an encoder if it has changed
+     */
+    void applySubscription(StateEncoder& encoder) const;
+
+private:
+    static constexpr size_t kMaxFreeBuffers = 64;
+    static constexpr size_t kMaxReceiveLine = 64 * 1024;
+    static constexpr uint64_t kPingIntervalUs = 1000000;
+    static constexpr uint64_t kLatencyReportIntervalUs = 5000000;
+    static constexpr uint64_t kCountersReportIntervalUs = 250000;
+    static constexpr uint32_t kReconnectInitialDelayMs = 500;
+    static constexpr uint32_t kReconnectMaxDelayMs = 30000;
 
     /**
      * @brief Background thread for sending messages
@@ -80,23 +204,95 @@ private:
     void sendThreadFunc();
 
     /**
-     * @brief Attempt to reconnect
+     * @brief Background thread reading newline-delimited server messages
+     */
+    void receiveThreadFunc();
+
+    /**
+     * @brief Act on one message received from the server
+     */
+    void handleServerMessage(const std::string& line);
+
+    /**
+     * @brief Queue a message into its lane
+     * @param generation Connection a frame was encoded for (0 = any); frames
+     *        of an earlier connection are refused
+     */
+    bool enqueue(std::string& message, uint64_t captureTimeNs, SendLane lane, uint64_t stream, uint32_t topics,
+                 uint64_t generation);
+
+    /**
+     * @brief Write a message to the socket, as a record when compressing
+     */
+    bool writeMessage(const char* data, size_t length);
+
+    /**
+     * @brief Write a whole message to the socket
      */
-    bool tryReconnect();
+    bool sendBytes(const char* data, size_t length);
+
+    void releaseBuffer(std::string& buffer);
+    void recycleBuffer(std::string& buffer);  // Requires queueMutex_
+
+    /**
+     * @brief Stop the send and receive threads and close the socket
+     */
+    void closeConnection();
+
+    /**
+     * @brief Start the reconnect thread unless it is already running
+     */
+    void requestReconnect();
+
+    /**
+     * @brief Background thread reconnecting until it succeeds or is stopped
+     */
+    void reconnectThreadFunc();
 
     std::atomic<bool> connected_;
     std::atomic<bool> autoReconnect_;
     std::atomic<bool> shouldStop_;
+    std::atomic<uint64_t> connectionGeneration_;
     
     std::string host_;
     int port_;
 
-    // Message queue for async sending
-    std::queue<std::string> messageQueue_;
-    std::mutex queueMutex_;
+    // Reconnects run on their own thread so senders never wait for the server
+    std::unique_ptr<std::thread> reconnectThread_;
+    std::atomic<bool> reconnecting_;
+    bool stopReconnect_;                // Guarded by reconnectMutex_
+    std::mutex reconnectMutex_;
+    std::condition_variable reconnectCondition_;
+
+    // Encoder of sendGameState()
+    StateEncoder encoder_;
+    std::mutex encoderMutex_;
+
+    // Pending messages by priority; slots keep their capacity for reuse
+    SendLanes lanes_;
+    std::vector<std::string> freeBuffers_;
+    mutable std::mutex queueMutex_;
+    // Lane counters when this connection started; reports count from them
+    uint64_t droppedAtConnect_;
+    uint64_t supersededAtConnect_;
+    std::condition_variable queueCondition_;
+    
+    // Subscription of the connected server, guarded by subscriptionMutex_
+    Subscription subscription_;
+    std::atomic<uint64_t> subscriptionVersion_;
+    mutable std::mutex subscriptionMutex_;
+
+    // Ping round trips and frame delivery times of this connection
+    LatencyTracker latency_;
+    
+    // Compressed stream of this connection; used by connect() and the send thread
+    CompressionConfig compression_;
+    StreamCompressor compressor_;
+    std::string record_;
     
-    // Send thread
+    // Send and receive threads
     std::unique_ptr<std::thread> sendThread_;
+    std::unique_ptr<std::thread> receiveThread_;
 
 #ifdef _WIN32
     // Windows socket handle
@@ -0,0 +1,168 @@
+#include "../include/capture_rate_policy.h"
+#include "../include/logger.h"
+#include <bitset>
+
+namespace CS16Capture {
+
+namespace {
+
+const int32_t kTerrorist = 1;
+const int32_t kCounterTerrorist = 2;
+
+const char* phaseName(CapturePhase phase) {
+    switch (phase) {
+        case CapturePhase::QUIET: return "quiet";
+        case CapturePhase::ACTIVE: return "active";
+        case CapturePhase::CRITICAL: return "critical";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+CaptureRatePolicy::CaptureRatePolicy(const CaptureRateConfig& config)
+    : config_(config)
+    , phase_(CapturePhase::ACTIVE)
+    , previousRound_(0)
+    , hasPrevious_(false)
+    , previousRoundTime_(0.0f)
+    , timerStart_(0.0f)
+    , calmerPending_(false)
+    , stats_()
+{
+}
+
+void CaptureRatePolicy::reset() {
+    phase_ = CapturePhase::ACTIVE;
+    hasPrevious_ = false;
+    previousRoundTime_ = 0.0f;
+    timerStart_ = 0.0f;
+    calmerPending_ = false;
+    lastDeath_ = Clock::time_point();
+    priorDeath_ = Clock::time_point();
+}
+
+CapturePhase CaptureRatePolicy::getPhase() const {
+    return phase_;
+}
+
+std::chrono::milliseconds CaptureRatePolicy::getInterval() const {
+    switch (phase_) {
+        case CapturePhase::QUIET: return std::chrono::milliseconds(config_.slowestIntervalMs);
+        case CapturePhase::CRITICAL: return std::chrono::milliseconds(config_.fastestIntervalMs);
+        case CapturePhase::ACTIVE: break;
+    }
+    return std::chrono::milliseconds(config_.baseIntervalMs);
+}
+
+const CaptureRateStats& CaptureRatePolicy::getStats() const {
+    return stats_;
+}
+
+std::chrono::milliseconds CaptureRatePolicy::onCapture(const GameState& state, Clock::time_point now) {
+    CapturePhase target = classify(state, now);
+
+    if (target > phase_) {
+        // Speed up at once
+        phase_ = target;
+        calmerPending_ = false;
+        ++stats_.phaseChanges;
+        LOG_DEBUG(std::string("Capture phase ") + phaseName(phase_));
+    } else if (target < phase_) {
+        if (!calmerPending_) {
+            calmerPending_ = true;
+            calmerSince_ = now;
+        } else if (now - calmerSince_ >= std::chrono::milliseconds(config_.holdMs)) {
+            phase_ = target;
+            calmerPending_ = false;
+            ++stats_.phaseChanges;
+            LOG_DEBUG(std::string("Capture phase ") + phaseName(phase_));
+        }
+    } else {
+        calmerPending_ = false;
+    }
+
+    ++stats_.captures[static_cast<size_t>(phase_)];
+    return getInterval();
+}
+
+CapturePhase CaptureRatePolicy::classify(const GameState& state, Clock::time_point now) {
+    const PlayerTable& players = state.players;
+
+    // The round timer runs down through quiet stretches and purchases are
+    // fine at the slow rate, so neither counts as a change
+    bool changed = !hasPrevious_ || state.roundNumber != previousRound_ ||
+                   state.bomb.planted != previousBomb_.planted || state.bomb.defused != previousBomb_.defused ||
+                   players.presentMask != previousPlayers_.presentMask;
+    if (!changed) {
+        uint32_t slots = changedSlots(players.kills, previousPlayers_.kills) |
+                         changedSlots(players.deaths, previousPlayers_.deaths) |
+                         changedSlots(players.team, previousPlayers_.team) |
+                         changedSlots(players.alive, previousPlayers_.alive);
+        changed = (slots & players.presentMask) != 0;
+    }
+    if (changed) {
+        // Deaths in quick succession are a fight: trades and multi-kills
+        uint32_t died = increasedSlots(previousPlayers_.alive, players.alive) &
+                        players.presentMask & previousPlayers_.presentMask;
+        if (hasPrevious_ && died != 0) {
+            priorDeath_ = std::bitset<32>(died).count() > 1 ? now : lastDeath_;
+            lastDeath_ = now;
+        }
+        lastChange_ = now;
+        previousPlayers_ = players;
+        previousBomb_ = state.bomb;
+        previousRound_ = state.roundNumber;
+        hasPrevious_ = true;
+    }
+
+    // A timer jumping up starts a new count: freezetime or the round proper
+    bool timerRunning = state.roundTime != previousRoundTime_;
+    if (state.roundTime > previousRoundTime_) {
+        timerStart_ = state.roundTime;
+    }
+    previousRoundTime_ = state.roundTime;
+
+    if (state.bomb.planted && !state.bomb.defused) {
+        return CapturePhase::CRITICAL;
+    }
+
+    // Fights and clutches only matter while the round runs, not once it is decided
+    const auto fightWindow = std::chrono::milliseconds(config_.fightWindowMs);
+    if (timerRunning && lastDeath_ != Clock::time_point() && lastDeath_ - priorDeath_ <= fightWindow &&
+        now - lastDeath_ <= fightWindow) {
+        return CapturePhase::CRITICAL;
+    }
+
+    // A clutch: one side lost players and is down to a few, the other still stands
+    int32_t present[3] = {0, 0, 0};
+    int32_t alive[3] = {0, 0, 0};
+    for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+        int32_t team = players.team[slot];
+        if (players.isPresent(slot) && (team == kTerrorist || team == kCounterTerrorist)) {
+            ++present[team];
+            alive[team] += players.alive[slot] ? 1 : 0;
+        }
+    }
+    for (int32_t team = kTerrorist; team <= kCounterTerrorist; ++team) {
+        int32_t other = kTerrorist + kCounterTerrorist - team;
+        if (timerRunning && alive[team] > 0 && alive[team] < present[team] && alive[team] <= config_.clutchAlivePlayers &&
+            alive[other] > 0) {
+            return CapturePhase::CRITICAL;
+        }
+    }
+
+    // A running round can be quiet and still turn any second; only a stopped
+    // timer (warmup, freezetime, round over) or the buy window may slow down.
+    // The last seconds decide the round, and the freezetime countdown can
+    // look the same, so they only keep a game ACTIVE
+    bool buyWindow = timerStart_ - state.roundTime < config_.buyWindowSeconds;
+    bool roundEnding = state.roundTime > 0.0f && state.roundTime <= config_.roundEndSeconds;
+    if ((!timerRunning || buyWindow) && !roundEnding &&
+        now - lastChange_ >= std::chrono::milliseconds(config_.quietAfterMs)) {
+        return CapturePhase::QUIET;
+    }
+    return CapturePhase::ACTIVE;
+}
+
+} // namespace CS16Capture
@@ -0,0 +1,221 @@
+#include "../include/collector.h"
+#include "../include/logger.h"
+#include <algorithm>
+
+namespace CS16Capture {
+
+namespace {
+
+// Upper bound on scheduler sleep so stop() is noticed promptly
+const std::chrono::milliseconds kMaxSchedulerSleep(50);
+
+// Consecutive failed ticks before an instance is re-attached
+const uint32_t kMaxFailedTicks = 50;
+
+} // namespace
+
+Collector::Collector(const CollectorConfig& config)
+    : config_(config)
+    , watcher_(config.processNames)
+    , running_(false)
+{
+    rateConfig_.baseIntervalMs = config.captureIntervalMs;
+    rateConfig_.fastestIntervalMs = std::min(config.fastestIntervalMs, config.captureIntervalMs);
+    rateConfig_.slowestIntervalMs = std::max(config.slowestIntervalMs, config.captureIntervalMs);
+}
+
+Collector::~Collector() {
+    stop();
+}
+
+bool Collector::start() {
+    if (running_) {
+        return true;
+    }
+
+    // Every instance would stream empty states forever
+    if (!config_.offsets.hasSection()) {
+        LOG_ERROR("No base address or pointer chain configured for players, bomb or round; nothing to capture");
+        return false;
+    }
+
+    SendLaneConfig lanes;
+    lanes.scheduling = config_.laneScheduling;
+    client_.setLaneConfig(lanes);
+    if (config_.compression.codec != CompressionCodec::NONE) {
+        // Falls back to plain frames when the codec is missing from the build
+        client_.setCompression(config_.compression);
+    }
+    if (!client_.connect(config_.host, config_.port)) {
+        LOG_WARNING("Collector starting without a connection; frames are dropped until reconnect");
+    }
+    if (config_.udpPort != 0 && udp_.open(config_.host, config_.udpPort)) {
+        udp_.setBatchSize(config_.udpBatchSize);
+    }
+
+    pool_ = std::make_unique<ThreadPool>(config_.workerThreads);
+    running_ = true;
+    schedulerThread_ = std::make_unique<std::thread>(&Collector::schedulerLoop, this);
+
+    LOG_INFO("Collector started, capture interval " + std::to_string(config_.captureIntervalMs) + "ms" +
+             (config_.adaptiveRate ? " (adaptive " + std::to_string(rateConfig_.fastestIntervalMs) + "-" +
+                                     std::to_string(rateConfig_.slowestIntervalMs) + "ms)" : ""));
+    return true;
+}
+
+void Collector::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    if (schedulerThread_ && schedulerThread_->joinable()) {
+        schedulerThread_->join();
+    }
+    schedulerThread_.reset();
+
+    // Let in-flight ticks finish before tearing down the transport
+    pool_->shutdown();
+    pool_.reset();
+    client_.disconnect();
+    udp_.close();
+
+    std::lock_guard<std::mutex> lock(instancesMutex_);
+    instances_.clear();
+
+    LOG_INFO("Collector stopped");
+}
+
+bool Collector::isRunning() const {
+    return running_;
+}
+
+size_t Collector::getInstanceCount() const {
+    std::lock_guard<std::mutex> lock(instancesMutex_);
+    return instances_.size();
+}
+
+void Collector::schedulerLoop() {
+    const auto scanInterval = std::chrono::milliseconds(config_.scanIntervalMs);
+    Clock::time_point nextScan = Clock::now();
+
+    while (running_) {
+        Clock::time_point now = Clock::now();
+        if (now >= nextScan) {
+            refreshInstances();
+            nextScan = now + scanInterval;
+        }
+
+        Clock::time_point wakeUp = std::min(nextScan, now + kMaxSchedulerSleep);
+        {
+            std::lock_guard<std::mutex> lock(instancesMutex_);
+            for (auto& entry : instances_) {
+                std::shared_ptr<Instance> instance = entry.second;
+
+                // Read every pass so a faster rate applies before the slower tick was due
+                const auto captureInterval = std::chrono::milliseconds(instance->intervalMs.load());
+                Clock::time_point due = instance->lastTick + captureInterval;
+                if (now >= due) {
+                    // Keep the cadence; if we fell behind, skip ahead instead of bursting
+                    instance->lastTick = now - due < captureInterval ? due : now;
+
+                    // A slow previous tick still owns the instance: skip this one
+                    if (!instance->busy.exchange(true)) {
+                        pool_->submit([this, instance] { captureTick(instance); });
+                    }
+                }
+
+                wakeUp = std::min(wakeUp, instance->lastTick + captureInterval);
+            }
+        }
+
+        if (config_.udpBatchSize > 1) {
+            udp_.flush();
+        }
+        std::this_thread::sleep_until(wakeUp);
+    }
+}
+
+void Collector::refreshInstances() {
+    std::vector<uint32_t> started;
+    std::vector<uint32_t> exited;
+    watcher_.poll(started, exited);
+
+    std::vector<std::shared_ptr<Instance>> failed;
+    {
+        std::lock_guard<std::mutex> lock(instancesMutex_);
+        for (uint32_t processId : exited) {
+            if (instances_.erase(processId) > 0) {
+                LOG_INFO("Game instance " + std::to_string(processId) + " exited");
+            }
+        }
+
+        for (auto& entry : instances_) {
+            if (entry.second->failedTicks >= kMaxFailedTicks && !entry.second->busy) {
+                failed.push_back(entry.second);
+            }
+        }
+        for (const auto& instance : failed) {
+            instances_.erase(instance->processId);
+        }
+    }
+
+    // Offsets may have moved (e.g., game module reloaded): attach from scratch
+    for (const auto& instance : failed) {
+        LOG_WARNING("Game instance " + std::to_string(instance->processId) + " keeps failing, re-attaching");
+        started.push_back(instance->processId);
+    }
+
+    for (uint32_t processId : started) {
+        auto instance = std::make_shared<Instance>(processId, rateConfig_);
+
+        // The game module may not be loaded yet right after process start
+        if (!instance->capture.initialize(processId, config_.offsets)) {
+            watcher_.forget(processId);
+            continue;
+        }
+        if (config_.softDirtyTracking) {
+            // Plain reads still work if the kernel does not track soft-dirty pages
+            instance->capture.enableSoftDirtyTracking();
+        }
+
+        if (!config_.snapshotRing.empty()) {
+            // Local consumers are optional: keep capturing without the ring
+            instance->snapshots.create(config_.snapshotRing + "-" + std::to_string(processId));
+        }
+
+        std::lock_guard<std::mutex> lock(instancesMutex_);
+        instances_[processId] = instance;
+        LOG_INFO("Attached to game instance " + std::to_string(processId) +
+                 " (" + std::to_string(instances_.size()) + " total)");
+    }
+}
+
+void Collector::captureTick(const std::shared_ptr<Instance>& instance) {
+    if (instance->capture.captureGameState(instance->state)) {
+        instance->failedTicks = 0;
+        if (config_.adaptiveRate) {
+            auto interval = instance->ratePolicy.onCapture(instance->state, Clock::now());
+            instance->intervalMs = static_cast<uint32_t>(interval.count());
+        }
+        instance->snapshots.publish(instance->state, instance->processId);
+        client_.applySubscription(instance->encoder);
+        std::string frame = client_.acquireBuffer();
+        instance->encoder.encode(instance->state, client_.getConnectionGeneration(), frame);
+        client_.sendFrame(std::move(frame), instance->encoder, instance->state.captureTimeNs, instance->processId);
+        instance->stats.update(instance->state);
+        instance->encoder.encodeStats(instance->stats, instance->state.nameTable, client_.getConnectionGeneration(),
+                                      instance->statsLine);
+        if (!instance->statsLine.empty()) {
+            client_.sendMessage(instance->statsLine, SendLane::STATS);
+        }
+        if (config_.udpPort != 0) {
+            udp_.send(instance->state, instance->processId);
+        }
+    } else {
+        ++instance->failedTicks;
+    }
+
+    instance->busy = false;
+}
+
+} // namespace CS16Capture
@@ -0,0 +1,146 @@
+#include "../include/collector.h"
+#include "../include/logger.h"
+#include "../include/offsets_config.h"
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void handleSignal(int) {
+    stopRequested = 1;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --host <address>     Server address (default 127.0.0.1)\n"
+              << "  --port <port>        Server port (default 8080)\n"
+              << "  --process <name>     Process name to attach to, repeatable (default hlds_linux)\n"
+              << "  --interval <ms>      Capture interval per instance (default 100)\n"
+              << "  --adaptive           Vary the interval with the game phase\n"
+              << "  --min-interval <ms>  Adaptive interval while critical (default 50)\n"
+              << "  --max-interval <ms>  Adaptive interval while quiet (default 500)\n"
+              << "  --offsets <file>     JSON memory offsets of the game build (see offsets_config.h)\n"
+              << "  --scan <ms>          Process scan interval (default 1000)\n"
+              << "  --threads <count>    Worker threads (default: one per core)\n"
+              << "  --shm <name>         Also publish to shared-memory rings <name>-<pid>\n"
+              << "  --udp <port>         Also send frames as UDP datagrams to <host>:<port>\n"
+              << "  --udp-batch <count>  Datagrams per sendmmsg() call (default 1)\n"
+              << "  --soft-dirty         Re-read only written pages of game memory (Linux)\n"
+              << "  --weighted-lanes     Share a congested link between event, state and stats lanes by weight\n"
+              << "                       instead of strict priority\n"
+              << "  --compress <codec>   Compress the uplink: deflate or zstd (default none)\n"
+              << "  --compress-level <n> Codec level (default: deflate 6, zstd 3)\n"
+              << "  --compress-threshold <bytes>  Send shorter messages plain (default 256)\n"
+              << "  --compress-dict <file>        Trained zstd dictionary\n"
+              << "  --debug              Enable debug logging\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    CS16Capture::CollectorConfig config;
+    bool customProcesses = false;
+    bool debug = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--host" && hasValue) {
+            config.host = argv[++i];
+        } else if (arg == "--port" && hasValue) {
+            config.port = std::atoi(argv[++i]);
+        } else if (arg == "--process" && hasValue) {
+            if (!customProcesses) {
+                config.processNames.clear();
+                customProcesses = true;
+            }
+            config.processNames.push_back(argv[++i]);
+        } else if (arg == "--interval" && hasValue) {
+            config.captureIntervalMs = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (arg == "--adaptive") {
+            config.adaptiveRate = true;
+        } else if (arg == "--min-interval" && hasValue) {
+            config.fastestIntervalMs = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (arg == "--max-interval" && hasValue) {
+            config.slowestIntervalMs = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (arg == "--offsets" && hasValue) {
+            std::ifstream file(argv[++i]);
+            if (!file) {
+                std::cerr << "Cannot read offsets: " << argv[i] << std::endl;
+                return 1;
+            }
+            std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            CS16Capture::JsonValue document;
+            std::string error;
+            if (!CS16Capture::JsonValue::parse(text, document, error) ||
+                !CS16Capture::parseMemoryOffsets(document, config.offsets, error)) {
+                std::cerr << "Invalid offsets in " << argv[i] << ": " << error << std::endl;
+                return 1;
+            }
+        } else if (arg == "--scan" && hasValue) {
+            config.scanIntervalMs = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (arg == "--threads" && hasValue) {
+            config.workerThreads = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (arg == "--shm" && hasValue) {
+            config.snapshotRing = argv[++i];
+        } else if (arg == "--udp" && hasValue) {
+            config.udpPort = std::atoi(argv[++i]);
+        } else if (arg == "--udp-batch" && hasValue) {
+            config.udpBatchSize = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (arg == "--soft-dirty") {
+            config.softDirtyTracking = true;
+        } else if (arg == "--compress" && hasValue) {
+            if (!CS16Capture::parseCompressionCodec(argv[++i], config.compression.codec)) {
+                std::cerr << "Unknown compression codec: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--compress-level" && hasValue) {
+            config.compression.level = std::atoi(argv[++i]);
+        } else if (arg == "--compress-threshold" && hasValue) {
+            config.compression.threshold = static_cast<size_t>(std::atoll(argv[++i]));
+        } else if (arg == "--compress-dict" && hasValue) {
+            std::ifstream file(argv[++i], std::ios::binary);
+            if (!file) {
+                std::cerr << "Cannot read compression dictionary: " << argv[i] << std::endl;
+                return 1;
+            }
+            config.compression.dictionary.assign(std::istreambuf_iterator<char>(file),
+                                                 std::istreambuf_iterator<char>());
+        } else if (arg == "--weighted-lanes") {
+            config.laneScheduling = CS16Capture::LaneScheduling::WEIGHTED;
+        } else if (arg == "--debug") {
+            debug = true;
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (config.captureIntervalMs == 0 || config.scanIntervalMs == 0 || config.fastestIntervalMs == 0) {
+        std::cerr << "Intervals must be positive" << std::endl;
+        return 1;
+    }
+
+    Logger::getInstance().setDebugEnabled(debug);
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    CS16Capture::Collector collector(config);
+    if (!collector.start()) {
+        return 1;
+    }
+
+    while (!stopRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    collector.stop();
+    return 0;
+}
@@ -1,38 +1,50 @@
 #include "cs16_capture.h"
 #include "logger.h"
 
-CS16Capture& CS16Capture::getInstance() {
-    static CS16Capture instance;
+namespace CS16Capture {
+
+CaptureSystem& CaptureSystem::getInstance() {
+    static CaptureSystem instance;
     return instance;
 }
 
-CS16Capture::CS16Capture()
+CaptureSystem::CaptureSystem()
     : initialized_(false) {
 }
 
-CS16Capture::~CS16Capture() {
+CaptureSystem::~CaptureSystem() {
     shutdown();
 }
 
-bool CS16Capture::initialize() {
+bool CaptureSystem::initialize() {
+    if (initialized_) {
+        return true;
+    }
+
     Logger::getInstance().logInfo("Initializing CS16 Capture system...");
+    if (!capture_.initialize()) {
+        Logger::getInstance().logError("Failed to initialize game data capture");
+        return false;
+    }
     initialized_ = true;
     Logger::getInstance().logInfo("CS16 Capture system initialized successfully");
     return true;
 }
 
-void CS16Capture::shutdown() {
+void CaptureSystem::shutdown() {
     if (initialized_) {
         Logger::getInstance().logInfo("Shutting down CS16 Capture system...");
         initialized_ = false;
     }
 }
 
-bool CS16Capture::captureGameData(GameData& outData) {
+bool CaptureSystem::captureGameData(GameState& outState) {
     if (!initialized_) {
         Logger::getInstance().logError("Capture system not initialized");
         return false;
     }
     
-    return true;
+    return capture_.captureGameState(outState);
 }
+
+} // namespace CS16Capture
@@ -0,0 +1,313 @@
+#include "../include/dirty_page_tracker.h"
+#include "../include/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace CS16Capture {
+
+namespace {
+
+// Weight of a new sample in the cost averages
+const double kCostSmoothing = 0.125;
+
+#ifndef _WIN32
+const uint64_t kPagePresent = 1ull << 63;
+const uint64_t kPageSwapped = 1ull << 62;
+const uint64_t kPageSoftDirty = 1ull << 55;
+
+/**
+ * @brief Check on a page of our own that writes after clear_refs show up
+ *
+ * Kernels built without CONFIG_MEM_SOFT_DIRTY accept clear_refs but never
+ * set the bit, which would make every page look clean forever.
+ */
+bool kernelTracksSoftDirty() {
+    long pageSize = sysconf(_SC_PAGESIZE);
+    void* page = mmap(nullptr, static_cast<size_t>(pageSize), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED) {
+        return false;
+    }
+    volatile char* bytes = static_cast<volatile char*>(page);
+    bytes[0] = 1;
+
+    bool tracked = false;
+    int clearRefs = open("/proc/self/clear_refs", O_WRONLY);
+    int pagemap = open("/proc/self/pagemap", O_RDONLY);
+    if (clearRefs >= 0 && pagemap >= 0 && write(clearRefs, "4", 1) == 1) {
+        bytes[0] = 2;
+        uint64_t entry = 0;
+        off_t offset = static_cast<off_t>(reinterpret_cast<uintptr_t>(page) / static_cast<uintptr_t>(pageSize) * 8);
+        tracked = pread(pagemap, &entry, sizeof(entry), offset) == sizeof(entry) && (entry & kPageSoftDirty) != 0;
+    }
+    if (clearRefs >= 0) {
+        close(clearRefs);
+    }
+    if (pagemap >= 0) {
+        close(pagemap);
+    }
+    munmap(page, static_cast<size_t>(pageSize));
+    return tracked;
+}
+#endif
+
+double elapsedMicros(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void addSample(double& average, double sample, bool first) {
+    average = first ? sample : average + (sample - average) * kCostSmoothing;
+}
+
+} // namespace
+
+DirtyPageTracker::DirtyPageTracker(MemoryReader& reader)
+    : reader_(reader)
+    , pagemapFd_(-1)
+    , clearRefsFd_(-1)
+    , pageSize_(4096)
+    , tracking_(false)
+    , ticksSinceResync_(0)
+    , ticksSinceProbe_(0)
+    , trackedSamples_(0)
+    , stats_()
+{
+#ifndef _WIN32
+    pageSize_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+DirtyPageTracker::~DirtyPageTracker() {
+#ifndef _WIN32
+    if (pagemapFd_ >= 0) {
+        close(pagemapFd_);
+    }
+    if (clearRefsFd_ >= 0) {
+        close(clearRefsFd_);
+    }
+#endif
+}
+
+bool DirtyPageTracker::enable() {
+#ifdef _WIN32
+    LOG_WARNING("Soft-dirty page tracking is only available on Linux");
+    return false;
+#else
+    if (isEnabled()) {
+        return true;
+    }
+
+    static const bool supported = kernelTracksSoftDirty();
+    if (!supported) {
+        LOG_WARNING("Kernel does not track soft-dirty pages, reading spans whole");
+        return false;
+    }
+
+    std::string proc = "/proc/" + std::to_string(reader_.getProcessId());
+    pagemapFd_ = open((proc + "/pagemap").c_str(), O_RDONLY | O_CLOEXEC);
+    clearRefsFd_ = open((proc + "/clear_refs").c_str(), O_WRONLY | O_CLOEXEC);
+    if (pagemapFd_ < 0 || clearRefsFd_ < 0) {
+        LOG_WARNING("Cannot open pagemap/clear_refs of " + proc + ", reading spans whole");
+        if (pagemapFd_ >= 0) {
+            close(pagemapFd_);
+        }
+        if (clearRefsFd_ >= 0) {
+            close(clearRefsFd_);
+        }
+        pagemapFd_ = -1;
+        clearRefsFd_ = -1;
+        return false;
+    }
+
+    // Probe on the first update
+    tracking_ = false;
+    ticksSinceProbe_ = kProbeInterval;
+    LOG_INFO("Soft-dirty page tracking enabled for process " + std::to_string(reader_.getProcessId()));
+    return true;
+#endif
+}
+
+bool DirtyPageTracker::isEnabled() const {
+    return pagemapFd_ >= 0;
+}
+
+size_t DirtyPageTracker::addSpan(uintptr_t address, size_t size) {
+    Span span;
+    span.address = address;
+    span.size = size;
+    span.stale = true;
+    span.data.resize(size);
+    spans_.push_back(std::move(span));
+    return spans_.size() - 1;
+}
+
+void DirtyPageTracker::setSpan(size_t span, uintptr_t address, size_t size) {
+    Span& target = spans_[span];
+    if (target.address != address || target.size != size) {
+        target.address = address;
+        target.size = size;
+        target.stale = true;
+        target.data.resize(size);
+    }
+}
+
+const uint8_t* DirtyPageTracker::getData(size_t span) const {
+    return spans_[span].data.data();
+}
+
+DirtyTrackingStats DirtyPageTracker::getStats() const {
+    DirtyTrackingStats stats = stats_;
+    stats.tracking = tracking_;
+    return stats;
+}
+
+bool DirtyPageTracker::update() {
+    ++stats_.ticks;
+    if (!isEnabled()) {
+        return readPlain(false);
+    }
+
+    if (!tracking_) {
+        if (++ticksSinceProbe_ < kProbeInterval) {
+            return readPlain(false);
+        }
+        tracking_ = true;
+        trackedSamples_ = 0;
+        return readPlain(true);
+    }
+
+    bool stale = false;
+    for (const Span& span : spans_) {
+        stale = stale || span.stale;
+    }
+    if (stale || ++ticksSinceResync_ >= kResyncInterval) {
+        return readPlain(true);
+    }
+
+    bool ok = readTracked();
+    if (tracking_ && trackedSamples_ >= kMinSamples && stats_.trackedCostUs > stats_.plainCostUs) {
+        LOG_DEBUG("Soft-dirty tracking costs " + std::to_string(stats_.trackedCostUs) + " us against " +
+                  std::to_string(stats_.plainCostUs) + " us for plain reads, switching to plain reads");
+        tracking_ = false;
+        ticksSinceProbe_ = 0;
+    }
+    return ok;
+}
+
+bool DirtyPageTracker::readPlain(bool clearFirst) {
+    // Clear before reading: anything written from here on is dirty next tick
+    if (clearFirst) {
+        ticksSinceResync_ = 0;
+        ++stats_.resyncs;
+        if (!clearSoftDirty()) {
+            tracking_ = false;
+            ticksSinceProbe_ = 0;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = true;
+    for (Span& span : spans_) {
+        if (span.address == 0 || span.size == 0) {
+            continue;
+        }
+        span.stale = !reader_.readBuffer(span.address, span.data.data(), span.size);
+        ok = ok && !span.stale;
+    }
+    addSample(stats_.plainCostUs, elapsedMicros(start), stats_.ticks == 1);
+    return ok;
+}
+
+bool DirtyPageTracker::readTracked() {
+#ifdef _WIN32
+    return readPlain(false);
+#else
+    auto start = std::chrono::steady_clock::now();
+    reads_.clear();
+    uint64_t pagesRead = 0;
+
+    for (size_t index = 0; index < spans_.size(); ++index) {
+        const Span& span = spans_[index];
+        if (span.address == 0 || span.size == 0) {
+            continue;
+        }
+
+        uintptr_t firstPage = span.address / pageSize_;
+        uintptr_t lastPage = (span.address + span.size - 1) / pageSize_;
+        size_t count = static_cast<size_t>(lastPage - firstPage + 1);
+        pagemap_.resize(count);
+        ssize_t bytes = pread(pagemapFd_, pagemap_.data(), count * sizeof(uint64_t),
+                              static_cast<off_t>(firstPage * sizeof(uint64_t)));
+        if (bytes != static_cast<ssize_t>(count * sizeof(uint64_t))) {
+            LOG_WARNING("Failed to read pagemap, falling back to plain reads");
+            tracking_ = false;
+            ticksSinceProbe_ = 0;
+            return readPlain(false);
+        }
+        stats_.pagesChecked += count;
+
+        // Runs of dirty pages, clipped to the span; pages that are not
+        // mapped in (e.g. after MADV_DONTNEED) may read differently too
+        for (size_t page = 0; page < count; ) {
+            uint64_t entry = pagemap_[page];
+            bool dirty = (entry & kPageSoftDirty) != 0 || (entry & (kPagePresent | kPageSwapped)) == 0;
+            if (!dirty) {
+                ++page;
+                continue;
+            }
+            size_t end = page + 1;
+            while (end < count && ((pagemap_[end] & kPageSoftDirty) != 0 ||
+                                   (pagemap_[end] & (kPagePresent | kPageSwapped)) == 0)) {
+                ++end;
+            }
+            uintptr_t from = std::max<uintptr_t>(span.address, (firstPage + page) * pageSize_);
+            uintptr_t to = std::min<uintptr_t>(span.address + span.size, (firstPage + end) * pageSize_);
+            reads_.push_back({index, static_cast<size_t>(from - span.address), static_cast<size_t>(to - from)});
+            pagesRead += end - page;
+            page = end;
+        }
+    }
+
+    if (!clearSoftDirty()) {
+        tracking_ = false;
+        ticksSinceProbe_ = 0;
+        return readPlain(false);
+    }
+
+    bool ok = true;
+    for (const PendingRead& read : reads_) {
+        Span& span = spans_[read.span];
+        if (!reader_.readBuffer(span.address + read.offset, span.data.data() + read.offset, read.size)) {
+            span.stale = true;
+            ok = false;
+        }
+    }
+
+    stats_.pagesRead += pagesRead;
+    ++stats_.trackedTicks;
+    addSample(stats_.trackedCostUs, elapsedMicros(start), trackedSamples_ == 0);
+    ++trackedSamples_;
+    return ok;
+#endif
+}
+
+bool DirtyPageTracker::clearSoftDirty() {
+#ifdef _WIN32
+    return false;
+#else
+    if (write(clearRefsFd_, "4", 1) != 1) {
+        LOG_WARNING("Failed to clear soft-dirty bits");
+        return false;
+    }
+    return true;
+#endif
+}
+
+} // namespace CS16Capture
@@ -8,12 +8,12 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserv
     switch (ul_reason_for_call) {
         case DLL_PROCESS_ATTACH: {
             Logger::getInstance().logInfo("DLL_PROCESS_ATTACH");
-            CS16Capture::getInstance().initialize();
+            CS16Capture::CaptureSystem::getInstance().initialize();
             break;
         }
         case DLL_PROCESS_DETACH: {
             Logger::getInstance().logInfo("DLL_PROCESS_DETACH");
-            CS16Capture::getInstance().shutdown();
+            CS16Capture::CaptureSystem::getInstance().shutdown();
             break;
         }
         case DLL_THREAD_ATTACH: {
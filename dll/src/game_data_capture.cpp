@@ -0,0 +1,327 @@
+#include "../include/game_data_capture.h"
+#include "../include/logger.h"
+#include <chrono>
+
+namespace CS16Capture {
+
+namespace {
+
+#ifdef _WIN32
+const char* const kGameModuleName = "hl.exe";
+#else
+const char* const kGameModuleName = "cs.so";
+#endif
+
+const size_t kNoPath = static_cast<size_t>(-1);
+
+// Initial event capacity; grows once on a busier frame and is kept
+const size_t kReservedEvents = 16;
+
+// Deaths of one player between two captures that still count as kills; a
+// larger jump is a torn or garbage read, or a score reset, not a massacre
+const int64_t kMaxDeathsPerCapture = 4;
+
+} // namespace
+
+GameDataCapture::GameDataCapture()
+    : memoryReader_(std::make_unique<MemoryReader>())
+    , resolver_(*memoryReader_)
+    , playerListPath_(kNoPath)
+    , bombPath_(kNoPath)
+    , gameStatePath_(kNoPath)
+    , playerDecoder_(&decodePlayersRuntime)
+    , playerSpanHandle_(0)
+    , moduleBase_(0)
+    , playerListAddress_(0)
+    , bombAddress_(0)
+    , gameStateAddress_(0)
+    , hasPreviousState_(false)
+    , isInitialized_(false)
+{
+}
+
+GameDataCapture::~GameDataCapture() {
+}
+
+bool GameDataCapture::initialize(uint32_t processId) {
+    if (isInitialized_) {
+        return true;
+    }
+
+    bool attached = (processId == 0) ? memoryReader_->initialize()
+                                     : memoryReader_->attach(processId);
+    if (!attached) {
+        return false;
+    }
+
+    if (!initializeOffsets()) {
+        LOG_ERROR("Failed to resolve offsets for process " + std::to_string(memoryReader_->getProcessId()));
+        return false;
+    }
+
+    isInitialized_ = true;
+    return true;
+}
+
+bool GameDataCapture::initialize(uint32_t processId, const MemoryOffsets& offsets) {
+    if (isInitialized_) {
+        return true;
+    }
+
+    bool attached = (processId == 0) ? memoryReader_->initialize()
+                                     : memoryReader_->attach(processId);
+    if (!attached) {
+        return false;
+    }
+
+    // Only look the module up when a flat base needs it; pointer chains name their own module
+    bool hasFlatBase = offsets.playerListBase != 0 || offsets.bombBase != 0 || offsets.gameStateBase != 0;
+    moduleBase_ = hasFlatBase ? memoryReader_->getModuleBase(kGameModuleName) : 0;
+    if (hasFlatBase && moduleBase_ == 0 && processId != 0) {
+        // Another process may not have loaded the game module yet; try again later
+        return false;
+    }
+
+    setOffsets(offsets);
+    isInitialized_ = true;
+    return true;
+}
+
+bool GameDataCapture::initializeOffsets() {
+    uintptr_t baseAddr = memoryReader_->getModuleBase(kGameModuleName);
+    if (baseAddr == 0) {
+        return false;
+    }
+    moduleBase_ = baseAddr;
+
+    offsets_ = getDefaultOffsets();
+    applyOffsets();
+    return true;
+}
+
+void GameDataCapture::setOffsets(const MemoryOffsets& offsets) {
+    offsets_ = offsets;
+    applyOffsets();
+}
+
+void GameDataCapture::applyOffsets() {
+    playerDecoder_ = selectPlayerDecoder(offsets_);
+
+    // Size per-frame storage up front so captures only overwrite it
+    playerSpan_.resize(offsets_.maxPlayers * offsets_.playerStructSize);
+    previousState_.events.reserve(kReservedEvents);
+
+    resolver_.clear();
+    playerListPath_ = offsets_.playerListPath.isSet() ? resolver_.addPath(offsets_.playerListPath) : kNoPath;
+    bombPath_ = offsets_.bombPath.isSet() ? resolver_.addPath(offsets_.bombPath) : kNoPath;
+    gameStatePath_ = offsets_.gameStatePath.isSet() ? resolver_.addPath(offsets_.gameStatePath) : kNoPath;
+}
+
+MemoryOffsets GameDataCapture::getDefaultOffsets() {
+    MemoryOffsets offsets;
+
+    // Placeholder layout from MEMORY_OFFSETS_GUIDE.md. Base addresses stay 0
+    // (section skipped) until they are found for the running game build;
+    // they are relative to the module base, which differs between processes.
+    offsets.playerListBase = 0;
+    offsets.bombBase = 0;
+    offsets.gameStateBase = 0;
+
+    offsets.playerStructSize = 0x200;
+    offsets.maxPlayers = 32;
+
+    offsets.playerNameOffset = 0x04;
+    offsets.playerKillsOffset = 0x40;
+    offsets.playerDeathsOffset = 0x44;
+    offsets.playerAssistsOffset = 0x48;
+    offsets.playerMoneyOffset = 0x4C;
+    offsets.playerTeamOffset = 0x50;
+    offsets.playerAliveOffset = 0x54;
+
+    offsets.bombPlantedOffset = 0x00;
+    offsets.bombTimerOffset = 0x04;
+    offsets.bombDefusedOffset = 0x08;
+
+    offsets.roundNumberOffset = 0x00;
+    offsets.roundTimeOffset = 0x04;
+
+    return offsets;
+}
+
+const MemoryOffsets& GameDataCapture::getOffsets() const {
+    return offsets_;
+}
+
+uint32_t GameDataCapture::getProcessId() const {
+    return memoryReader_->getProcessId();
+}
+
+PointerResolverStats GameDataCapture::getResolverStats() const {
+    return resolver_.getStats();
+}
+
+bool GameDataCapture::enableSoftDirtyTracking() {
+    if (!isInitialized_) {
+        return false;
+    }
+    if (dirtyTracker_) {
+        return true;
+    }
+
+    auto tracker = std::make_unique<DirtyPageTracker>(*memoryReader_);
+    if (!tracker->enable()) {
+        return false;
+    }
+    playerSpanHandle_ = tracker->addSpan(0, 0);
+    dirtyTracker_ = std::move(tracker);
+    return true;
+}
+
+DirtyTrackingStats GameDataCapture::getDirtyTrackingStats() const {
+    return dirtyTracker_ ? dirtyTracker_->getStats() : DirtyTrackingStats();
+}
+
+const NameTable& GameDataCapture::getNameTable() const {
+    return nameTable_;
+}
+
+bool GameDataCapture::resolveBaseAddresses() {
+    // A zero base keeps its section disabled rather than pointing at the module itself
+    playerListAddress_ = offsets_.playerListBase != 0 ? moduleBase_ + offsets_.playerListBase : 0;
+    bombAddress_ = offsets_.bombBase != 0 ? moduleBase_ + offsets_.bombBase : 0;
+    gameStateAddress_ = offsets_.gameStateBase != 0 ? moduleBase_ + offsets_.gameStateBase : 0;
+
+    return (playerListPath_ == kNoPath || resolver_.resolve(playerListPath_, playerListAddress_)) &&
+           (bombPath_ == kNoPath || resolver_.resolve(bombPath_, bombAddress_)) &&
+           (gameStatePath_ == kNoPath || resolver_.resolve(gameStatePath_, gameStateAddress_));
+}
+
+bool GameDataCapture::captureGameState(GameState& outState) {
+    if (!isInitialized_) {
+        LOG_ERROR("Capture system not initialized");
+        return false;
+    }
+
+    outState.events.clear();
+    outState.events.reserve(kReservedEvents);
+    outState.nameTable = &nameTable_;
+
+    if (!resolveBaseAddresses()) {
+        return false;
+    }
+
+    outState.captureTimeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    if (!capturePlayers(outState) || !captureBomb(outState) || !captureRound(outState)) {
+        // Structures may have moved under cached chains: walk them again next frame
+        resolver_.invalidate();
+        return false;
+    }
+
+    // A lower round number means a new map, which reallocates game structures
+    if (hasPreviousState_ && outState.roundNumber < previousState_.roundNumber) {
+        resolver_.invalidate();
+    }
+
+    detectEvents(outState);
+
+    // Copy assignment reuses previousState_'s buffers
+    previousState_ = outState;
+    hasPreviousState_ = true;
+    return true;
+}
+
+bool GameDataCapture::capturePlayers(GameState& state) {
+    if (playerListAddress_ == 0) {
+        state.players.clear();
+        return true;
+    }
+
+    // Decoders intern every present slot, so a table reset must come before them
+    nameTable_.beginFrame(PlayerTable::kMaxPlayers);
+
+    if (dirtyTracker_) {
+        dirtyTracker_->setSpan(playerSpanHandle_, playerListAddress_, playerSpan_.size());
+        return dirtyTracker_->update() &&
+               playerDecoder_(offsets_, dirtyTracker_->getData(playerSpanHandle_), nameTable_, state.players);
+    }
+
+    // One read for the whole array instead of one per field and player
+    if (!memoryReader_->readBuffer(playerListAddress_, playerSpan_.data(), playerSpan_.size())) {
+        return false;
+    }
+
+    return playerDecoder_(offsets_, playerSpan_.data(), nameTable_, state.players);
+}
+
+bool GameDataCapture::captureBomb(GameState& state) {
+    if (bombAddress_ == 0) {
+        return true;
+    }
+
+    uint8_t planted = 0;
+    uint8_t defused = 0;
+    if (!memoryReader_->readMemory(bombAddress_ + offsets_.bombPlantedOffset, planted) ||
+        !memoryReader_->readMemory(bombAddress_ + offsets_.bombTimerOffset, state.bomb.timeRemaining) ||
+        !memoryReader_->readMemory(bombAddress_ + offsets_.bombDefusedOffset, defused)) {
+        return false;
+    }
+    state.bomb.planted = planted != 0;
+    state.bomb.defused = defused != 0;
+
+    return true;
+}
+
+bool GameDataCapture::captureRound(GameState& state) {
+    if (gameStateAddress_ == 0) {
+        return true;
+    }
+
+    return memoryReader_->readMemory(gameStateAddress_ + offsets_.roundNumberOffset, state.roundNumber) &&
+           memoryReader_->readMemory(gameStateAddress_ + offsets_.roundTimeOffset, state.roundTime);
+}
+
+void GameDataCapture::detectEvents(GameState& state) {
+    if (!hasPreviousState_) {
+        return;
+    }
+
+    if (state.roundNumber > previousState_.roundNumber) {
+        state.events.push_back(GameEvent::ROUND_END);
+        state.events.push_back(GameEvent::ROUND_START);
+    }
+
+    if (state.bomb.planted && !previousState_.bomb.planted) {
+        state.events.push_back(GameEvent::BOMB_PLANTED);
+    }
+    if (state.bomb.defused && !previousState_.bomb.defused) {
+        state.events.push_back(GameEvent::BOMB_DEFUSED);
+    } else if (!state.bomb.planted && previousState_.bomb.planted && !state.bomb.defused &&
+               !previousState_.bomb.defused) {
+        // The round reset clears "defused" together with "planted"; only a
+        // bomb that was still live can have exploded
+        state.events.push_back(GameEvent::BOMB_EXPLODED);
+    }
+
+    // A death in a slot still held by the same player is a kill
+    const PlayerTable& current = state.players;
+    const PlayerTable& previous = previousState_.players;
+    uint32_t killed = increasedSlots(current.deaths, previous.deaths) &
+                      current.presentMask & previous.presentMask;
+    for (size_t slot = 0; killed != 0; ++slot, killed >>= 1) {
+        if (!(killed & 1u) || current.nameIds[slot] != previous.nameIds[slot]) {
+            continue;
+        }
+        int64_t deaths = static_cast<int64_t>(current.deaths[slot]) - previous.deaths[slot];
+        if (deaths > kMaxDeathsPerCapture) {
+            // Take the new count as the baseline without inventing events
+            LOG_DEBUG("Ignoring a jump of " + std::to_string(deaths) + " deaths in slot " + std::to_string(slot));
+            continue;
+        }
+        for (int64_t i = 0; i < deaths; ++i) {
+            state.events.push_back(GameEvent::PLAYER_KILLED);
+        }
+    }
+}
+
+} // namespace CS16Capture
@@ -0,0 +1,661 @@
+#include "../include/ingest_server.h"
+#include "../include/json_value.h"
+#include "../include/latency_tracker.h"
+#include "../include/logger.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace CS16Capture {
+
+namespace {
+
+const size_t kReadChunk = 64 * 1024;
+const size_t kMaxLine = 64 * 1024;             // As WebSocketClient accepts from the server
+const int kMaxEvents = 256;
+const uint64_t kTimerIntervalUs = 10000;       // Slow read budgets are refilled this often
+const uint64_t kDisconnectScanUs = 100000;
+
+// Frames are recognized by their first key; everything else is a message
+const char kTypePrefix[] = "{\"type\":";
+const char kSeqKey[] = "\"seq\":";
+const char kInstanceKey[] = "\"instance\":";
+const uint64_t kNoInstance = ~0ull;            // Frames of an encoder without an instance id
+const char kCaptureTimeKey[] = "\"captureTime\":";
+
+/**
+ * @brief Read the unsigned number following a key, without parsing the JSON
+ */
+template<size_t N>
+bool findNumber(const char* line, size_t length, const char (&key)[N], uint64_t& value) {
+    const char* end = line + length;
+    const char* found = std::search(line, end, key, key + N - 1);
+    if (found == end) {
+        return false;
+    }
+    auto result = std::from_chars(found + N - 1, end, value);
+    return result.ec == std::errc();
+}
+
+void sendBestEffort(int fd, const char* data, size_t length) {
+    // Replies are tiny; a full socket buffer means the client stopped reading
+    ::send(fd, data, length, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+} // namespace
+
+void LatencyHistogram::clear() {
+    std::memset(counts, 0, sizeof(counts));
+    total = 0;
+    maxUs = 0;
+}
+
+void LatencyHistogram::record(uint64_t us) {
+    size_t index;
+    if (us < kSubBuckets) {
+        index = static_cast<size_t>(us);
+    } else {
+        // Highest bit picks the power of two, the next two bits the sub-bucket
+        size_t msb = 63 - static_cast<size_t>(__builtin_clzll(us));
+        size_t sub = static_cast<size_t>(us >> (msb - 2)) & (kSubBuckets - 1);
+        index = std::min(kSubBuckets + (msb - 2) * kSubBuckets + sub, kBuckets - 1);
+    }
+    ++counts[index];
+    ++total;
+    maxUs = std::max(maxUs, us);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < kBuckets; ++i) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    maxUs = std::max(maxUs, other.maxUs);
+}
+
+double LatencyHistogram::percentile(double fraction) const {
+    if (total == 0) {
+        return 0.0;
+    }
+    uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += counts[i];
+        if (seen < rank) {
+            continue;
+        }
+        if (i < kSubBuckets) {
+            return static_cast<double>(i);
+        }
+        size_t shift = (i - kSubBuckets) / kSubBuckets;
+        size_t sub = (i - kSubBuckets) % kSubBuckets;
+        uint64_t upper = ((kSubBuckets + sub + 1) << shift) - 1;
+        return static_cast<double>(std::min(upper, maxUs));
+    }
+    return static_cast<double>(maxUs);
+}
+
+struct IngestServer::Connection {
+    int fd;
+    uint64_t id;
+    uint16_t peerPort;
+    bool slowRead;
+    bool readPaused;
+    size_t readBudget;
+    uint64_t budgetTick;         // Timer tick readBudget was granted in
+    uint64_t connectedUs;
+    uint64_t disconnectAtUs;     // 0 = never
+    std::string pending;         // Incomplete line
+    std::unique_ptr<StreamDecompressor> decompressor;  // Set by a compression hello
+    CompressionCodec codec;
+    bool failed;                 // Undecodable stream, closed after the read
+    uint64_t bytes;
+    uint64_t plainBytes;
+    uint64_t frames;
+    uint64_t messages;
+    uint64_t gaps;               // Missing from "seq", superseded frames included
+    uint64_t clientDropped;
+    uint64_t clientSuperseded;
+    uint64_t malformed;
+    // One collector sends several instances, each counting its own "seq"
+    std::unordered_map<uint64_t, uint64_t> lastSeq;
+    double clockOffsetUs;        // From the latency reports of the client
+    LatencyHistogram latency;
+};
+
+struct IngestServer::Shard {
+    size_t index;
+    int epollFd;
+    int listenFd;
+    int wakeFd;
+    std::thread thread;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::vector<int> paused;     // Slow connections waiting for the next budget
+    bool acceptPaused;           // Out of file descriptors until the next timer tick
+    std::vector<char> readBuffer;
+    std::string decoded;         // Plain text of the records of one read
+    std::mt19937 random;
+    uint64_t tick;
+    uint64_t nextTimerUs;
+    uint64_t nextDisconnectScanUs;
+    IngestServerStats totals;    // Connections field unused
+    mutable std::mutex mutex;    // Held by the loop while it handles events
+
+    Shard()
+        : index(0), epollFd(-1), listenFd(-1), wakeFd(-1), acceptPaused(false), readBuffer(kReadChunk),
+          tick(0), nextTimerUs(0), nextDisconnectScanUs(0), totals() {}
+
+    ~Shard() {
+        for (auto& entry : connections) {
+            ::close(entry.first);
+        }
+        for (int fd : {epollFd, listenFd, wakeFd}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+};
+
+IngestServer::IngestServer(const IngestServerConfig& config)
+    : config_(config)
+    , running_(false)
+    , nextConnectionId_(1)
+    , port_(config.port)
+{
+}
+
+IngestServer::~IngestServer() {
+    stop();
+}
+
+bool IngestServer::start() {
+    if (running_) {
+        return true;
+    }
+
+    size_t count = config_.shards != 0 ? config_.shards
+                                       : std::max<size_t>(1, std::thread::hardware_concurrency());
+    port_ = config_.port;
+    for (size_t i = 0; i < count; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->index = i;
+        shard->random.seed(config_.seed + static_cast<uint32_t>(i));
+
+        // Every shard listens on the same port; the kernel spreads accepts
+        shard->listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int enable = 1;
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(static_cast<uint16_t>(port_));
+        socklen_t length = sizeof(address);
+        if (shard->listenFd < 0 ||
+            setsockopt(shard->listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) != 0 ||
+            setsockopt(shard->listenFd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) != 0 ||
+            ::bind(shard->listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(shard->listenFd, SOMAXCONN) != 0 ||
+            getsockname(shard->listenFd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            LOG_ERROR("Failed to listen on port " + std::to_string(port_) + ": " + std::strerror(errno));
+            shards_.clear();
+            return false;
+        }
+        port_ = ntohs(address.sin_port);
+
+        shard->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        shard->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        bool registered = shard->epollFd >= 0 && shard->wakeFd >= 0;
+        for (int fd : {shard->listenFd, shard->wakeFd}) {
+            event.data.fd = fd;
+            registered = registered && epoll_ctl(shard->epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+        }
+        if (!registered) {
+            LOG_ERROR(std::string("Failed to set up epoll: ") + std::strerror(errno));
+            shards_.clear();
+            return false;
+        }
+        shards_.push_back(std::move(shard));
+    }
+
+    running_ = true;
+    for (auto& shard : shards_) {
+        Shard* owned = shard.get();
+        shard->thread = std::thread([this, owned]() { shardLoop(*owned); });
+    }
+    LOG_INFO("Ingest server listening on port " + std::to_string(port_) + " with " +
+             std::to_string(shards_.size()) + " shards");
+    return true;
+}
+
+void IngestServer::stop() {
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+    for (auto& shard : shards_) {
+        uint64_t one = 1;
+        if (::write(shard->wakeFd, &one, sizeof(one)) < 0) {
+            LOG_WARNING("Failed to wake ingest shard " + std::to_string(shard->index));
+        }
+    }
+    for (auto& shard : shards_) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+    shards_.clear();
+    LOG_INFO("Ingest server stopped");
+}
+
+bool IngestServer::isRunning() const {
+    return running_;
+}
+
+int IngestServer::getPort() const {
+    return port_;
+}
+
+void IngestServer::shardLoop(Shard& shard) {
+    epoll_event events[kMaxEvents];
+    while (running_) {
+        // Wake up for the next timer tick at the latest
+        uint64_t beforeUs = monotonicMicros();
+        int timeoutMs = shard.nextTimerUs > beforeUs ? static_cast<int>((shard.nextTimerUs - beforeUs + 999) / 1000) : 0;
+        int count = epoll_wait(shard.epollFd, events, kMaxEvents, timeoutMs);
+        if (count < 0 && errno != EINTR) {
+            LOG_ERROR(std::string("epoll_wait failed: ") + std::strerror(errno));
+            break;
+        }
+
+        uint64_t nowUs = monotonicMicros();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == shard.wakeFd) {
+                continue;
+            }
+            if (fd == shard.listenFd) {
+                acceptConnections(shard, nowUs);
+                continue;
+            }
+            // May have been closed by an earlier event of this batch
+            auto it = shard.connections.find(fd);
+            if (it != shard.connections.end()) {
+                readConnection(shard, *it->second, nowUs);
+            }
+        }
+        if (nowUs >= shard.nextTimerUs) {
+            runTimers(shard, nowUs);
+        }
+    }
+}
+
+void IngestServer::acceptConnections(Shard& shard, uint64_t nowUs) {
+    for (;;) {
+        sockaddr_in address = {};
+        socklen_t length = sizeof(address);
+        int fd = accept4(shard.listenFd, reinterpret_cast<sockaddr*>(&address), &length,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EMFILE || errno == ENFILE) {
+                // The listen socket stays readable; stop polling it for a tick
+                LOG_WARNING("Out of file descriptors, pausing accepts");
+                epoll_event event = {};
+                event.data.fd = shard.listenFd;
+                epoll_ctl(shard.epollFd, EPOLL_CTL_MOD, shard.listenFd, &event);
+                shard.acceptPaused = true;
+            }
+            return;
+        }
+
+        auto connection = std::make_unique<Connection>();
+        Connection& c = *connection;
+        c.fd = fd;
+        c.id = nextConnectionId_++;
+        c.peerPort = ntohs(address.sin_port);
+        c.slowRead = std::uniform_real_distribution<double>(0.0, 1.0)(shard.random) < config_.slowReadFraction;
+        c.readPaused = false;
+        c.readBudget = 0;
+        c.budgetTick = ~0ull;
+        c.connectedUs = nowUs;
+        c.disconnectAtUs = 0;
+        if (config_.disconnectAfterMs != 0) {
+            std::exponential_distribution<double> lifetime(1.0 / (config_.disconnectAfterMs * 1000.0));
+            c.disconnectAtUs = nowUs + static_cast<uint64_t>(lifetime(shard.random)) + 1;
+        }
+        c.codec = CompressionCodec::NONE;
+        c.failed = false;
+        c.bytes = c.plainBytes = c.frames = c.messages = c.gaps = c.clientDropped = c.clientSuperseded = 0;
+        c.malformed = 0;
+        c.clockOffsetUs = 0.0;
+
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if (epoll_ctl(shard.epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            LOG_WARNING(std::string("Failed to register connection: ") + std::strerror(errno));
+            ::close(fd);
+            continue;
+        }
+        if (!config_.subscribeMessage.empty()) {
+            std::string line = config_.subscribeMessage;
+            if (line.back() != '\n') {
+                line.push_back('\n');
+            }
+            sendBestEffort(fd, line.data(), line.size());
+        }
+        shard.connections[fd] = std::move(connection);
+        ++shard.totals.accepted;
+    }
+}
+
+void IngestServer::readConnection(Shard& shard, Connection& connection, uint64_t nowUs) {
+    // One read per readiness event keeps thousands of connections fair
+    size_t limit = shard.readBuffer.size();
+    if (connection.slowRead) {
+        if (connection.budgetTick != shard.tick) {
+            connection.budgetTick = shard.tick;
+            connection.readBudget = std::max<size_t>(1, config_.slowReadBytesPerSecond * kTimerIntervalUs / 1000000);
+        }
+        limit = std::min(limit, connection.readBudget);
+    }
+
+    ssize_t received = ::recv(connection.fd, shard.readBuffer.data(), limit, 0);
+    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        closeConnection(shard, connection.fd, false);
+        return;
+    }
+    if (received < 0) {
+        return;
+    }
+
+    if (connection.slowRead) {
+        connection.readBudget -= static_cast<size_t>(received);
+        if (connection.readBudget == 0) {
+            // Leave the rest in the socket buffer until the next tick
+            epoll_event event = {};
+            event.data.fd = connection.fd;
+            epoll_ctl(shard.epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+            connection.readPaused = true;
+            shard.paused.push_back(connection.fd);
+        }
+    }
+    connection.bytes += static_cast<uint64_t>(received);
+    shard.totals.bytes += static_cast<uint64_t>(received);
+
+    const char* data = shard.readBuffer.data();
+    size_t length = static_cast<size_t>(received);
+    if (!connection.decompressor) {
+        size_t used = handleText(shard, connection, data, length, nowUs);
+        data += used;
+        length -= used;
+    }
+
+    // After a compression hello the rest of the stream is records
+    if (connection.decompressor && length > 0 && !connection.failed) {
+        shard.decoded.clear();
+        if (connection.decompressor->feed(data, length, shard.decoded)) {
+            handleText(shard, connection, shard.decoded.data(), shard.decoded.size(), nowUs);
+        } else {
+            LOG_WARNING("Closing connection #" + std::to_string(connection.id) + ": corrupt compressed stream");
+            connection.failed = true;
+        }
+    }
+
+    if (connection.failed) {
+        ++connection.malformed;
+        ++shard.totals.malformed;
+        closeConnection(shard, connection.fd, false);
+    }
+}
+
+size_t IngestServer::handleText(Shard& shard, Connection& connection, const char* data, size_t length,
+                                uint64_t nowUs) {
+    // Whole lines are handled in place; only a line split by the read is copied
+    const char* start = data;
+    const char* end = data + length;
+    bool compressed = connection.decompressor != nullptr;
+    while (data < end) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', static_cast<size_t>(end - data)));
+        if (newline == nullptr) {
+            connection.pending.append(data, end);
+            data = end;
+            break;
+        }
+        if (connection.pending.empty()) {
+            handleLine(shard, connection, data, static_cast<size_t>(newline - data), nowUs);
+        } else {
+            connection.pending.append(data, newline);
+            handleLine(shard, connection, connection.pending.data(), connection.pending.size(), nowUs);
+            connection.pending.clear();
+        }
+        data = newline + 1;
+
+        // The line was a compression hello: what follows is not text
+        if (!compressed && connection.decompressor) {
+            break;
+        }
+    }
+    if (connection.pending.size() > kMaxLine) {
+        ++connection.malformed;
+        ++shard.totals.malformed;
+        connection.pending.clear();
+    }
+
+    size_t used = static_cast<size_t>(data - start);
+    connection.plainBytes += used;
+    shard.totals.plainBytes += used;
+    return used;
+}
+
+void IngestServer::handleLine(Shard& shard, Connection& connection, const char* line, size_t length,
+                              uint64_t nowUs) {
+    if (length == 0) {
+        return;
+    }
+
+    if (length >= sizeof(kTypePrefix) - 1 && std::memcmp(line, kTypePrefix, sizeof(kTypePrefix) - 1) == 0) {
+        // Pings, latency and stats reports are rare enough to parse properly
+        JsonValue message;
+        std::string error;
+        if (!JsonValue::parse(std::string(line, length), message, error)) {
+            ++connection.malformed;
+            ++shard.totals.malformed;
+            return;
+        }
+        ++connection.messages;
+        ++shard.totals.messages;
+
+        std::string type = message.getString("type");
+        if (type == "ping" && config_.answerPings) {
+            char pong[160];
+            int written = std::snprintf(pong, sizeof(pong),
+                                        "{\"type\":\"pong\",\"id\":%.0f,\"t\":%.0f,\"serverTime\":%llu}\n",
+                                        message.getNumber("id", 0.0), message.getNumber("t", 0.0),
+                                        static_cast<unsigned long long>(nowUs));
+            if (written > 0 && static_cast<size_t>(written) < sizeof(pong)) {
+                sendBestEffort(connection.fd, pong, static_cast<size_t>(written));
+                ++shard.totals.pongs;
+            }
+        } else if (type == "latency") {
+            connection.clockOffsetUs = message.getNumber("clockOffsetUs", connection.clockOffsetUs);
+            connection.clientDropped = static_cast<uint64_t>(message.getNumber("dropped", 0.0));
+            // Reports carry running totals; only what is new goes into the shard totals
+            uint64_t superseded = static_cast<uint64_t>(message.getNumber("superseded", 0.0));
+            if (superseded > connection.clientSuperseded) {
+                shard.totals.clientSuperseded += superseded - connection.clientSuperseded;
+                connection.clientSuperseded = superseded;
+            }
+        } else if (type == "compression" && !connection.decompressor) {
+            CompressionCodec codec = CompressionCodec::NONE;
+            uint32_t dictId = static_cast<uint32_t>(message.getNumber("dictId", 0.0));
+            const std::string& dictionary = config_.compressionDictionary;
+            auto decompressor = std::make_unique<StreamDecompressor>();
+            if (!parseCompressionCodec(message.getString("codec"), codec) ||
+                (dictId != 0 && dictId != getCompressionDictionaryId(dictionary)) ||
+                !decompressor->reset(codec, dictId != 0 ? dictionary : std::string())) {
+                LOG_WARNING("Closing connection #" + std::to_string(connection.id) + ": cannot decode codec '" +
+                            message.getString("codec") + "' with dictionary " + std::to_string(dictId));
+                connection.failed = true;
+            }
+            // Records follow even when they cannot be decoded, so text handling stops either way
+            connection.codec = codec;
+            connection.decompressor = std::move(decompressor);
+        }
+        return;
+    }
+
+    uint64_t sequence = 0;
+    if (!findNumber(line, length, kSeqKey, sequence)) {
+        ++connection.malformed;
+        ++shard.totals.malformed;
+        return;
+    }
+    ++connection.frames;
+    ++shard.totals.frames;
+
+    // Sequences restart with every connection, so only forward jumps are gaps
+    uint64_t instance = kNoInstance;
+    findNumber(line, length, kInstanceKey, instance);
+    uint64_t& lastSeq = connection.lastSeq[instance];
+    if (lastSeq != 0 && sequence > lastSeq + 1) {
+        connection.gaps += sequence - lastSeq - 1;
+        shard.totals.gaps += sequence - lastSeq - 1;
+    }
+    lastSeq = sequence;
+
+    uint64_t captureUs = 0;
+    if (findNumber(line, length, kCaptureTimeKey, captureUs)) {
+        double age = static_cast<double>(nowUs) - (static_cast<double>(captureUs) + connection.clockOffsetUs);
+        if (age >= 0.0) {
+            connection.latency.record(static_cast<uint64_t>(age));
+            shard.totals.latency.record(static_cast<uint64_t>(age));
+        }
+    }
+}
+
+void IngestServer::closeConnection(Shard& shard, int fd, bool injected) {
+    ::close(fd);
+    shard.connections.erase(fd);
+    if (injected) {
+        ++shard.totals.injectedDisconnects;
+    } else {
+        ++shard.totals.closed;
+    }
+}
+
+void IngestServer::runTimers(Shard& shard, uint64_t nowUs) {
+    ++shard.tick;
+    shard.nextTimerUs = nowUs + kTimerIntervalUs;
+
+    // Slow connections get a new budget; descriptors may have been reused since
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    for (int fd : shard.paused) {
+        auto it = shard.connections.find(fd);
+        if (it != shard.connections.end() && it->second->readPaused) {
+            it->second->readPaused = false;
+            event.data.fd = fd;
+            epoll_ctl(shard.epollFd, EPOLL_CTL_MOD, fd, &event);
+        }
+    }
+    shard.paused.clear();
+
+    if (shard.acceptPaused) {
+        shard.acceptPaused = false;
+        event.events = EPOLLIN;
+        event.data.fd = shard.listenFd;
+        epoll_ctl(shard.epollFd, EPOLL_CTL_MOD, shard.listenFd, &event);
+    }
+
+    if (config_.disconnectAfterMs != 0 && nowUs >= shard.nextDisconnectScanUs) {
+        shard.nextDisconnectScanUs = nowUs + kDisconnectScanUs;
+        std::vector<int> expired;
+        for (const auto& entry : shard.connections) {
+            if (entry.second->disconnectAtUs <= nowUs) {
+                expired.push_back(entry.first);
+            }
+        }
+        for (int fd : expired) {
+            closeConnection(shard, fd, true);
+        }
+    }
+}
+
+IngestServerStats IngestServer::getStats() const {
+    IngestServerStats stats = {};
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        const IngestServerStats& totals = shard->totals;
+        stats.connections += shard->connections.size();
+        stats.accepted += totals.accepted;
+        stats.closed += totals.closed;
+        stats.injectedDisconnects += totals.injectedDisconnects;
+        stats.bytes += totals.bytes;
+        stats.plainBytes += totals.plainBytes;
+        stats.frames += totals.frames;
+        stats.messages += totals.messages;
+        stats.gaps += totals.gaps;
+        stats.clientSuperseded += totals.clientSuperseded;
+        stats.malformed += totals.malformed;
+        stats.pongs += totals.pongs;
+        stats.latency.merge(totals.latency);
+    }
+    // Totals keep superseded frames in the gaps until they are taken out here
+    stats.gaps = stats.gaps > stats.clientSuperseded ? stats.gaps - stats.clientSuperseded : 0;
+    return stats;
+}
+
+std::vector<IngestConnectionStats> IngestServer::getConnectionStats() const {
+    std::vector<IngestConnectionStats> result;
+    uint64_t nowUs = monotonicMicros();
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto& entry : shard->connections) {
+            const Connection& c = *entry.second;
+            IngestConnectionStats stats;
+            stats.id = c.id;
+            stats.shard = shard->index;
+            stats.peerPort = c.peerPort;
+            stats.slowRead = c.slowRead;
+            stats.codec = c.codec;
+            stats.connectedSeconds = static_cast<double>(nowUs - c.connectedUs) / 1e6;
+            stats.bytes = c.bytes;
+            stats.plainBytes = c.plainBytes;
+            stats.frames = c.frames;
+            stats.messages = c.messages;
+            stats.gaps = c.gaps > c.clientSuperseded ? c.gaps - c.clientSuperseded : 0;
+            stats.clientDropped = c.clientDropped;
+            stats.clientSuperseded = c.clientSuperseded;
+            stats.malformed = c.malformed;
+            double seconds = std::max(stats.connectedSeconds, 1e-3);
+            stats.bytesPerSecond = static_cast<double>(c.bytes) / seconds;
+            stats.framesPerSecond = static_cast<double>(c.frames) / seconds;
+            stats.p50Us = c.latency.percentile(0.5);
+            stats.p99Us = c.latency.percentile(0.99);
+            stats.maxUs = static_cast<double>(c.latency.maxUs);
+            result.push_back(stats);
+        }
+    }
+    std::sort(result.begin(), result.end(),
+              [](const IngestConnectionStats& a, const IngestConnectionStats& b) { return a.id < b.id; });
+    return result;
+}
+
+} // namespace CS16Capture
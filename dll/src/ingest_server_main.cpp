@@ -0,0 +1,162 @@
+#include "../include/ingest_server.h"
+#include "../include/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <sys/resource.h>
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void handleSignal(int) {
+    stopRequested = 1;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --port <port>            Port to listen on (default 8080)\n"
+              << "  --shards <count>         Event loop threads (default: one per core)\n"
+              << "  --subscribe <json>       Subscribe message sent to every connection\n"
+              << "  --no-pong                Do not answer pings (clients send no latency reports)\n"
+              << "  --slow-fraction <0..1>   Share of connections read slowly (default 0)\n"
+              << "  --slow-rate <bytes/s>    Read rate of slow connections (default 16384)\n"
+              << "  --disconnect-after <ms>  Mean lifetime before a forced disconnect (default never)\n"
+              << "  --compress-dict <file>   zstd dictionary of clients that compress with one\n"
+              << "  --report <s>             Statistics period (default 5)\n"
+              << "  --top <count>            Connections listed per report, most gaps first (default 5)\n"
+              << "  --debug                  Enable debug logging\n";
+}
+
+// Thousands of connections need more than the usual 1024 descriptors
+void raiseFileLimit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+void report(const CS16Capture::IngestServer& server, double seconds, uint64_t& lastFrames, uint64_t& lastBytes,
+            uint64_t& lastPlainBytes, size_t top) {
+    CS16Capture::IngestServerStats stats = server.getStats();
+    std::printf("%zu connections (%llu accepted, %llu closed, %llu forced) | %.0f frames/s, %.2f MB/s "
+                "(%.2f MB/s decompressed) | gaps %llu | age p50 %.0f us, p99 %.0f us, max %llu us\n",
+                stats.connections, static_cast<unsigned long long>(stats.accepted),
+                static_cast<unsigned long long>(stats.closed),
+                static_cast<unsigned long long>(stats.injectedDisconnects),
+                static_cast<double>(stats.frames - lastFrames) / seconds,
+                static_cast<double>(stats.bytes - lastBytes) / seconds / 1e6,
+                static_cast<double>(stats.plainBytes - lastPlainBytes) / seconds / 1e6,
+                static_cast<unsigned long long>(stats.gaps), stats.latency.percentile(0.5),
+                stats.latency.percentile(0.99), static_cast<unsigned long long>(stats.latency.maxUs));
+    lastFrames = stats.frames;
+    lastBytes = stats.bytes;
+    lastPlainBytes = stats.plainBytes;
+
+    if (top == 0) {
+        return;
+    }
+    std::vector<CS16Capture::IngestConnectionStats> connections = server.getConnectionStats();
+    std::sort(connections.begin(), connections.end(),
+              [](const CS16Capture::IngestConnectionStats& a, const CS16Capture::IngestConnectionStats& b) {
+                  return a.gaps + a.clientDropped > b.gaps + b.clientDropped;
+              });
+    for (size_t i = 0; i < std::min(top, connections.size()); ++i) {
+        const auto& c = connections[i];
+        std::printf("  #%llu :%u%s%s%s %.0f s | %.1f frames/s, %.0f B/s | gaps %llu, client dropped %llu, "
+                    "superseded %llu | age p50 %.0f us, p99 %.0f us\n",
+                    static_cast<unsigned long long>(c.id), c.peerPort, c.slowRead ? " slow" : "",
+                    c.codec != CS16Capture::CompressionCodec::NONE ? " " : "",
+                    c.codec != CS16Capture::CompressionCodec::NONE ? CS16Capture::compressionCodecToString(c.codec) : "",
+                    c.connectedSeconds, c.framesPerSecond, c.bytesPerSecond, static_cast<unsigned long long>(c.gaps),
+                    static_cast<unsigned long long>(c.clientDropped),
+                    static_cast<unsigned long long>(c.clientSuperseded), c.p50Us, c.p99Us);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    CS16Capture::IngestServerConfig config;
+    double reportSeconds = 5.0;
+    size_t top = 5;
+    bool debug = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--port" && hasValue) {
+            config.port = std::atoi(argv[++i]);
+        } else if (arg == "--shards" && hasValue) {
+            config.shards = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (arg == "--subscribe" && hasValue) {
+            config.subscribeMessage = argv[++i];
+        } else if (arg == "--no-pong") {
+            config.answerPings = false;
+        } else if (arg == "--slow-fraction" && hasValue) {
+            config.slowReadFraction = std::atof(argv[++i]);
+        } else if (arg == "--slow-rate" && hasValue) {
+            config.slowReadBytesPerSecond = static_cast<size_t>(std::atoll(argv[++i]));
+        } else if (arg == "--disconnect-after" && hasValue) {
+            config.disconnectAfterMs = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (arg == "--compress-dict" && hasValue) {
+            std::ifstream file(argv[++i], std::ios::binary);
+            if (!file) {
+                std::cerr << "Cannot read compression dictionary: " << argv[i] << std::endl;
+                return 1;
+            }
+            config.compressionDictionary.assign(std::istreambuf_iterator<char>(file),
+                                                std::istreambuf_iterator<char>());
+        } else if (arg == "--report" && hasValue) {
+            reportSeconds = std::atof(argv[++i]);
+        } else if (arg == "--top" && hasValue) {
+            top = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (arg == "--debug") {
+            debug = true;
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (reportSeconds <= 0.0 || config.slowReadBytesPerSecond == 0) {
+        std::cerr << "Report period and slow read rate must be positive" << std::endl;
+        return 1;
+    }
+
+    Logger::getInstance().setDebugEnabled(debug);
+    raiseFileLimit();
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    CS16Capture::IngestServer server(config);
+    if (!server.start()) {
+        return 1;
+    }
+
+    uint64_t lastFrames = 0;
+    uint64_t lastBytes = 0;
+    uint64_t lastPlainBytes = 0;
+    auto nextReport = std::chrono::steady_clock::now() + std::chrono::duration<double>(reportSeconds);
+    while (!stopRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        if (std::chrono::steady_clock::now() >= nextReport) {
+            report(server, reportSeconds, lastFrames, lastBytes, lastPlainBytes, top);
+            std::fflush(stdout);
+            nextReport += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(reportSeconds));
+        }
+    }
+
+    server.stop();
+    return 0;
+}
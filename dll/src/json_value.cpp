@@ -0,0 +1,252 @@
+#include "../include/json_value.h"
+#include <cstdint>
+#include <cstdlib>
+
+namespace CS16Capture {
+
+namespace {
+
+// Server messages are tiny; anything deeper is malformed or hostile
+const int kMaxDepth = 32;
+
+class Parser {
+public:
+    Parser(const std::string& text, std::string& error)
+        : text_(text)
+        , position_(0)
+        , error_(error)
+    {
+    }
+
+    bool parseDocument(JsonValue& out) {
+        if (!parseValue(out, 0)) {
+            return false;
+        }
+        skipWhitespace();
+        if (position_ != text_.size()) {
+            return fail("unexpected trailing data");
+        }
+        return true;
+    }
+
+private:
+    bool fail(const char* reason) {
+        error_ = std::string(reason) + " at offset " + std::to_string(position_);
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (position_ < text_.size() &&
+               (text_[position_] == ' ' || text_[position_] == '\t' ||
+                text_[position_] == '\n' || text_[position_] == '\r')) {
+            ++position_;
+        }
+    }
+
+    bool consume(char expected) {
+        skipWhitespace();
+        if (position_ < text_.size() && text_[position_] == expected) {
+            ++position_;
+            return true;
+        }
+        return false;
+    }
+
+    bool matchLiteral(const char* literal) {
+        size_t length = std::char_traits<char>::length(literal);
+        if (text_.compare(position_, length, literal) == 0) {
+            position_ += length;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseValue(JsonValue& out, int depth) {
+        if (depth > kMaxDepth) {
+            return fail("nesting too deep");
+        }
+
+        skipWhitespace();
+        if (position_ >= text_.size()) {
+            return fail("unexpected end of input");
+        }
+
+        char c = text_[position_];
+        if (c == '{') {
+            return parseObject(out, depth);
+        }
+        if (c == '[') {
+            return parseArray(out, depth);
+        }
+        if (c == '"') {
+            out.type = JsonValue::Type::STRING;
+            return parseString(out.string);
+        }
+        if (matchLiteral("true")) {
+            out.type = JsonValue::Type::BOOLEAN;
+            out.boolean = true;
+            return true;
+        }
+        if (matchLiteral("false")) {
+            out.type = JsonValue::Type::BOOLEAN;
+            out.boolean = false;
+            return true;
+        }
+        if (matchLiteral("null")) {
+            out.type = JsonValue::Type::NUL;
+            return true;
+        }
+        return parseNumber(out);
+    }
+
+    bool parseObject(JsonValue& out, int depth) {
+        out.type = JsonValue::Type::OBJECT;
+        ++position_;  // '{'
+        if (consume('}')) {
+            return true;
+        }
+
+        do {
+            skipWhitespace();
+            JsonMember member;
+            if (position_ >= text_.size() || text_[position_] != '"' || !parseString(member.key)) {
+                return fail("expected object key");
+            }
+            if (!consume(':')) {
+                return fail("expected ':'");
+            }
+            if (!parseValue(member.value, depth + 1)) {
+                return false;
+            }
+            out.object.push_back(std::move(member));
+        } while (consume(','));
+
+        return consume('}') || fail("expected ',' or '}'");
+    }
+
+    bool parseArray(JsonValue& out, int depth) {
+        out.type = JsonValue::Type::ARRAY;
+        ++position_;  // '['
+        if (consume(']')) {
+            return true;
+        }
+
+        do {
+            out.array.emplace_back();
+            if (!parseValue(out.array.back(), depth + 1)) {
+                return false;
+            }
+        } while (consume(','));
+
+        return consume(']') || fail("expected ',' or ']'");
+    }
+
+    bool parseString(std::string& out) {
+        ++position_;  // opening quote
+        out.clear();
+        while (position_ < text_.size()) {
+            char c = text_[position_++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (position_ >= text_.size()) {
+                break;
+            }
+
+            char escape = text_[position_++];
+            switch (escape) {
+                case '"':  out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/':  out.push_back('/'); break;
+                case 'b':  out.push_back('\b'); break;
+                case 'f':  out.push_back('\f'); break;
+                case 'n':  out.push_back('\n'); break;
+                case 'r':  out.push_back('\r'); break;
+                case 't':  out.push_back('\t'); break;
+                case 'u': {
+                    if (position_ + 4 > text_.size()) {
+                        return fail("truncated \\u escape");
+                    }
+                    unsigned long code = std::strtoul(text_.substr(position_, 4).c_str(), nullptr, 16);
+                    position_ += 4;
+                    appendUtf8(out, static_cast<uint32_t>(code));
+                    break;
+                }
+                default:
+                    return fail("invalid escape");
+            }
+        }
+        return fail("unterminated string");
+    }
+
+    static void appendUtf8(std::string& out, uint32_t code) {
+        // Surrogate pairs are not combined; control messages are ASCII
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+    bool parseNumber(JsonValue& out) {
+        const char* start = text_.c_str() + position_;
+        char* end = nullptr;
+        double value = std::strtod(start, &end);
+        if (end == start) {
+            return fail("unexpected character");
+        }
+        position_ += static_cast<size_t>(end - start);
+        out.type = JsonValue::Type::NUMBER;
+        out.number = value;
+        return true;
+    }
+
+    const std::string& text_;
+    size_t position_;
+    std::string& error_;
+};
+
+} // namespace
+
+const JsonValue* JsonValue::find(const std::string& key) const {
+    if (type != Type::OBJECT) {
+        return nullptr;
+    }
+    for (const auto& member : object) {
+        if (member.key == key) {
+            return &member.value;
+        }
+    }
+    return nullptr;
+}
+
+std::string JsonValue::getString(const std::string& key, const std::string& fallback) const {
+    const JsonValue* value = find(key);
+    return (value != nullptr && value->isString()) ? value->string : fallback;
+}
+
+double JsonValue::getNumber(const std::string& key, double fallback) const {
+    const JsonValue* value = find(key);
+    return (value != nullptr && value->isNumber()) ? value->number : fallback;
+}
+
+bool JsonValue::parse(const std::string& text, JsonValue& outValue, std::string& error) {
+    JsonValue value;
+    Parser parser(text, error);
+    if (!parser.parseDocument(value)) {
+        return false;
+    }
+    outValue = std::move(value);
+    return true;
+}
+
+} // namespace CS16Capture
@@ -0,0 +1,138 @@
+#include "../include/latency_tracker.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace CS16Capture {
+
+uint64_t monotonicMicros() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+LatencyTracker::LatencyTracker()
+    : nextPingId_(1)
+    , pendingPingId_(0)
+    , pendingPingSentUs_(0)
+    , rtts_()
+    , offsets_()
+    , rttCount_(0)
+    , rttNext_(0)
+    , pongs_(0)
+    , samples_()
+    , sampleNext_(0)
+    , sampleCount_(0)
+{
+}
+
+void LatencyTracker::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pendingPingId_ = 0;
+    pendingPingSentUs_ = 0;
+    rttCount_ = 0;
+    rttNext_ = 0;
+    pongs_ = 0;
+    sampleNext_ = 0;
+    sampleCount_ = 0;
+}
+
+void LatencyTracker::makePing(uint64_t nowUs, std::string& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Only the newest ping is outstanding; a late pong of an older one is ignored
+    pendingPingId_ = nextPingId_++;
+    pendingPingSentUs_ = nowUs;
+
+    char buffer[96];
+    int length = std::snprintf(buffer, sizeof(buffer), "{\"type\":\"ping\",\"id\":%llu,\"t\":%llu}\n",
+                               static_cast<unsigned long long>(pendingPingId_),
+                               static_cast<unsigned long long>(nowUs));
+    out.assign(buffer, static_cast<size_t>(length));
+}
+
+bool LatencyTracker::onPong(uint64_t id, uint64_t sentUs, double serverTimeUs, uint64_t nowUs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pendingPingId_ == 0 || id != pendingPingId_ || sentUs != pendingPingSentUs_ || nowUs < sentUs) {
+        return false;
+    }
+    pendingPingId_ = 0;
+
+    // Assume a symmetric path: the server answered halfway through the round trip
+    double rtt = static_cast<double>(nowUs - sentUs);
+    rtts_[rttNext_] = rtt;
+    offsets_[rttNext_] = serverTimeUs - (static_cast<double>(sentUs) + rtt / 2.0);
+    rttNext_ = (rttNext_ + 1) % kRttWindow;
+    rttCount_ = std::min(rttCount_ + 1, kRttWindow);
+    ++pongs_;
+    return true;
+}
+
+void LatencyTracker::recordFrame(uint64_t captureTimeUs, uint64_t sentUs) {
+    if (captureTimeUs == 0 || sentUs < captureTimeUs) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    double latency = static_cast<double>(sentUs - captureTimeUs);
+    if (rttCount_ > 0) {
+        latency += *std::min_element(rtts_, rtts_ + rttCount_) / 2.0;
+    }
+
+    samples_[sampleNext_] = static_cast<uint32_t>(std::min(latency, 4294967295.0));
+    sampleNext_ = (sampleNext_ + 1) % kMaxSamples;
+    ++sampleCount_;
+}
+
+LatencyStats LatencyTracker::getStats() const {
+    LatencyStats stats;
+    uint32_t sorted[kMaxSamples];
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.samples = sampleCount_;
+        stats.pongs = pongs_;
+        if (rttCount_ > 0) {
+            size_t best = static_cast<size_t>(std::min_element(rtts_, rtts_ + rttCount_) - rtts_);
+            stats.rttUs = rtts_[best];
+            stats.clockOffsetUs = offsets_[best];
+            stats.hasClockOffset = true;
+        }
+        count = static_cast<size_t>(std::min<uint64_t>(sampleCount_, kMaxSamples));
+        std::copy(samples_, samples_ + count, sorted);
+    }
+
+    if (count > 0) {
+        std::sort(sorted, sorted + count);
+        stats.p50Us = sorted[count / 2];
+        stats.p90Us = sorted[count * 90 / 100];
+        stats.p99Us = sorted[count * 99 / 100];
+        stats.maxUs = sorted[count - 1];
+    }
+    return stats;
+}
+
+void LatencyTracker::makeReport(uint64_t droppedFrames, uint64_t supersededFrames, std::string& out) const {
+    LatencyStats stats = getStats();
+
+    char buffer[384];
+    int length;
+    if (stats.hasClockOffset) {
+        length = std::snprintf(buffer, sizeof(buffer),
+                               "{\"type\":\"latency\",\"samples\":%llu,\"dropped\":%llu,\"superseded\":%llu,\"rttUs\":%.0f,"
+                               "\"clockOffsetUs\":%.0f,\"p50Us\":%.0f,\"p90Us\":%.0f,\"p99Us\":%.0f,\"maxUs\":%.0f}\n",
+                               static_cast<unsigned long long>(stats.samples),
+                               static_cast<unsigned long long>(droppedFrames),
+                               static_cast<unsigned long long>(supersededFrames), stats.rttUs,
+                               stats.clockOffsetUs, stats.p50Us, stats.p90Us, stats.p99Us, stats.maxUs);
+    } else {
+        // No pong yet: leave the latency fields out rather than report zeros
+        length = std::snprintf(buffer, sizeof(buffer),
+                               "{\"type\":\"latency\",\"samples\":%llu,\"dropped\":%llu,\"superseded\":%llu}\n",
+                               static_cast<unsigned long long>(stats.samples),
+                               static_cast<unsigned long long>(droppedFrames),
+                               static_cast<unsigned long long>(supersededFrames));
+    }
+    out.assign(buffer, static_cast<size_t>(length));
+}
+
+} // namespace CS16Capture
@@ -9,7 +9,8 @@ Logger& Logger::getInstance() {
     return instance;
 }
 
-Logger::Logger() {
+Logger::Logger()
+    : debugEnabled_(true) {
 }
 
 Logger::~Logger() {
@@ -50,7 +51,17 @@ void Logger::logError(const std::string& message) {
 }
 
 void Logger::logDebug(const std::string& message) {
-    log(LogLevel::DBG, message);
+    if (debugEnabled_) {
+        log(LogLevel::DBG, message);
+    }
+}
+
+void Logger::setDebugEnabled(bool enable) {
+    debugEnabled_ = enable;
+}
+
+bool Logger::isDebugEnabled() const {
+    return debugEnabled_;
 }
 
 std::string Logger::getLevelString(LogLevel level) {
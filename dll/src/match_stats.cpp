@@ -0,0 +1,326 @@
+#include "../include/match_stats.h"
+#include "../include/logger.h"
+#include "../include/name_table.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace CS16Capture {
+
+namespace {
+
+const int32_t kTerrorist = 1;
+const int32_t kCounterTerrorist = 2;
+
+bool isPlaying(const PlayerTable& players, size_t slot) {
+    return players.team[slot] == kTerrorist || players.team[slot] == kCounterTerrorist;
+}
+
+BuyType buyTypeOf(int32_t spent, int32_t playerCount) {
+    if (playerCount == 0) {
+        return BuyType::ECO;
+    }
+    int32_t average = spent / playerCount;
+    if (average < MatchStats::kEcoSpend) {
+        return BuyType::ECO;
+    }
+    return average < MatchStats::kForceSpend ? BuyType::FORCE : BuyType::FULL;
+}
+
+} // namespace
+
+MatchStats::MatchStats()
+    : nameTable_(nullptr)
+    , nameEpoch_(0)
+{
+    reset();
+}
+
+void MatchStats::reset() {
+    for (auto& player : players_) {
+        player = PlayerMatchStats();
+        player.nameId = NameTable::kInvalidId;
+    }
+    current_ = RoundRecord();
+    roundObserved_ = false;
+    bombDefused_ = false;
+    roundStartNs_ = 0;
+    lastCaptureNs_ = 0;
+    nextRound_ = 0;
+    roundCount_ = 0;
+    wins_[0] = 0;
+    wins_[1] = 0;
+    finishedRounds_ = 0;
+    previous_.clear();
+    previousRound_ = 0;
+    hasPrevious_ = false;
+}
+
+const PlayerMatchStats& MatchStats::getPlayer(size_t slot) const {
+    return players_[slot];
+}
+
+uint32_t MatchStats::getPresentMask() const {
+    return previous_.presentMask;
+}
+
+size_t MatchStats::getRoundCount() const {
+    return roundCount_;
+}
+
+const RoundRecord& MatchStats::getRound(size_t index) const {
+    size_t oldest = roundCount_ < kRoundHistory ? 0 : nextRound_;
+    return rounds_[(oldest + index) % kRoundHistory];
+}
+
+int32_t MatchStats::getRoundWins(RoundWinner side) const {
+    switch (side) {
+        case RoundWinner::TERRORISTS: return wins_[0];
+        case RoundWinner::COUNTER_TERRORISTS: return wins_[1];
+        case RoundWinner::NONE: break;
+    }
+    return 0;
+}
+
+uint64_t MatchStats::getFinishedRounds() const {
+    return finishedRounds_;
+}
+
+void MatchStats::update(const GameState& state) {
+    const PlayerTable& players = state.players;
+
+    uint32_t epoch = state.nameTable != nullptr ? state.nameTable->getEpoch() : 0;
+    if (hasPrevious_ && (state.nameTable != nameTable_ || epoch != nameEpoch_)) {
+        remapNames(players);
+    }
+    nameTable_ = state.nameTable;
+    nameEpoch_ = epoch;
+
+    if (!hasPrevious_ || state.roundNumber < previousRound_) {
+        // First state, or the round count went back: map change or restart
+        if (hasPrevious_) {
+            LOG_DEBUG("Round number went back to " + std::to_string(state.roundNumber) + ", new match");
+        }
+        reset();
+        for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+            if (players.isPresent(slot)) {
+                resetSlot(slot, players);
+            }
+        }
+        startRound(state);
+        roundObserved_ = false;
+        previous_ = players;
+        previousRound_ = state.roundNumber;
+        hasPrevious_ = true;
+        return;
+    }
+
+    // Most frames change nothing but the timer: one compare of the columns
+    // (kills through nameIds are contiguous) rules them out
+    const size_t columnBytes = static_cast<size_t>(reinterpret_cast<const char*>(players.names) -
+                                                   reinterpret_cast<const char*>(players.kills));
+    bool changed = players.presentMask != previous_.presentMask ||
+                   std::memcmp(players.kills, previous_.kills, columnBytes) != 0;
+    if (changed) {
+        accountPlayers(players);
+    }
+
+    if (state.roundNumber > previousRound_) {
+        // The previous state is the last one of the finished round
+        finishRound();
+        startRound(state);
+        changed = true;
+    } else {
+        lastCaptureNs_ = state.captureTimeNs;
+    }
+    current_.bombPlanted = current_.bombPlanted || state.bomb.planted;
+    bombDefused_ = bombDefused_ || (state.bomb.planted && state.bomb.defused);
+
+    if (changed) {
+        previous_ = players;
+        previousRound_ = state.roundNumber;
+    }
+}
+
+void MatchStats::accountPlayers(const PlayerTable& players) {
+    // Slots that got a new player start from zero; vacated slots are forgotten
+    const uint32_t present = players.presentMask;
+    const uint32_t wasPresent = previous_.presentMask;
+    const uint32_t renamed = changedSlots(players.nameIds, previous_.nameIds) & present & wasPresent;
+    uint32_t fresh = (present & ~wasPresent) | renamed;
+    for (size_t slot = 0; fresh != 0; ++slot, fresh >>= 1) {
+        if (fresh & 1u) {
+            resetSlot(slot, players);
+        }
+    }
+    uint32_t left = wasPresent & ~present;
+    for (size_t slot = 0; left != 0; ++slot, left >>= 1) {
+        if (left & 1u) {
+            players_[slot].nameId = NameTable::kInvalidId;
+        }
+    }
+
+    // Only slots whose columns changed are visited. Counters that go down
+    // (scoreboard reset) are not taken back
+    const uint32_t stable = present & wasPresent & ~renamed;
+    uint32_t kills = changedSlots(players.kills, previous_.kills) & stable;
+    uint32_t deaths = changedSlots(players.deaths, previous_.deaths) & stable;
+    uint32_t assists = changedSlots(players.assists, previous_.assists) & stable;
+    uint32_t money = changedSlots(players.money, previous_.money) & stable;
+    uint32_t teams = changedSlots(players.team, previous_.team) & stable;
+
+    for (size_t slot = 0; kills != 0; ++slot, kills >>= 1) {
+        int32_t delta = players.kills[slot] - previous_.kills[slot];
+        if ((kills & 1u) && delta > 0) {
+            players_[slot].kills += delta;
+            current_.kills[slot] = static_cast<uint8_t>(std::min(current_.kills[slot] + delta, 255));
+        }
+    }
+    for (size_t slot = 0; deaths != 0; ++slot, deaths >>= 1) {
+        int32_t delta = players.deaths[slot] - previous_.deaths[slot];
+        if ((deaths & 1u) && delta > 0) {
+            players_[slot].deaths += delta;
+        }
+    }
+    for (size_t slot = 0; assists != 0; ++slot, assists >>= 1) {
+        int32_t delta = players.assists[slot] - previous_.assists[slot];
+        if ((assists & 1u) && delta > 0) {
+            players_[slot].assists += delta;
+        }
+    }
+    for (size_t slot = 0; money != 0; ++slot, money >>= 1) {
+        if (money & 1u) {
+            int32_t delta = players.money[slot] - previous_.money[slot];
+            if (delta < 0) {
+                players_[slot].moneySpent -= delta;
+                current_.spent[slot] -= delta;
+            } else {
+                players_[slot].moneyEarned += delta;
+            }
+        }
+    }
+    for (size_t slot = 0; teams != 0; ++slot, teams >>= 1) {
+        if (teams & 1u) {
+            players_[slot].team = players.team[slot];
+        }
+    }
+}
+
+void MatchStats::resetSlot(size_t slot, const PlayerTable& players) {
+    players_[slot] = PlayerMatchStats();
+    players_[slot].nameId = players.nameIds[slot];
+    players_[slot].team = players.team[slot];
+    current_.startMoney[slot] = players.money[slot];
+    current_.spent[slot] = 0;
+    current_.kills[slot] = 0;
+}
+
+void MatchStats::remapNames(const PlayerTable& players) {
+    // Ids of the old epoch say nothing about the new ones, and may even be
+    // reused by other players: a slot held before and now keeps its player
+    // under the new id. A player changing slots on this very capture would
+    // be missed, which a table reset makes unknowable anyway
+    for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+        uint16_t oldId = players_[slot].nameId;
+        uint16_t newId = players.isPresent(slot) && previous_.isPresent(slot) ? players.nameIds[slot]
+                                                                              : NameTable::kInvalidId;
+        auto remap = [oldId, newId](uint16_t& id) {
+            id = oldId != NameTable::kInvalidId && id == oldId ? newId : NameTable::kInvalidId;
+        };
+        for (RoundRecord& round : rounds_) {
+            remap(round.nameIds[slot]);
+        }
+        if (players_[slot].nameId != NameTable::kInvalidId) {
+            players_[slot].nameId = newId;
+        }
+        previous_.nameIds[slot] = players.nameIds[slot];
+    }
+    LOG_DEBUG("Name table reset, carried player stats over by slot");
+}
+
+void MatchStats::startRound(const GameState& state) {
+    current_ = RoundRecord();
+    current_.roundNumber = state.roundNumber;
+    for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+        current_.startMoney[slot] = state.players.money[slot];
+    }
+    roundObserved_ = true;
+    bombDefused_ = false;
+    roundStartNs_ = state.captureTimeNs;
+    lastCaptureNs_ = state.captureTimeNs;
+}
+
+void MatchStats::finishRound() {
+    if (!roundObserved_) {
+        return;
+    }
+
+    const PlayerTable& last = previous_;
+    RoundRecord& round = current_;
+    int32_t alive[3] = {0, 0, 0};
+    int32_t playing[3] = {0, 0, 0};
+    for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+        if (!last.isPresent(slot) || !isPlaying(last, slot)) {
+            continue;
+        }
+        int32_t team = last.team[slot];
+        ++playing[team];
+        round.presentMask |= 1u << slot;
+        round.nameIds[slot] = last.nameIds[slot];
+        round.teamStartMoney[team - 1] += round.startMoney[slot];
+        round.teamSpent[team - 1] += round.spent[slot];
+
+        PlayerMatchStats& player = players_[slot];
+        ++player.roundsPlayed;
+        if (last.alive[slot]) {
+            ++alive[team];
+            ++player.roundsSurvived;
+            round.survivedMask |= 1u << slot;
+        }
+        if (round.kills[slot] >= 2) {
+            ++player.multiKillRounds[std::min<size_t>(round.kills[slot], 5) - 2];
+        }
+    }
+    for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+        if (!((round.presentMask >> slot) & 1u)) {
+            round.nameIds[slot] = NameTable::kInvalidId;
+        }
+    }
+    round.teamBuy[0] = buyTypeOf(round.teamSpent[0], playing[kTerrorist]);
+    round.teamBuy[1] = buyTypeOf(round.teamSpent[1], playing[kCounterTerrorist]);
+
+    // A bomb that was planted and not defused went off, whoever was left;
+    // an unplanted round that nobody won on kills ran out of time
+    if (bombDefused_) {
+        round.winner = RoundWinner::COUNTER_TERRORISTS;
+        round.reason = RoundEndReason::BOMB_DEFUSED;
+    } else if (round.bombPlanted) {
+        round.winner = RoundWinner::TERRORISTS;
+        round.reason = RoundEndReason::BOMB_EXPLODED;
+    } else if (alive[kTerrorist] == 0 && alive[kCounterTerrorist] > 0) {
+        round.winner = RoundWinner::COUNTER_TERRORISTS;
+        round.reason = RoundEndReason::ELIMINATION;
+    } else if (alive[kCounterTerrorist] == 0 && alive[kTerrorist] > 0) {
+        round.winner = RoundWinner::TERRORISTS;
+        round.reason = RoundEndReason::ELIMINATION;
+    } else if (alive[kTerrorist] > 0) {
+        round.winner = RoundWinner::COUNTER_TERRORISTS;
+        round.reason = RoundEndReason::TIME_EXPIRED;
+    }
+    if (round.winner != RoundWinner::NONE) {
+        ++wins_[static_cast<size_t>(round.winner) - 1];
+    }
+
+    if (roundStartNs_ != 0 && lastCaptureNs_ > roundStartNs_) {
+        round.durationSeconds = static_cast<float>(lastCaptureNs_ - roundStartNs_) / 1e9f;
+    }
+
+    rounds_[nextRound_] = round;
+    nextRound_ = (nextRound_ + 1) % kRoundHistory;
+    roundCount_ = std::min(roundCount_ + 1, kRoundHistory);
+    ++finishedRounds_;
+    LOG_DEBUG("Round " + std::to_string(round.roundNumber) + " finished, score " +
+              std::to_string(wins_[0]) + ":" + std::to_string(wins_[1]));
+}
+
+} // namespace CS16Capture
@@ -5,12 +5,18 @@
 #include <windows.h>
 #include <tlhelp32.h>
 #include <psapi.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <fstream>
 #endif
 
 namespace CS16Capture {
 
 MemoryReader::MemoryReader() 
     : isInitialized_(false)
+    , processId_(0)
 #ifdef _WIN32
     , processHandle_(nullptr)
 #endif
@@ -39,12 +45,66 @@ bool MemoryReader::initialize() {
         return false;
     }
 
+    processId_ = GetCurrentProcessId();
     isInitialized_ = true;
     LOG_INFO("MemoryReader initialized successfully");
     return true;
 #else
-    LOG_ERROR("MemoryReader not implemented for this platform");
-    return false;
+    return attach(static_cast<uint32_t>(getpid()));
+#endif
+}
+
+bool MemoryReader::attach(uint32_t processId) {
+    if (isInitialized_) {
+        return processId == processId_;
+    }
+
+#ifdef _WIN32
+    processHandle_ = OpenProcess(PROCESS_VM_READ | PROCESS_QUERY_INFORMATION, FALSE, processId);
+    if (processHandle_ == nullptr) {
+        LOG_ERROR("Failed to open process " + std::to_string(processId) +
+                  ": " + std::to_string(GetLastError()));
+        return false;
+    }
+#else
+    // Probe the process with an empty read: this checks both that it exists
+    // and that we are allowed to ptrace-read it (same uid or CAP_SYS_PTRACE)
+    struct iovec local = { nullptr, 0 };
+    struct iovec remote = { nullptr, 0 };
+    if (process_vm_readv(static_cast<pid_t>(processId), &local, 1, &remote, 1, 0) < 0) {
+        LOG_ERROR("Failed to attach to process " + std::to_string(processId) +
+                  ": errno " + std::to_string(errno));
+        return false;
+    }
+#endif
+
+    processId_ = processId;
+    isInitialized_ = true;
+    LOG_INFO("MemoryReader attached to process " + std::to_string(processId));
+    return true;
+}
+
+uint32_t MemoryReader::getProcessId() const {
+    return processId_;
+}
+
+bool MemoryReader::readBuffer(uintptr_t address, void* buffer, size_t size) {
+    if (!isInitialized_ || address == 0) {
+        return false;
+    }
+
+#ifdef _WIN32
+    SIZE_T bytesRead;
+    return ReadProcessMemory(processHandle_,
+                             reinterpret_cast<LPCVOID>(address),
+                             buffer,
+                             size,
+                             &bytesRead) && bytesRead == size;
+#else
+    struct iovec local = { buffer, size };
+    struct iovec remote = { reinterpret_cast<void*>(address), size };
+    ssize_t bytesRead = process_vm_readv(static_cast<pid_t>(processId_), &local, 1, &remote, 1, 0);
+    return bytesRead >= 0 && static_cast<size_t>(bytesRead) == size;
 #endif
 }
 
@@ -65,6 +125,17 @@ std::string MemoryReader::readString(uintptr_t address, size_t maxLength) {
         buffer[bytesRead] = '\0';
         return std::string(buffer.data());
     }
+#else
+    std::vector<char> buffer(maxLength + 1, 0);
+    struct iovec local = { buffer.data(), maxLength };
+    struct iovec remote = { reinterpret_cast<void*>(address), maxLength };
+    ssize_t bytesRead = process_vm_readv(static_cast<pid_t>(processId_), &local, 1, &remote, 1, 0);
+
+    // A partial read happens when the string sits at the end of a mapping
+    if (bytesRead >= 0) {
+        buffer[static_cast<size_t>(bytesRead)] = '\0';
+        return std::string(buffer.data());
+    }
 #endif
 
     return "";
@@ -87,12 +158,40 @@ bool MemoryReader::isValidAddress(uintptr_t address) {
     return (mbi.State == MEM_COMMIT) && 
            (mbi.Protect & (PAGE_READONLY | PAGE_READWRITE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE));
 #else
-    return false;
+    uint8_t probe;
+    return readBuffer(address, &probe, sizeof(probe));
 #endif
 }
 
 uintptr_t MemoryReader::getModuleBase(const std::string& moduleName) {
 #ifdef _WIN32
+    if (processId_ != 0 && processId_ != GetCurrentProcessId()) {
+        // Remote process: walk its module list instead of our own
+        HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPMODULE | TH32CS_SNAPMODULE32, processId_);
+        if (snapshot == INVALID_HANDLE_VALUE) {
+            LOG_WARNING("Failed to snapshot modules of process " + std::to_string(processId_));
+            return 0;
+        }
+
+        uintptr_t base = 0;
+        MODULEENTRY32 entry;
+        entry.dwSize = sizeof(entry);
+        if (Module32First(snapshot, &entry)) {
+            do {
+                if (_stricmp(entry.szModule, moduleName.c_str()) == 0) {
+                    base = reinterpret_cast<uintptr_t>(entry.modBaseAddr);
+                    break;
+                }
+            } while (Module32Next(snapshot, &entry));
+        }
+        CloseHandle(snapshot);
+
+        if (base == 0) {
+            LOG_WARNING("Failed to find module " + moduleName + " in process " + std::to_string(processId_));
+        }
+        return base;
+    }
+
     HMODULE hModule = GetModuleHandleA(moduleName.c_str());
     if (hModule == nullptr) {
         LOG_WARNING("Failed to get module handle for: " + moduleName);
@@ -103,10 +202,78 @@ uintptr_t MemoryReader::getModuleBase(const std::string& moduleName) {
               std::to_string(reinterpret_cast<uintptr_t>(hModule)));
     return reinterpret_cast<uintptr_t>(hModule);
 #else
+    if (!isInitialized_) {
+        return 0;
+    }
+
+    // The first mapping of a shared object is its load base
+    std::ifstream maps("/proc/" + std::to_string(processId_) + "/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+        size_t slash = line.rfind('/');
+        if (slash == std::string::npos || line.compare(slash + 1, std::string::npos, moduleName) != 0) {
+            continue;
+        }
+
+        uintptr_t base = static_cast<uintptr_t>(std::stoull(line.substr(0, line.find('-')), nullptr, 16));
+        LOG_DEBUG("Module base for " + moduleName + ": " + std::to_string(base));
+        return base;
+    }
+
+    LOG_WARNING("Failed to find module " + moduleName + " in process " + std::to_string(processId_));
     return 0;
 #endif
 }
 
+bool MemoryReader::getWritableRegions(std::vector<MemoryRegion>& outRegions) {
+    outRegions.clear();
+    if (!isInitialized_) {
+        return false;
+    }
+
+#ifdef _WIN32
+    const DWORD writable = PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+    MEMORY_BASIC_INFORMATION mbi;
+    uintptr_t address = 0;
+    while (VirtualQueryEx(processHandle_, reinterpret_cast<LPCVOID>(address), &mbi, sizeof(mbi)) == sizeof(mbi)) {
+        if (mbi.State == MEM_COMMIT && (mbi.Protect & writable) && !(mbi.Protect & PAGE_GUARD)) {
+            outRegions.push_back({reinterpret_cast<uintptr_t>(mbi.BaseAddress), mbi.RegionSize});
+        }
+        uintptr_t next = reinterpret_cast<uintptr_t>(mbi.BaseAddress) + mbi.RegionSize;
+        if (next <= address) {
+            break;
+        }
+        address = next;
+    }
+    return true;
+#else
+    std::ifstream maps("/proc/" + std::to_string(processId_) + "/maps");
+    if (!maps) {
+        LOG_ERROR("Failed to read memory map of process " + std::to_string(processId_));
+        return false;
+    }
+
+    // "start-end perms offset dev inode path"; kernel pages such as [vvar] cannot be read
+    std::string line;
+    while (std::getline(maps, line)) {
+        size_t dash = line.find('-');
+        size_t space = line.find(' ');
+        if (dash == std::string::npos || space == std::string::npos || space + 2 >= line.size() ||
+            line[space + 1] != 'r' || line[space + 2] != 'w' ||
+            line.find("[vvar]") != std::string::npos || line.find("[vsyscall]") != std::string::npos) {
+            continue;
+        }
+
+        uintptr_t start = static_cast<uintptr_t>(std::stoull(line.substr(0, dash), nullptr, 16));
+        uintptr_t end = static_cast<uintptr_t>(std::stoull(line.substr(dash + 1, space - dash - 1), nullptr, 16));
+        if (end > start) {
+            outRegions.push_back({start, static_cast<size_t>(end - start)});
+        }
+    }
+    return true;
+#endif
+}
+
 uintptr_t MemoryReader::findPattern(const std::vector<uint8_t>& pattern, 
                                     const std::string& mask,
                                     uintptr_t startAddress, 
@@ -127,6 +294,22 @@ uintptr_t MemoryReader::findPattern(const std::vector<uint8_t>& pattern,
         LOG_ERROR("Failed to read memory for pattern search");
         return 0;
     }
+#else
+    std::vector<uint8_t> buffer(searchSize);
+    struct iovec local = { buffer.data(), searchSize };
+    struct iovec remote = { reinterpret_cast<void*>(startAddress), searchSize };
+    ssize_t readResult = process_vm_readv(static_cast<pid_t>(processId_), &local, 1, &remote, 1, 0);
+
+    if (readResult < 0) {
+        LOG_ERROR("Failed to read memory for pattern search");
+        return 0;
+    }
+    size_t bytesRead = static_cast<size_t>(readResult);
+#endif
+
+    if (bytesRead < pattern.size()) {
+        return 0;
+    }
 
     for (size_t i = 0; i <= bytesRead - pattern.size(); ++i) {
         bool found = true;
@@ -142,7 +325,6 @@ uintptr_t MemoryReader::findPattern(const std::vector<uint8_t>& pattern,
             return startAddress + i;
         }
     }
-#endif
 
     return 0;
 }
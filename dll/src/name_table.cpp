@@ -0,0 +1,90 @@
+#include "../include/name_table.h"
+#include "../include/logger.h"
+#include <algorithm>
+#include <cstring>
+
+namespace CS16Capture {
+
+NameTable::NameTable()
+    : epoch_(0)
+    , decodeCount_(0)
+{
+}
+
+void NameTable::beginFrame(size_t maxNewNames) {
+    if (names_.size() + maxNewNames > kMaxNames) {
+        LOG_INFO("Name table nearly full, resetting");
+        reset();
+    }
+}
+
+uint16_t NameTable::internSlot(size_t slot, const char* raw, size_t maxLength) {
+    maxLength = std::min(maxLength, kMaxNameLength);
+
+    if (slot >= slots_.size()) {
+        slots_.resize(slot + 1, SlotCache());
+    }
+
+    SlotCache& cache = slots_[slot];
+    if (cache.valid && std::memcmp(cache.raw, raw, maxLength) == 0) {
+        return cache.id;
+    }
+
+    ++decodeCount_;
+    uint16_t id = intern(raw, strnlen(raw, maxLength));
+
+    // intern() may have reset the table, which invalidates every slot
+    SlotCache& current = slots_[slot];
+    std::memcpy(current.raw, raw, maxLength);
+    current.id = id;
+    current.valid = true;
+    return id;
+}
+
+uint16_t NameTable::intern(const char* name, size_t length) {
+    std::string key(name, length);
+
+    auto it = ids_.find(key);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+
+    // Only reached by callers that skip beginFrame()
+    if (names_.size() >= kMaxNames) {
+        LOG_INFO("Name table full, resetting");
+        reset();
+    }
+
+    uint16_t id = static_cast<uint16_t>(names_.size());
+    names_.push_back(key);
+    ids_.emplace(std::move(key), id);
+    return id;
+}
+
+const std::string& NameTable::getName(uint16_t id) const {
+    static const std::string empty;
+    return id < names_.size() ? names_[id] : empty;
+}
+
+size_t NameTable::size() const {
+    return names_.size();
+}
+
+uint32_t NameTable::getEpoch() const {
+    return epoch_;
+}
+
+uint64_t NameTable::getDecodeCount() const {
+    return decodeCount_;
+}
+
+void NameTable::reset() {
+    names_.clear();
+    ids_.clear();
+    for (auto& cache : slots_) {
+        cache.valid = false;
+    }
+    ++epoch_;
+}
+
+} // namespace CS16Capture
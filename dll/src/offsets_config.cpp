@@ -0,0 +1,217 @@
+#include "../include/offsets_config.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace CS16Capture {
+
+namespace {
+
+struct AddressKey {
+    const char* name;
+    uintptr_t MemoryOffsets::*member;
+};
+
+struct PathKey {
+    const char* name;
+    PointerPath MemoryOffsets::*member;
+};
+
+struct SizeKey {
+    const char* name;
+    size_t MemoryOffsets::*member;
+};
+
+const AddressKey kAddressKeys[] = {
+    { "playerListBase", &MemoryOffsets::playerListBase },
+    { "bombBase", &MemoryOffsets::bombBase },
+    { "gameStateBase", &MemoryOffsets::gameStateBase },
+};
+
+const PathKey kPathKeys[] = {
+    { "playerListPath", &MemoryOffsets::playerListPath },
+    { "bombPath", &MemoryOffsets::bombPath },
+    { "gameStatePath", &MemoryOffsets::gameStatePath },
+};
+
+const SizeKey kSizeKeys[] = {
+    { "playerStructSize", &MemoryOffsets::playerStructSize },
+    { "maxPlayers", &MemoryOffsets::maxPlayers },
+    { "playerNameOffset", &MemoryOffsets::playerNameOffset },
+    { "playerKillsOffset", &MemoryOffsets::playerKillsOffset },
+    { "playerDeathsOffset", &MemoryOffsets::playerDeathsOffset },
+    { "playerAssistsOffset", &MemoryOffsets::playerAssistsOffset },
+    { "playerMoneyOffset", &MemoryOffsets::playerMoneyOffset },
+    { "playerTeamOffset", &MemoryOffsets::playerTeamOffset },
+    { "playerAliveOffset", &MemoryOffsets::playerAliveOffset },
+    { "bombPlantedOffset", &MemoryOffsets::bombPlantedOffset },
+    { "bombTimerOffset", &MemoryOffsets::bombTimerOffset },
+    { "bombDefusedOffset", &MemoryOffsets::bombDefusedOffset },
+    { "roundNumberOffset", &MemoryOffsets::roundNumberOffset },
+    { "roundTimeOffset", &MemoryOffsets::roundTimeOffset },
+};
+
+/**
+ * @brief Read an integer given as a JSON number or a decimal/0x hex string
+ */
+bool parseInteger(const JsonValue& value, int64_t minValue, int64_t maxValue, int64_t& out) {
+    int64_t parsed = 0;
+    if (value.isNumber()) {
+        // Doubles hold integers exactly up to 2^53, far above any offset
+        if (!std::isfinite(value.number) || std::floor(value.number) != value.number ||
+            std::fabs(value.number) > 9007199254740992.0) {
+            return false;
+        }
+        parsed = static_cast<int64_t>(value.number);
+    } else if (value.isString() && !value.string.empty()) {
+        const char* begin = value.string.c_str();
+        char* end = nullptr;
+        errno = 0;
+        parsed = std::strtoll(begin, &end, 0);
+        if (errno != 0 || end == begin || *end != '\0') {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    if (parsed < minValue || parsed > maxValue) {
+        return false;
+    }
+    out = parsed;
+    return true;
+}
+
+bool parseUnsigned(const JsonValue& value, const std::string& name, uint64_t maxValue, uint64_t& out,
+                   std::string& error) {
+    int64_t parsed = 0;
+    int64_t limit = static_cast<int64_t>(std::min<uint64_t>(maxValue, std::numeric_limits<int64_t>::max()));
+    if (!parseInteger(value, 0, limit, parsed)) {
+        error = name + " must be a non-negative integer or 0x hex string";
+        return false;
+    }
+    out = static_cast<uint64_t>(parsed);
+    return true;
+}
+
+bool parsePath(const JsonValue& value, const std::string& name, PointerPath& out, std::string& error) {
+    if (!value.isObject()) {
+        error = name + " must be an object";
+        return false;
+    }
+
+    PointerPath path;
+    path.moduleName = value.getString("module");
+    if (path.moduleName.empty()) {
+        error = name + " needs a module name";
+        return false;
+    }
+
+    uint64_t number = 0;
+    const JsonValue* moduleOffset = value.find("moduleOffset");
+    if (moduleOffset != nullptr) {
+        if (!parseUnsigned(*moduleOffset, name + ".moduleOffset", std::numeric_limits<uintptr_t>::max(),
+                           number, error)) {
+            return false;
+        }
+        path.moduleOffset = static_cast<uintptr_t>(number);
+    }
+
+    const JsonValue* offsets = value.find("offsets");
+    if (offsets != nullptr) {
+        if (!offsets->isArray()) {
+            error = name + ".offsets must be an array";
+            return false;
+        }
+        for (const auto& offset : offsets->array) {
+            int64_t parsed = 0;
+            if (!parseInteger(offset, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max(),
+                              parsed)) {
+                error = name + ".offsets must hold 32-bit integers or 0x hex strings";
+                return false;
+            }
+            path.offsets.push_back(static_cast<int32_t>(parsed));
+        }
+    }
+
+    // A sentinel needs both its place and its value
+    const JsonValue* sentinelOffset = value.find("sentinelOffset");
+    const JsonValue* sentinelValue = value.find("sentinelValue");
+    if ((sentinelOffset == nullptr) != (sentinelValue == nullptr)) {
+        error = name + " needs both sentinelOffset and sentinelValue";
+        return false;
+    }
+    if (sentinelOffset != nullptr) {
+        int64_t parsed = 0;
+        if (!parseInteger(*sentinelOffset, std::numeric_limits<int32_t>::min(),
+                          std::numeric_limits<int32_t>::max(), parsed)) {
+            error = name + ".sentinelOffset must be a 32-bit integer";
+            return false;
+        }
+        path.sentinelOffset = static_cast<int32_t>(parsed);
+        if (!parseUnsigned(*sentinelValue, name + ".sentinelValue", std::numeric_limits<uint32_t>::max(),
+                           number, error)) {
+            return false;
+        }
+        path.sentinelValue = static_cast<uint32_t>(number);
+        path.hasSentinel = true;
+    }
+
+    out = path;
+    return true;
+}
+
+} // namespace
+
+bool parseMemoryOffsets(const JsonValue& document, MemoryOffsets& inOutOffsets, std::string& error) {
+    if (!document.isObject()) {
+        error = "offsets must be a JSON object";
+        return false;
+    }
+
+    MemoryOffsets offsets = inOutOffsets;
+    for (const auto& member : document.object) {
+        bool known = false;
+        uint64_t number = 0;
+
+        for (const auto& key : kAddressKeys) {
+            if (member.key == key.name) {
+                if (!parseUnsigned(member.value, member.key, std::numeric_limits<uintptr_t>::max(), number,
+                                   error)) {
+                    return false;
+                }
+                offsets.*key.member = static_cast<uintptr_t>(number);
+                known = true;
+            }
+        }
+        for (const auto& key : kPathKeys) {
+            if (member.key == key.name) {
+                if (!parsePath(member.value, member.key, offsets.*key.member, error)) {
+                    return false;
+                }
+                known = true;
+            }
+        }
+        for (const auto& key : kSizeKeys) {
+            if (member.key == key.name) {
+                if (!parseUnsigned(member.value, member.key, std::numeric_limits<size_t>::max(), number, error)) {
+                    return false;
+                }
+                offsets.*key.member = static_cast<size_t>(number);
+                known = true;
+            }
+        }
+
+        if (!known) {
+            error = "unknown offsets key: " + member.key;
+            return false;
+        }
+    }
+
+    inOutOffsets = offsets;
+    return true;
+}
+
+} // namespace CS16Capture
@@ -0,0 +1,57 @@
+#include "../include/player_layout.h"
+#include "../include/logger.h"
+#include <algorithm>
+
+namespace CS16Capture {
+
+bool decodePlayersRuntime(const MemoryOffsets& offsets, const uint8_t* span, NameTable& names,
+                          PlayerTable& outPlayers) {
+    if (offsets.maxPlayers > PlayerTable::kMaxPlayers) {
+        return false;
+    }
+
+    // Every field must fit inside one structure of the span
+    size_t lastField = std::max({ offsets.playerNameOffset + NameTable::kMaxNameLength,
+                                  offsets.playerKillsOffset + sizeof(int32_t),
+                                  offsets.playerDeathsOffset + sizeof(int32_t),
+                                  offsets.playerAssistsOffset + sizeof(int32_t),
+                                  offsets.playerMoneyOffset + sizeof(int32_t),
+                                  offsets.playerTeamOffset + sizeof(int32_t),
+                                  offsets.playerAliveOffset + sizeof(uint8_t) });
+    if (lastField > offsets.playerStructSize) {
+        return false;
+    }
+
+    for (size_t slot = 0; slot < offsets.maxPlayers; ++slot) {
+        const uint8_t* raw = span + slot * offsets.playerStructSize;
+        const char* name = reinterpret_cast<const char*>(raw + offsets.playerNameOffset);
+        if (name[0] == '\0') {
+            outPlayers.setAbsent(slot);  // Free slot
+            continue;
+        }
+
+        outPlayers.setPresent(slot, name, NameTable::kMaxNameLength);
+        outPlayers.nameIds[slot] = names.internSlot(slot, name, NameTable::kMaxNameLength);
+        outPlayers.kills[slot] = loadField<int32_t>(raw + offsets.playerKillsOffset);
+        outPlayers.deaths[slot] = loadField<int32_t>(raw + offsets.playerDeathsOffset);
+        outPlayers.assists[slot] = loadField<int32_t>(raw + offsets.playerAssistsOffset);
+        outPlayers.money[slot] = loadField<int32_t>(raw + offsets.playerMoneyOffset);
+        outPlayers.team[slot] = loadField<int32_t>(raw + offsets.playerTeamOffset);
+        outPlayers.alive[slot] = raw[offsets.playerAliveOffset] != 0;
+    }
+    for (size_t slot = offsets.maxPlayers; slot < PlayerTable::kMaxPlayers; ++slot) {
+        outPlayers.setAbsent(slot);
+    }
+    return true;
+}
+
+PlayerDecoder selectPlayerDecoder(const MemoryOffsets& offsets) {
+    if (matchesLayout<Steam8684Layout>(offsets)) {
+        LOG_DEBUG("Using compile-time player layout for Steam build 8684");
+        return &decodePlayers<Steam8684Layout>;
+    }
+
+    return &decodePlayersRuntime;
+}
+
+} // namespace CS16Capture
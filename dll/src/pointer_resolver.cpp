@@ -0,0 +1,151 @@
+#include "../include/pointer_resolver.h"
+#include "../include/logger.h"
+
+namespace CS16Capture {
+
+PointerResolver::PointerResolver(MemoryReader& reader, size_t pointerSize)
+    : reader_(reader)
+    , pointerSize_(pointerSize)
+    , generation_(1)
+{
+}
+
+size_t PointerResolver::addPath(const PointerPath& path) {
+    CachedChain chain;
+    chain.path = path;
+    chains_.push_back(chain);
+    return chains_.size() - 1;
+}
+
+void PointerResolver::clear() {
+    chains_.clear();
+    moduleBases_.clear();
+}
+
+bool PointerResolver::resolve(size_t handle, uintptr_t& outAddress) {
+    if (handle >= chains_.size()) {
+        return false;
+    }
+
+    CachedChain& chain = chains_[handle];
+    if (chain.valid && chain.generation == generation_ && revalidate(chain)) {
+        ++stats_.hits;
+        outAddress = chain.finalAddress;
+        return true;
+    }
+
+    ++stats_.misses;
+    if (!walk(chain)) {
+        ++stats_.walkFailures;
+        return false;
+    }
+
+    outAddress = chain.finalAddress;
+    return true;
+}
+
+void PointerResolver::invalidate() {
+    ++generation_;
+}
+
+PointerResolverStats PointerResolver::getStats() const {
+    return stats_;
+}
+
+void PointerResolver::resetStats() {
+    stats_ = PointerResolverStats();
+}
+
+bool PointerResolver::readPointer(uintptr_t address, uintptr_t& outValue) {
+    if (pointerSize_ == 4) {
+        uint32_t value = 0;
+        if (!reader_.readMemory(address, value)) {
+            return false;
+        }
+        outValue = value;
+        return true;
+    }
+
+    uint64_t value = 0;
+    if (!reader_.readMemory(address, value)) {
+        return false;
+    }
+    outValue = static_cast<uintptr_t>(value);
+    return true;
+}
+
+bool PointerResolver::revalidate(const CachedChain& chain) {
+    // The root slot is where a reload (new map, reallocated entity list)
+    // shows up first; deeper levels are covered by the sentinel
+    if (!chain.links.empty()) {
+        uintptr_t root = 0;
+        if (!readPointer(chain.rootAddress, root) || root != chain.links[0]) {
+            return false;
+        }
+    }
+
+    return checkSentinel(chain);
+}
+
+bool PointerResolver::checkSentinel(const CachedChain& chain) {
+    if (!chain.path.hasSentinel) {
+        return true;
+    }
+
+    uint32_t sentinel = 0;
+    return reader_.readMemory(chain.finalAddress + chain.path.sentinelOffset, sentinel) &&
+           sentinel == chain.path.sentinelValue;
+}
+
+bool PointerResolver::walk(CachedChain& chain) {
+    chain.valid = false;
+
+    // A failed walk may mean the module was reloaded at another base,
+    // so the second attempt looks the base up again
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        chain.links.clear();
+
+        uintptr_t address = getModuleBase(chain.path.moduleName, attempt > 0);
+        if (address == 0) {
+            continue;
+        }
+        address += chain.path.moduleOffset;
+        chain.rootAddress = address;
+
+        bool complete = true;
+        for (int32_t offset : chain.path.offsets) {
+            uintptr_t pointer = 0;
+            if (!readPointer(address, pointer) || pointer == 0) {
+                complete = false;
+                break;
+            }
+            chain.links.push_back(pointer);
+            address = pointer + offset;
+        }
+
+        if (complete) {
+            chain.finalAddress = address;
+            chain.generation = generation_;
+            chain.valid = checkSentinel(chain);
+            if (chain.valid) {
+                return true;
+            }
+        }
+    }
+
+    LOG_DEBUG("Pointer chain from " + chain.path.moduleName + " could not be resolved");
+    return false;
+}
+
+uintptr_t PointerResolver::getModuleBase(const std::string& moduleName, bool refresh) {
+    auto it = moduleBases_.find(moduleName);
+    if (it != moduleBases_.end() && !refresh) {
+        return it->second;
+    }
+
+    uintptr_t base = reader_.getModuleBase(moduleName);
+    moduleBases_[moduleName] = base;
+    return base;
+}
+
+} // namespace CS16Capture
@@ -0,0 +1,92 @@
+#include "../include/process_watcher.h"
+#include "../include/logger.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <tlhelp32.h>
+#else
+#include <dirent.h>
+#include <cctype>
+#include <fstream>
+#endif
+
+namespace CS16Capture {
+
+ProcessWatcher::ProcessWatcher(const std::vector<std::string>& processNames)
+    : processNames_(processNames)
+{
+}
+
+void ProcessWatcher::poll(std::vector<uint32_t>& started, std::vector<uint32_t>& exited) {
+    std::unordered_set<uint32_t> current;
+    listProcesses(current);
+
+    for (uint32_t processId : current) {
+        if (knownProcesses_.count(processId) == 0) {
+            started.push_back(processId);
+        }
+    }
+    for (uint32_t processId : knownProcesses_) {
+        if (current.count(processId) == 0) {
+            exited.push_back(processId);
+        }
+    }
+
+    knownProcesses_.swap(current);
+}
+
+void ProcessWatcher::forget(uint32_t processId) {
+    knownProcesses_.erase(processId);
+}
+
+bool ProcessWatcher::isWatchedName(const std::string& name) const {
+    for (const auto& watched : processNames_) {
+        if (name == watched) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ProcessWatcher::listProcesses(std::unordered_set<uint32_t>& outIds) const {
+#ifdef _WIN32
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("Failed to snapshot process list");
+        return;
+    }
+
+    PROCESSENTRY32 entry;
+    entry.dwSize = sizeof(entry);
+    if (Process32First(snapshot, &entry)) {
+        do {
+            if (isWatchedName(entry.szExeFile)) {
+                outIds.insert(entry.th32ProcessID);
+            }
+        } while (Process32Next(snapshot, &entry));
+    }
+    CloseHandle(snapshot);
+#else
+    DIR* proc = opendir("/proc");
+    if (proc == nullptr) {
+        LOG_ERROR("Failed to open /proc");
+        return;
+    }
+
+    while (dirent* entry = readdir(proc)) {
+        if (!std::isdigit(static_cast<unsigned char>(entry->d_name[0]))) {
+            continue;
+        }
+
+        // comm holds the executable name truncated to 15 characters
+        std::ifstream comm(std::string("/proc/") + entry->d_name + "/comm");
+        std::string name;
+        if (std::getline(comm, name) && isWatchedName(name)) {
+            outIds.insert(static_cast<uint32_t>(std::stoul(entry->d_name)));
+        }
+    }
+    closedir(proc);
+#endif
+}
+
+} // namespace CS16Capture
@@ -0,0 +1,230 @@
+#include "../include/send_lanes.h"
+#include <algorithm>
+
+namespace CS16Capture {
+
+namespace {
+
+const size_t kNotFound = static_cast<size_t>(-1);
+
+size_t laneIndex(SendLane lane) {
+    return static_cast<size_t>(lane);
+}
+
+} // namespace
+
+SendLanes::SendLanes(const SendLaneConfig& config)
+    : nextOrder_(0)
+    , size_(0)
+{
+    configure(config);
+}
+
+void SendLanes::configure(const SendLaneConfig& config) {
+    config_ = config;
+    for (size_t i = 0; i < kSendLaneCount; ++i) {
+        config_.capacity[i] = std::max<size_t>(config_.capacity[i], 1);
+        config_.weight[i] = std::max<uint32_t>(config_.weight[i], 1);
+
+        Lane& lane = lanes_[i];
+        lane.slots.clear();
+        lane.slots.resize(config_.capacity[i]);
+        lane.head = 0;
+        lane.size = 0;
+        lane.credit = 0;
+        lane.stats = SendLaneStats();
+    }
+    size_ = 0;
+}
+
+const SendLaneConfig& SendLanes::getConfig() const {
+    return config_;
+}
+
+void SendLanes::clear() {
+    for (Lane& lane : lanes_) {
+        lane.head = 0;
+        lane.size = 0;
+        lane.credit = 0;
+    }
+    size_ = 0;
+}
+
+bool SendLanes::push(SendLane lane, std::string& message, uint64_t captureTimeNs, uint64_t stream,
+                     uint32_t topics) {
+    Lane& target = lanes_[laneIndex(lane)];
+    Lane& state = lanes_[laneIndex(SendLane::STATE)];
+    if (lane == SendLane::EVENTS && target.size == target.slots.size()) {
+        // Checked before superseding, so a refused frame leaves the queue as it was
+        ++target.stats.refused;
+        return false;
+    }
+    ++target.stats.queued;
+
+    size_t index = stream != 0 ? findSuperseded(state, stream, topics) : kNotFound;
+    if (index != kNotFound) {
+        ++state.stats.superseded;
+        if (lane == SendLane::STATE) {
+            // The newer frame takes over the queued one's turn, but still
+            // leaves after the event frames queued before it
+            Entry& entry = state.at(index);
+            entry.message.swap(message);
+            entry.captureTimeNs = captureTimeNs;
+            entry.topics = topics;
+            entry.order = ++nextOrder_;
+            return true;
+        }
+        erase(state, index);
+    }
+
+    if (target.size == target.slots.size()) {
+        // Drop the oldest message of the lane: live consumers care about the newest
+        target.head = (target.head + 1) % target.slots.size();
+        --target.size;
+        --size_;
+        ++target.stats.dropped;
+    }
+
+    // Swap rather than move so the slot's old buffer goes back to the caller
+    Entry& entry = target.at(target.size);
+    entry.message.swap(message);
+    entry.captureTimeNs = captureTimeNs;
+    entry.stream = stream;
+    entry.topics = topics;
+    entry.order = ++nextOrder_;
+    ++target.size;
+    ++size_;
+    return true;
+}
+
+bool SendLanes::pop(std::string& message, uint64_t& captureTimeNs, SendLane& lane) {
+    if (size_ == 0) {
+        return false;
+    }
+
+    size_t picked = pickLane();
+    lane = static_cast<SendLane>(picked);
+
+    // A frame waits for the older frames of its stream in the other lane
+    uint64_t stream = lanes_[picked].at(0).stream;
+    if (stream != 0 && lane != SendLane::STATS) {
+        SendLane otherLane = lane == SendLane::EVENTS ? SendLane::STATE : SendLane::EVENTS;
+        Lane& other = lanes_[laneIndex(otherLane)];
+        size_t index = findStream(other, stream);
+        if (index != kNotFound && other.at(index).order < lanes_[picked].at(0).order) {
+            take(other, index, message, captureTimeNs);
+            lane = otherLane;
+            return true;
+        }
+    }
+
+    take(lanes_[picked], 0, message, captureTimeNs);
+    return true;
+}
+
+size_t SendLanes::size() const {
+    return size_;
+}
+
+bool SendLanes::empty() const {
+    return size_ == 0;
+}
+
+uint64_t SendLanes::getDroppedCount() const {
+    uint64_t dropped = 0;
+    for (const Lane& lane : lanes_) {
+        dropped += lane.stats.dropped;
+    }
+    return dropped;
+}
+
+uint64_t SendLanes::getSupersededCount() const {
+    uint64_t superseded = 0;
+    for (const Lane& lane : lanes_) {
+        superseded += lane.stats.superseded;
+    }
+    return superseded;
+}
+
+SendLaneStats SendLanes::getStats(SendLane lane) const {
+    SendLaneStats stats = lanes_[laneIndex(lane)].stats;
+    stats.pending = lanes_[laneIndex(lane)].size;
+    return stats;
+}
+
+size_t SendLanes::findStream(const Lane& lane, uint64_t stream) const {
+    for (size_t i = 0; i < lane.size; ++i) {
+        if (lane.at(i).stream == stream) {
+            return i;
+        }
+    }
+    return kNotFound;
+}
+
+size_t SendLanes::findSuperseded(const Lane& lane, uint64_t stream, uint32_t topics) const {
+    // Only the newest frame of the stream: replacing an older one would put
+    // new data ahead of the frames queued after it
+    for (size_t i = lane.size; i-- > 0;) {
+        const Entry& entry = lane.at(i);
+        if (entry.stream == stream) {
+            return (entry.topics & ~topics) == 0 ? i : kNotFound;
+        }
+    }
+    return kNotFound;
+}
+
+void SendLanes::erase(Lane& lane, size_t index) {
+    // Shift the later entries forward; the erased slot ends up past the tail
+    for (size_t i = index; i + 1 < lane.size; ++i) {
+        std::swap(lane.at(i), lane.at(i + 1));
+    }
+    --lane.size;
+    --size_;
+}
+
+size_t SendLanes::pickLane() {
+    if (config_.scheduling == LaneScheduling::STRICT) {
+        for (size_t i = 0; i < kSendLaneCount; ++i) {
+            if (lanes_[i].size > 0) {
+                return i;
+            }
+        }
+    }
+
+    // Smooth weighted round robin: every waiting lane earns its weight, the
+    // richest one sends and pays the total, which interleaves the lanes
+    // evenly instead of in bursts
+    int64_t total = 0;
+    size_t best = kNotFound;
+    for (size_t i = 0; i < kSendLaneCount; ++i) {
+        Lane& lane = lanes_[i];
+        if (lane.size == 0) {
+            lane.credit = 0;
+            continue;
+        }
+        lane.credit += config_.weight[i];
+        total += config_.weight[i];
+        if (best == kNotFound || lane.credit > lanes_[best].credit) {
+            best = i;
+        }
+    }
+    lanes_[best].credit -= total;
+    return best;
+}
+
+void SendLanes::take(Lane& lane, size_t index, std::string& message, uint64_t& captureTimeNs) {
+    Entry& entry = lane.at(index);
+    message.clear();
+    message.swap(entry.message);
+    captureTimeNs = entry.captureTimeNs;
+    if (index == 0) {
+        lane.head = (lane.head + 1) % lane.slots.size();
+        --lane.size;
+        --size_;
+    } else {
+        erase(lane, index);
+    }
+    ++lane.stats.sent;
+}
+
+} // namespace CS16Capture
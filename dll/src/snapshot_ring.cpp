@@ -0,0 +1,377 @@
+#include "../include/snapshot_ring.h"
+#include "../include/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <ctime>
+#endif
+
+namespace CS16Capture {
+
+namespace {
+
+size_t ringSize(uint32_t slotCount) {
+    return sizeof(SnapshotRingHeader) + static_cast<size_t>(slotCount) * sizeof(SnapshotSlot);
+}
+
+#ifdef _WIN32
+std::string objectName(const std::string& name) {
+    return (!name.empty() && name[0] == '/') ? name.substr(1) : name;
+}
+#else
+std::string objectName(const std::string& name) {
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+long futex(const std::atomic<uint32_t>* word, int op, uint32_t value, const timespec* timeout) {
+    // Shared (non-private) futex: waiters and waker live in different processes
+    return syscall(SYS_futex, reinterpret_cast<const uint32_t*>(word), op, value, timeout, nullptr, 0);
+}
+#endif
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+SnapshotWriter::SnapshotWriter()
+    : header_(nullptr)
+    , slots_(nullptr)
+    , mappedSize_(0)
+#ifdef _WIN32
+    , mappingHandle_(nullptr)
+#endif
+{
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    close();
+}
+
+bool SnapshotWriter::create(const std::string& name, uint32_t slotCount) {
+    if (header_ != nullptr) {
+        return true;
+    }
+    if (slotCount < 2) {
+        LOG_ERROR("Snapshot ring needs at least 2 slots");
+        return false;
+    }
+
+    name_ = objectName(name);
+    size_t size = ringSize(slotCount);
+
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                        static_cast<DWORD>(size), name_.c_str());
+    if (mapping == nullptr) {
+        LOG_ERROR("Failed to create snapshot ring " + name_ + ": " + std::to_string(GetLastError()));
+        return false;
+    }
+    void* memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (memory == nullptr) {
+        LOG_ERROR("Failed to map snapshot ring " + name_ + ": " + std::to_string(GetLastError()));
+        CloseHandle(mapping);
+        return false;
+    }
+    mappingHandle_ = mapping;
+#else
+    // Replace a ring left behind by a crashed writer; its readers keep the old mapping
+    shm_unlink(name_.c_str());
+    int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Failed to create snapshot ring " + name_ + ": errno " + std::to_string(errno));
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) < 0) {
+        LOG_ERROR("Failed to size snapshot ring " + name_ + ": errno " + std::to_string(errno));
+        ::close(fd);
+        shm_unlink(name_.c_str());
+        return false;
+    }
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        LOG_ERROR("Failed to map snapshot ring " + name_ + ": errno " + std::to_string(errno));
+        shm_unlink(name_.c_str());
+        return false;
+    }
+#endif
+
+    header_ = new (memory) SnapshotRingHeader();
+    header_->slotCount = slotCount;
+    header_->slotSize = sizeof(SnapshotSlot);
+    header_->version = kSnapshotLayoutVersion;
+    header_->writeSequence.store(0, std::memory_order_relaxed);
+    header_->wakeCounter.store(0, std::memory_order_relaxed);
+
+    slots_ = reinterpret_cast<SnapshotSlot*>(static_cast<uint8_t*>(memory) + sizeof(SnapshotRingHeader));
+    for (uint32_t i = 0; i < slotCount; ++i) {
+        SnapshotSlot* slot = new (&slots_[i]) SnapshotSlot();
+        slot->sequence.store(0, std::memory_order_relaxed);
+    }
+    mappedSize_ = size;
+
+    // Readers reject the ring until the magic is in place
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = kSnapshotMagic;
+
+    LOG_INFO("Snapshot ring " + name_ + " created (" + std::to_string(slotCount) + " slots, " +
+             std::to_string(size) + " bytes)");
+    return true;
+}
+
+void SnapshotWriter::close() {
+    if (header_ == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(header_);
+    CloseHandle(mappingHandle_);
+    mappingHandle_ = nullptr;
+#else
+    munmap(header_, mappedSize_);
+    shm_unlink(name_.c_str());
+#endif
+
+    header_ = nullptr;
+    slots_ = nullptr;
+    mappedSize_ = 0;
+}
+
+bool SnapshotWriter::isOpen() const {
+    return header_ != nullptr;
+}
+
+uint64_t SnapshotWriter::getSequence() const {
+    return header_ != nullptr ? header_->writeSequence.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t SnapshotWriter::publish(const GameState& state, uint32_t instanceId) {
+    if (header_ == nullptr) {
+        return 0;
+    }
+
+    uint64_t sequence = header_->writeSequence.load(std::memory_order_relaxed) + 1;
+    SnapshotSlot& slot = slots_[sequence % header_->slotCount];
+
+    // Mark the slot as being written before touching the frame
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    SnapshotFrame& frame = slot.frame;
+    frame.sequence = sequence;
+    frame.captureTimeNs = state.captureTimeNs != 0 ? state.captureTimeNs : nowNs();
+    frame.instanceId = instanceId;
+    frame.roundNumber = state.roundNumber;
+    frame.roundTime = state.roundTime;
+    frame.bombTimeRemaining = state.bomb.timeRemaining;
+    frame.bombPlanted = state.bomb.planted ? 1 : 0;
+    frame.bombDefused = state.bomb.defused ? 1 : 0;
+
+    size_t eventCount = std::min(state.events.size(), kMaxSnapshotEvents);
+    frame.eventCount = static_cast<uint8_t>(eventCount);
+    for (size_t i = 0; i < eventCount; ++i) {
+        frame.events[i] = static_cast<uint8_t>(state.events[i]);
+    }
+    frame.players = state.players;
+
+    slot.sequence.store(sequence, std::memory_order_release);
+    header_->writeSequence.store(sequence, std::memory_order_release);
+    header_->wakeCounter.fetch_add(1, std::memory_order_release);
+
+#ifndef _WIN32
+    // Readers map the ring read-only and cannot register as waiters, so wake
+    // unconditionally; with nobody waiting this is a cheap hash lookup
+    futex(&header_->wakeCounter, FUTEX_WAKE, INT32_MAX, nullptr);
+#endif
+
+    return sequence;
+}
+
+SnapshotReader::SnapshotReader()
+    : header_(nullptr)
+    , slots_(nullptr)
+    , mappedSize_(0)
+    , nextSequence_(1)
+    , lostFrames_(0)
+#ifdef _WIN32
+    , mappingHandle_(nullptr)
+#endif
+{
+}
+
+SnapshotReader::~SnapshotReader() {
+    close();
+}
+
+bool SnapshotReader::open(const std::string& name) {
+    if (header_ != nullptr) {
+        return true;
+    }
+
+    std::string object = objectName(name);
+    const void* memory = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, object.c_str());
+    if (mapping == nullptr) {
+        LOG_ERROR("Failed to open snapshot ring " + object + ": " + std::to_string(GetLastError()));
+        return false;
+    }
+    memory = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (memory == nullptr) {
+        LOG_ERROR("Failed to map snapshot ring " + object + ": " + std::to_string(GetLastError()));
+        CloseHandle(mapping);
+        return false;
+    }
+    MEMORY_BASIC_INFORMATION info;
+    size = VirtualQuery(memory, &info, sizeof(info)) != 0 ? info.RegionSize : 0;
+    mappingHandle_ = mapping;
+#else
+    int fd = shm_open(object.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open snapshot ring " + object + ": errno " + std::to_string(errno));
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0 || static_cast<size_t>(info.st_size) < sizeof(SnapshotRingHeader)) {
+        LOG_ERROR("Snapshot ring " + object + " is not initialized");
+        ::close(fd);
+        return false;
+    }
+    size = static_cast<size_t>(info.st_size);
+    memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        LOG_ERROR("Failed to map snapshot ring " + object + ": errno " + std::to_string(errno));
+        return false;
+    }
+#endif
+
+    header_ = static_cast<const SnapshotRingHeader*>(memory);
+    slots_ = reinterpret_cast<const SnapshotSlot*>(static_cast<const uint8_t*>(memory) + sizeof(SnapshotRingHeader));
+    mappedSize_ = size;
+
+    bool valid = header_->magic == kSnapshotMagic;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid || header_->version != kSnapshotLayoutVersion || header_->slotSize != sizeof(SnapshotSlot) ||
+        header_->slotCount < 2 || size < ringSize(header_->slotCount)) {
+        LOG_ERROR("Snapshot ring " + object + " has an incompatible layout (version " +
+                  std::to_string(header_->version) + ", expected " + std::to_string(kSnapshotLayoutVersion) + ")");
+        close();
+        return false;
+    }
+
+    // Start at the newest frame; history before joining is not interesting
+    uint64_t latest = getLatestSequence();
+    nextSequence_ = latest > 0 ? latest : 1;
+    lostFrames_ = 0;
+    return true;
+}
+
+void SnapshotReader::close() {
+    if (header_ == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(header_);
+    CloseHandle(mappingHandle_);
+    mappingHandle_ = nullptr;
+#else
+    munmap(const_cast<SnapshotRingHeader*>(header_), mappedSize_);
+#endif
+
+    header_ = nullptr;
+    slots_ = nullptr;
+    mappedSize_ = 0;
+}
+
+bool SnapshotReader::isOpen() const {
+    return header_ != nullptr;
+}
+
+uint64_t SnapshotReader::getLatestSequence() const {
+    return header_->writeSequence.load(std::memory_order_acquire);
+}
+
+SnapshotReadStatus SnapshotReader::read(uint64_t sequence, SnapshotFrame& outFrame) const {
+    return visit(sequence, [&outFrame](const SnapshotFrame& frame) {
+        std::memcpy(&outFrame, &frame, sizeof(SnapshotFrame));
+    });
+}
+
+bool SnapshotReader::next(SnapshotFrame& outFrame) {
+    uint64_t latest = getLatestSequence();
+    while (nextSequence_ <= latest) {
+        if (read(nextSequence_, outFrame) == SnapshotReadStatus::OK) {
+            ++nextSequence_;
+            return true;
+        }
+
+        // Overwritten: the writer may already be reusing the slot after
+        // latest, so the oldest frame still safe to read is latest + 2 - slots
+        latest = getLatestSequence();
+        uint64_t oldestSafe = latest + 2 > header_->slotCount ? latest + 2 - header_->slotCount : 1;
+        uint64_t resume = std::max(nextSequence_ + 1, oldestSafe);
+        lostFrames_ += resume - nextSequence_;
+        nextSequence_ = resume;
+    }
+    return false;
+}
+
+bool SnapshotReader::waitForFrame(uint32_t timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    while (true) {
+        uint32_t counter = header_->wakeCounter.load(std::memory_order_acquire);
+        if (getLatestSequence() >= nextSequence_) {
+            return true;
+        }
+
+        auto remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::nanoseconds::zero()) {
+            return false;
+        }
+
+#ifdef _WIN32
+        (void)counter;
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+            remaining, std::chrono::milliseconds(1)));
+#else
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+        timespec timeout;
+        timeout.tv_sec = static_cast<time_t>(ns / 1000000000);
+        timeout.tv_nsec = static_cast<long>(ns % 1000000000);
+        // Returns at once if a publish changed the counter since we loaded it
+        futex(&header_->wakeCounter, FUTEX_WAIT, counter, &timeout);
+#endif
+    }
+}
+
+uint64_t SnapshotReader::getLostFrameCount() const {
+    return lostFrames_;
+}
+
+} // namespace CS16Capture
@@ -0,0 +1,544 @@
+#include "../include/state_encoder.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+
+namespace CS16Capture {
+
+namespace {
+
+void appendInt(std::string& out, int64_t value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void appendFloat(std::string& out, float value) {
+    // Garbage memory can decode to NaN/inf, which JSON cannot represent
+    if (!std::isfinite(value)) {
+        value = 0.0f;
+    }
+
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void appendBool(std::string& out, bool value) {
+    out.append(value ? "true" : "false");
+}
+
+void appendJsonString(std::string& out, const char* value) {
+    static const char hexDigits[] = "0123456789abcdef";
+
+    out.push_back('"');
+    for (; *value != '\0'; ++value) {
+        char c = *value;
+        switch (c) {
+            case '"':  out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out.append("\\u00");
+                    out.push_back(hexDigits[(c >> 4) & 0x0F]);
+                    out.push_back(hexDigits[c & 0x0F]);
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+const char* roundWinnerToString(RoundWinner winner) {
+    switch (winner) {
+        case RoundWinner::TERRORISTS:         return "\"t\"";
+        case RoundWinner::COUNTER_TERRORISTS: return "\"ct\"";
+        default:                              return "null";
+    }
+}
+
+const char* roundEndReasonToString(RoundEndReason reason) {
+    switch (reason) {
+        case RoundEndReason::ELIMINATION:   return "elimination";
+        case RoundEndReason::BOMB_EXPLODED: return "bombExploded";
+        case RoundEndReason::BOMB_DEFUSED:  return "bombDefused";
+        case RoundEndReason::TIME_EXPIRED:  return "timeExpired";
+        default:                            return "unknown";
+    }
+}
+
+const char* buyTypeToString(BuyType buy) {
+    switch (buy) {
+        case BuyType::FORCE: return "force";
+        case BuyType::FULL:  return "full";
+        default:             return "eco";
+    }
+}
+
+} // namespace
+
+StateEncoder::StateEncoder(int64_t instanceId)
+    : instanceId_(instanceId)
+    , connectionGeneration_(0)
+    , frameSequence_(0)
+    , nameTable_(nullptr)
+    , nameEpoch_(0)
+    , frameTopics_(0)
+    , frameReplaceable_(true)
+    , subscriptionVersion_(0)
+    , lastSentNs_()
+    , topicSent_()
+    , statsGeneration_(0)
+    , statsRoundsSent_(0)
+{
+    pendingEvents_.reserve(16);
+    frameEvents_.reserve(16);
+}
+
+void StateEncoder::resync() {
+    sentNames_.assign(sentNames_.size(), false);
+}
+
+void StateEncoder::discardFrame() {
+    // Every frame carries at least one topic; none means nothing to take back
+    if (frameTopics_ == 0) {
+        return;
+    }
+    --frameSequence_;
+    for (uint16_t id : newNames_) {
+        sentNames_[id] = false;
+    }
+    newNames_.clear();
+
+    // The frame's events come before any captured since
+    size_t room = kMaxPendingEvents - std::min(pendingEvents_.size(), kMaxPendingEvents);
+    pendingEvents_.insert(pendingEvents_.begin(), frameEvents_.begin(),
+                          frameEvents_.begin() + static_cast<std::ptrdiff_t>(std::min(room, frameEvents_.size())));
+    frameEvents_.clear();
+    frameTopics_ = 0;
+}
+
+void StateEncoder::setSubscription(const Subscription& subscription, uint64_t version) {
+    subscription_ = subscription;
+    subscriptionVersion_ = version;
+
+    // New topics go out with the next frame
+    for (size_t i = 0; i < kTopicCount; ++i) {
+        topicSent_[i] = false;
+    }
+
+    // Events waiting for their rate slot still go out unless events were unsubscribed
+    if (!subscription_.get(Topic::EVENTS).enabled) {
+        pendingEvents_.clear();
+    }
+}
+
+uint64_t StateEncoder::getSubscriptionVersion() const {
+    return subscriptionVersion_;
+}
+
+uint64_t StateEncoder::getConnectionGeneration() const {
+    return connectionGeneration_;
+}
+
+uint32_t StateEncoder::getFrameTopics() const {
+    return frameTopics_;
+}
+
+bool StateEncoder::isFrameReplaceable() const {
+    return frameReplaceable_;
+}
+
+bool StateEncoder::isNameSent(uint16_t id) const {
+    return id < sentNames_.size() && sentNames_[id];
+}
+
+void StateEncoder::markNameSent(uint16_t id) {
+    if (id >= sentNames_.size()) {
+        sentNames_.resize(id + 1, false);
+    }
+    sentNames_[id] = true;
+}
+
+void StateEncoder::encode(const GameState& state, uint64_t connectionGeneration, std::string& out) {
+    uint64_t nowNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    encode(state, connectionGeneration, out, nowNs);
+}
+
+void StateEncoder::encode(const GameState& state, uint64_t connectionGeneration, std::string& out, uint64_t nowNs) {
+    out.clear();
+    frameTopics_ = 0;
+    frameReplaceable_ = true;
+    frameEvents_.clear();
+
+    const NameTable* table = state.nameTable;
+    if (connectionGeneration != connectionGeneration_) {
+        frameSequence_ = 0;
+    }
+    if (connectionGeneration != connectionGeneration_ || table != nameTable_ ||
+        (table != nullptr && table->getEpoch() != nameEpoch_)) {
+        connectionGeneration_ = connectionGeneration;
+        nameTable_ = table;
+        nameEpoch_ = table != nullptr ? table->getEpoch() : 0;
+        resync();
+    }
+
+    // Which topics are due at their requested rate
+    bool due[kTopicCount];
+    for (size_t i = 0; i < kTopicCount; ++i) {
+        const TopicSubscription& topic = subscription_.topics[i];
+        due[i] = topic.enabled &&
+                 (!topicSent_[i] || nowNs - lastSentNs_[i] >= topic.minIntervalNs);
+    }
+
+    const TopicSubscription& eventsTopic = subscription_.get(Topic::EVENTS);
+    if (eventsTopic.enabled) {
+        for (GameEvent event : state.events) {
+            if (pendingEvents_.size() < kMaxPendingEvents) {
+                pendingEvents_.push_back(event);
+            }
+        }
+    }
+
+    bool playersDue = due[static_cast<size_t>(Topic::PLAYERS)];
+    bool bombDue = due[static_cast<size_t>(Topic::BOMB)];
+    bool eventsDue = due[static_cast<size_t>(Topic::EVENTS)];
+    bool roundDue = due[static_cast<size_t>(Topic::ROUND)];
+
+    // Events alone only make a frame when there is something to report
+    if (!playersDue && !bombDue && !roundDue && (!eventsDue || pendingEvents_.empty())) {
+        return;
+    }
+
+    const uint32_t playerFields = subscription_.get(Topic::PLAYERS).fields;
+    newNames_.clear();
+    if (playersDue && table != nullptr && (playerFields & PlayerFields::NAME)) {
+        for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+            uint16_t id = state.players.nameIds[slot];
+            if (state.players.isPresent(slot) && id != NameTable::kInvalidId && !isNameSent(id)) {
+                markNameSent(id);
+                newNames_.push_back(id);
+            }
+        }
+    }
+
+    out.push_back('{');
+    bool first = true;
+    // Keys are passed with their leading comma, which the first one skips
+    auto key = [&out, &first](const char* separatedKey) {
+        out.append(first ? separatedKey + 1 : separatedKey);
+        first = false;
+    };
+
+    if (instanceId_ >= 0) {
+        key(",\"instance\":");
+        appendInt(out, instanceId_);
+    }
+
+    // Consecutive per connection, so the receiver can count dropped frames
+    key(",\"seq\":");
+    appendInt(out, static_cast<int64_t>(++frameSequence_));
+    if (state.captureTimeNs != 0) {
+        key(",\"captureTime\":");
+        appendInt(out, static_cast<int64_t>(state.captureTimeNs / 1000));
+    }
+
+    // Names first seen on this connection
+    if (!newNames_.empty()) {
+        frameReplaceable_ = false;
+        key(",\"names\":");
+        out.push_back('[');
+        for (size_t i = 0; i < newNames_.size(); ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            out.append("{\"id\":");
+            appendInt(out, newNames_[i]);
+            out.append(",\"name\":");
+            appendJsonString(out, table->getName(newNames_[i]).c_str());
+            out.push_back('}');
+        }
+        out.push_back(']');
+    }
+
+    // Players array
+    if (playersDue) {
+        key(",\"players\":");
+        encodePlayers(state.players, table, playerFields, out);
+        frameTopics_ |= 1u << static_cast<uint32_t>(Topic::PLAYERS);
+        topicSent_[static_cast<size_t>(Topic::PLAYERS)] = true;
+        lastSentNs_[static_cast<size_t>(Topic::PLAYERS)] = nowNs;
+    }
+
+    // Bomb data
+    if (bombDue) {
+        const uint32_t fields = subscription_.get(Topic::BOMB).fields;
+        bool firstField = true;
+        auto field = [&out, &firstField](const char* separatedKey) {
+            out.append(firstField ? separatedKey + 1 : separatedKey);
+            firstField = false;
+        };
+
+        key(",\"bomb\":");
+        out.push_back('{');
+        if (fields & BombFields::PLANTED) {
+            field(",\"planted\":");
+            appendBool(out, state.bomb.planted);
+        }
+        if (fields & BombFields::TIME_REMAINING) {
+            field(",\"timeRemaining\":");
+            appendFloat(out, state.bomb.timeRemaining);
+        }
+        if (fields & BombFields::DEFUSED) {
+            field(",\"defused\":");
+            appendBool(out, state.bomb.defused);
+        }
+        out.push_back('}');
+        frameTopics_ |= 1u << static_cast<uint32_t>(Topic::BOMB);
+        topicSent_[static_cast<size_t>(Topic::BOMB)] = true;
+        lastSentNs_[static_cast<size_t>(Topic::BOMB)] = nowNs;
+    }
+
+    // Events array, including those held back from rate-limited frames
+    if (eventsDue) {
+        key(",\"events\":");
+        out.push_back('[');
+        for (size_t i = 0; i < pendingEvents_.size(); ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            out.push_back('"');
+            out.append(gameEventToString(pendingEvents_[i]));
+            out.push_back('"');
+        }
+        out.push_back(']');
+        if (!pendingEvents_.empty()) {
+            frameTopics_ |= 1u << static_cast<uint32_t>(Topic::EVENTS);
+            frameReplaceable_ = false;
+        }
+        // Kept until the next frame in case this one is discarded
+        frameEvents_.swap(pendingEvents_);
+        pendingEvents_.clear();
+        topicSent_[static_cast<size_t>(Topic::EVENTS)] = true;
+        lastSentNs_[static_cast<size_t>(Topic::EVENTS)] = nowNs;
+    }
+
+    // Round info
+    if (roundDue) {
+        const uint32_t fields = subscription_.get(Topic::ROUND).fields;
+        if (fields & RoundFields::NUMBER) {
+            key(",\"roundNumber\":");
+            appendInt(out, state.roundNumber);
+        }
+        if (fields & RoundFields::TIME) {
+            key(",\"roundTime\":");
+            appendFloat(out, state.roundTime);
+        }
+        frameTopics_ |= 1u << static_cast<uint32_t>(Topic::ROUND);
+        topicSent_[static_cast<size_t>(Topic::ROUND)] = true;
+        lastSentNs_[static_cast<size_t>(Topic::ROUND)] = nowNs;
+    }
+
+    out.append("}\n");
+}
+
+void StateEncoder::encodeStats(const MatchStats& stats, const NameTable* names, uint64_t connectionGeneration,
+                               std::string& out) {
+    uint64_t nowNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    encodeStats(stats, names, connectionGeneration, out, nowNs);
+}
+
+void StateEncoder::encodeStats(const MatchStats& stats, const NameTable* names, uint64_t connectionGeneration,
+                               std::string& out, uint64_t nowNs) {
+    out.clear();
+
+    const size_t topic = static_cast<size_t>(Topic::STATS);
+    const TopicSubscription& subscription = subscription_.topics[topic];
+    bool due = subscription.enabled &&
+               (!topicSent_[topic] || connectionGeneration != statsGeneration_ ||
+                stats.getFinishedRounds() != statsRoundsSent_ ||
+                (subscription.minIntervalNs != 0 && nowNs - lastSentNs_[topic] >= subscription.minIntervalNs));
+    if (!due) {
+        return;
+    }
+    topicSent_[topic] = true;
+    lastSentNs_[topic] = nowNs;
+    statsGeneration_ = connectionGeneration;
+    statsRoundsSent_ = stats.getFinishedRounds();
+
+    out.append("{\"type\":\"stats\"");
+    if (instanceId_ >= 0) {
+        out.append(",\"instance\":");
+        appendInt(out, instanceId_);
+    }
+    out.append(",\"finishedRounds\":");
+    appendInt(out, static_cast<int64_t>(stats.getFinishedRounds()));
+    out.append(",\"score\":{\"t\":");
+    appendInt(out, stats.getRoundWins(RoundWinner::TERRORISTS));
+    out.append(",\"ct\":");
+    appendInt(out, stats.getRoundWins(RoundWinner::COUNTER_TERRORISTS));
+    out.push_back('}');
+
+    // Players with their money at the start of each kept round (null when
+    // someone else had the slot), oldest first
+    out.append(",\"players\":[");
+    bool firstPlayer = true;
+    const uint32_t present = stats.getPresentMask();
+    for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+        if (!((present >> slot) & 1u)) {
+            continue;
+        }
+        const PlayerMatchStats& player = stats.getPlayer(slot);
+        out.append(firstPlayer ? "{\"slot\":" : ",{\"slot\":");
+        firstPlayer = false;
+        appendInt(out, static_cast<int64_t>(slot));
+        if (names != nullptr && player.nameId != NameTable::kInvalidId) {
+            out.append(",\"name\":");
+            appendJsonString(out, names->getName(player.nameId).c_str());
+        }
+        out.append(",\"team\":");
+        appendInt(out, player.team);
+        out.append(",\"kills\":");
+        appendInt(out, player.kills);
+        out.append(",\"deaths\":");
+        appendInt(out, player.deaths);
+        out.append(",\"assists\":");
+        appendInt(out, player.assists);
+        out.append(",\"kda\":");
+        appendFloat(out, static_cast<float>(player.kda()));
+        out.append(",\"roundsPlayed\":");
+        appendInt(out, player.roundsPlayed);
+        out.append(",\"roundsSurvived\":");
+        appendInt(out, player.roundsSurvived);
+        out.append(",\"multiKills\":[");
+        for (size_t i = 0; i < 4; ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            appendInt(out, player.multiKillRounds[i]);
+        }
+        out.append("],\"spent\":");
+        appendInt(out, player.moneySpent);
+        out.append(",\"earned\":");
+        appendInt(out, player.moneyEarned);
+        out.append(",\"money\":[");
+        for (size_t i = 0; i < stats.getRoundCount(); ++i) {
+            const RoundRecord& round = stats.getRound(i);
+            if (i > 0) {
+                out.push_back(',');
+            }
+            if (((round.presentMask >> slot) & 1u) && round.nameIds[slot] == player.nameId) {
+                appendInt(out, round.startMoney[slot]);
+            } else {
+                out.append("null");
+            }
+        }
+        out.append("]}");
+    }
+    out.push_back(']');
+
+    out.append(",\"rounds\":[");
+    for (size_t i = 0; i < stats.getRoundCount(); ++i) {
+        const RoundRecord& round = stats.getRound(i);
+        out.append(i > 0 ? ",{\"round\":" : "{\"round\":");
+        appendInt(out, round.roundNumber);
+        out.append(",\"winner\":");
+        out.append(roundWinnerToString(round.winner));
+        out.append(",\"reason\":\"");
+        out.append(roundEndReasonToString(round.reason));
+        out.append("\",\"bombPlanted\":");
+        appendBool(out, round.bombPlanted);
+        out.append(",\"duration\":");
+        appendFloat(out, round.durationSeconds);
+        for (size_t side = 0; side < 2; ++side) {
+            out.append(side == 0 ? ",\"t\":{\"startMoney\":" : ",\"ct\":{\"startMoney\":");
+            appendInt(out, round.teamStartMoney[side]);
+            out.append(",\"spent\":");
+            appendInt(out, round.teamSpent[side]);
+            out.append(",\"buy\":\"");
+            out.append(buyTypeToString(round.teamBuy[side]));
+            out.append("\"}");
+        }
+        out.push_back('}');
+    }
+    out.append("]}\n");
+}
+
+void StateEncoder::encodePlayers(const PlayerTable& players, const NameTable* table, uint32_t fields,
+                                 std::string& out) {
+    out.push_back('[');
+    bool firstPlayer = true;
+    for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+        if (!players.isPresent(slot)) {
+            continue;
+        }
+        if (!firstPlayer) {
+            out.push_back(',');
+        }
+        firstPlayer = false;
+
+        bool firstField = true;
+        auto field = [&out, &firstField](const char* separatedKey) {
+            out.append(firstField ? separatedKey + 1 : separatedKey);
+            firstField = false;
+        };
+
+        out.push_back('{');
+        if (fields & PlayerFields::NAME) {
+            if (table != nullptr && players.nameIds[slot] != NameTable::kInvalidId) {
+                field(",\"nameId\":");
+                appendInt(out, players.nameIds[slot]);
+            } else {
+                field(",\"name\":");
+                appendJsonString(out, players.names[slot]);
+            }
+        }
+        if (fields & PlayerFields::KILLS) {
+            field(",\"kills\":");
+            appendInt(out, players.kills[slot]);
+        }
+        if (fields & PlayerFields::DEATHS) {
+            field(",\"deaths\":");
+            appendInt(out, players.deaths[slot]);
+        }
+        if (fields & PlayerFields::ASSISTS) {
+            field(",\"assists\":");
+            appendInt(out, players.assists[slot]);
+        }
+        if (fields & PlayerFields::MONEY) {
+            field(",\"money\":");
+            appendInt(out, players.money[slot]);
+        }
+        if (fields & PlayerFields::TEAM) {
+            field(",\"team\":");
+            appendInt(out, players.team[slot]);
+        }
+        if (fields & PlayerFields::IS_ALIVE) {
+            field(",\"isAlive\":");
+            appendBool(out, players.alive[slot] != 0);
+        }
+        out.push_back('}');
+    }
+    out.push_back(']');
+}
+
+const char* StateEncoder::gameEventToString(GameEvent event) {
+    switch (event) {
+        case GameEvent::ROUND_START:    return "Round Start";
+        case GameEvent::ROUND_END:      return "Round End";
+        case GameEvent::BOMB_PLANTED:   return "Bomb Planted";
+        case GameEvent::BOMB_DEFUSED:   return "Bomb Defused";
+        case GameEvent::BOMB_EXPLODED:  return "Bomb Exploded";
+        case GameEvent::PLAYER_KILLED:  return "Player Killed";
+        default:                        return "Unknown";
+    }
+}
+
+} // namespace CS16Capture
@@ -0,0 +1,480 @@
+#include "../include/stream_compressor.h"
+#include "../include/logger.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#ifdef CS16_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CS16_HAVE_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+namespace CS16Capture {
+
+namespace {
+
+#ifdef CS16_HAVE_ZLIB
+// What Z_SYNC_FLUSH ends every block with; dropped on the wire and put back to inflate
+const unsigned char kSyncTrailer[4] = {0x00, 0x00, 0xff, 0xff};
+#endif
+
+void writeRecordHeader(uint32_t length, bool compressed, std::string& out) {
+    uint32_t header = length | (compressed ? CompressionWire::kCompressedFlag : 0);
+    for (size_t i = 0; i < CompressionWire::kRecordHeaderSize; ++i) {
+        out[i] = static_cast<char>((header >> (8 * i)) & 0xff);
+    }
+}
+
+uint32_t readRecordHeader(const char* data) {
+    uint32_t header = 0;
+    for (size_t i = 0; i < CompressionWire::kRecordHeaderSize; ++i) {
+        header |= static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    }
+    return header;
+}
+
+} // namespace
+
+const char* compressionCodecToString(CompressionCodec codec) {
+    switch (codec) {
+        case CompressionCodec::NONE:    return "none";
+        case CompressionCodec::DEFLATE: return "deflate";
+        case CompressionCodec::ZSTD:    return "zstd";
+    }
+    return "none";
+}
+
+bool parseCompressionCodec(const std::string& name, CompressionCodec& outCodec) {
+    for (CompressionCodec codec : {CompressionCodec::NONE, CompressionCodec::DEFLATE, CompressionCodec::ZSTD}) {
+        if (name == compressionCodecToString(codec)) {
+            outCodec = codec;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isCompressionCodecAvailable(CompressionCodec codec) {
+    switch (codec) {
+        case CompressionCodec::NONE:
+            return true;
+        case CompressionCodec::DEFLATE:
+#ifdef CS16_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case CompressionCodec::ZSTD:
+#ifdef CS16_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+uint32_t getCompressionDictionaryId(const std::string& dictionary) {
+#ifdef CS16_HAVE_ZSTD
+    return dictionary.empty() ? 0 : ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size());
+#else
+    (void)dictionary;
+    return 0;
+#endif
+}
+
+bool trainCompressionDictionary(const std::string* samples, size_t count, size_t maxSize,
+                                std::string& outDictionary) {
+#ifdef CS16_HAVE_ZSTD
+    std::string joined;
+    std::vector<size_t> sizes;
+    sizes.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        joined.append(samples[i]);
+        sizes.push_back(samples[i].size());
+    }
+
+    outDictionary.resize(maxSize);
+    size_t size = ZDICT_trainFromBuffer(&outDictionary[0], maxSize, joined.data(), sizes.data(),
+                                        static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(size)) {
+        LOG_WARNING(std::string("Failed to train compression dictionary: ") + ZDICT_getErrorName(size));
+        outDictionary.clear();
+        return false;
+    }
+    outDictionary.resize(size);
+    return true;
+#else
+    (void)samples;
+    (void)count;
+    (void)maxSize;
+    outDictionary.clear();
+    return false;
+#endif
+}
+
+StreamCompressor::StreamCompressor()
+    : stream_(nullptr)
+    , plainBytes_(0)
+    , recordBytes_(0)
+    , compressedRecords_(0)
+    , plainRecords_(0)
+{
+}
+
+StreamCompressor::~StreamCompressor() {
+    release();
+}
+
+bool StreamCompressor::reset(const CompressionConfig& config) {
+    release();
+    config_ = config;
+    plainBytes_ = 0;
+    recordBytes_ = 0;
+    compressedRecords_ = 0;
+    plainRecords_ = 0;
+
+    switch (config_.codec) {
+        case CompressionCodec::NONE:
+            return true;
+
+        case CompressionCodec::DEFLATE: {
+#ifdef CS16_HAVE_ZLIB
+            z_stream* stream = new z_stream();
+            int level = config_.level != 0 ? config_.level : 6;
+            // Negative window bits: raw deflate without zlib header or checksum
+            if (deflateInit2(stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                delete stream;
+                LOG_ERROR("Failed to initialize deflate");
+                break;
+            }
+            stream_ = stream;
+            return true;
+#else
+            break;
+#endif
+        }
+
+        case CompressionCodec::ZSTD: {
+#ifdef CS16_HAVE_ZSTD
+            ZSTD_CCtx* context = ZSTD_createCCtx();
+            int level = config_.level != 0 ? config_.level : 3;
+            if (context == nullptr ||
+                ZSTD_isError(ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, level)) ||
+                (!config_.dictionary.empty() &&
+                 ZSTD_isError(ZSTD_CCtx_loadDictionary(context, config_.dictionary.data(),
+                                                       config_.dictionary.size())))) {
+                ZSTD_freeCCtx(context);
+                LOG_ERROR("Failed to initialize zstd");
+                break;
+            }
+            stream_ = context;
+            return true;
+#else
+            break;
+#endif
+        }
+    }
+
+    LOG_WARNING(std::string("Compression codec '") + compressionCodecToString(config_.codec) +
+                "' is not available, sending plain");
+    config_.codec = CompressionCodec::NONE;
+    return false;
+}
+
+bool StreamCompressor::isEnabled() const {
+    return config_.codec != CompressionCodec::NONE;
+}
+
+void StreamCompressor::makeHello(std::string& out) const {
+    out.assign("{\"type\":\"compression\",\"codec\":\"");
+    out.append(compressionCodecToString(config_.codec));
+    out.append("\",\"dictId\":");
+    out.append(std::to_string(config_.codec == CompressionCodec::ZSTD
+                                  ? getCompressionDictionaryId(config_.dictionary) : 0));
+    out.append("}\n");
+}
+
+bool StreamCompressor::compress(const char* data, size_t length, std::string& out) {
+    const size_t header = CompressionWire::kRecordHeaderSize;
+    plainBytes_ += length;
+
+    // Short messages gain little and would still cost a compressor call each;
+    // they also stay out of the history, which the receiver mirrors
+    if (length < config_.threshold || stream_ == nullptr) {
+        out.resize(header);
+        writeRecordHeader(static_cast<uint32_t>(length), false, out);
+        out.append(data, length);
+        recordBytes_ += out.size();
+        ++plainRecords_;
+        return true;
+    }
+
+    size_t written = 0;
+    out.resize(header + length / 2 + 64);
+
+    if (config_.codec == CompressionCodec::DEFLATE) {
+#ifdef CS16_HAVE_ZLIB
+        z_stream* stream = static_cast<z_stream*>(stream_);
+        stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        stream->avail_in = static_cast<uInt>(length);
+        while (true) {
+            stream->next_out = reinterpret_cast<Bytef*>(&out[header + written]);
+            stream->avail_out = static_cast<uInt>(out.size() - header - written);
+            int result = deflate(stream, Z_SYNC_FLUSH);
+            written = out.size() - header - stream->avail_out;
+            if (result != Z_OK && result != Z_BUF_ERROR) {
+                LOG_ERROR("deflate failed");
+                return false;
+            }
+            // The flush is complete once deflate leaves output space unused
+            if (stream->avail_out != 0) {
+                break;
+            }
+            out.resize(out.size() * 2);
+        }
+        if (written >= sizeof(kSyncTrailer)) {
+            written -= sizeof(kSyncTrailer);
+        }
+#endif
+    } else {
+#ifdef CS16_HAVE_ZSTD
+        ZSTD_CCtx* context = static_cast<ZSTD_CCtx*>(stream_);
+        ZSTD_inBuffer input = {data, length, 0};
+        while (true) {
+            ZSTD_outBuffer output = {&out[header], out.size() - header, written};
+            size_t remaining = ZSTD_compressStream2(context, &output, &input, ZSTD_e_flush);
+            written = output.pos;
+            if (ZSTD_isError(remaining)) {
+                LOG_ERROR(std::string("zstd failed: ") + ZSTD_getErrorName(remaining));
+                return false;
+            }
+            if (remaining == 0) {
+                break;
+            }
+            out.resize(out.size() * 2);
+        }
+#endif
+    }
+
+    out.resize(header + written);
+    writeRecordHeader(static_cast<uint32_t>(written), true, out);
+    recordBytes_ += out.size();
+    ++compressedRecords_;
+    return true;
+}
+
+uint64_t StreamCompressor::getPlainBytes() const {
+    return plainBytes_;
+}
+
+uint64_t StreamCompressor::getRecordBytes() const {
+    return recordBytes_;
+}
+
+uint64_t StreamCompressor::getCompressedRecords() const {
+    return compressedRecords_;
+}
+
+uint64_t StreamCompressor::getPlainRecords() const {
+    return plainRecords_;
+}
+
+void StreamCompressor::release() {
+    if (stream_ == nullptr) {
+        return;
+    }
+#ifdef CS16_HAVE_ZLIB
+    if (config_.codec == CompressionCodec::DEFLATE) {
+        z_stream* stream = static_cast<z_stream*>(stream_);
+        deflateEnd(stream);
+        delete stream;
+    }
+#endif
+#ifdef CS16_HAVE_ZSTD
+    if (config_.codec == CompressionCodec::ZSTD) {
+        ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(stream_));
+    }
+#endif
+    stream_ = nullptr;
+}
+
+StreamDecompressor::StreamDecompressor()
+    : codec_(CompressionCodec::NONE)
+    , stream_(nullptr)
+{
+}
+
+StreamDecompressor::~StreamDecompressor() {
+    release();
+}
+
+bool StreamDecompressor::reset(CompressionCodec codec, const std::string& dictionary) {
+    release();
+    pending_.clear();
+    codec_ = codec;
+
+    switch (codec) {
+        case CompressionCodec::NONE:
+            return true;
+
+        case CompressionCodec::DEFLATE: {
+#ifdef CS16_HAVE_ZLIB
+            z_stream* stream = new z_stream();
+            if (inflateInit2(stream, -15) != Z_OK) {
+                delete stream;
+                break;
+            }
+            stream_ = stream;
+            return true;
+#else
+            break;
+#endif
+        }
+
+        case CompressionCodec::ZSTD: {
+#ifdef CS16_HAVE_ZSTD
+            ZSTD_DCtx* context = ZSTD_createDCtx();
+            if (context == nullptr ||
+                (!dictionary.empty() &&
+                 ZSTD_isError(ZSTD_DCtx_loadDictionary(context, dictionary.data(), dictionary.size())))) {
+                ZSTD_freeDCtx(context);
+                break;
+            }
+            stream_ = context;
+            return true;
+#else
+            break;
+#endif
+        }
+    }
+
+    (void)dictionary;
+    codec_ = CompressionCodec::NONE;
+    return false;
+}
+
+bool StreamDecompressor::feed(const char* data, size_t length, std::string& out) {
+    const size_t header = CompressionWire::kRecordHeaderSize;
+
+    // Whole records are decoded in place; only a record split by the read is copied
+    if (!pending_.empty()) {
+        pending_.append(data, length);
+        data = pending_.data();
+        length = pending_.size();
+    }
+
+    size_t offset = 0;
+    while (length - offset >= header) {
+        uint32_t recordHeader = readRecordHeader(data + offset);
+        size_t payload = recordHeader & ~CompressionWire::kCompressedFlag;
+        if (payload > CompressionWire::kMaxRecordSize) {
+            return false;
+        }
+        if (length - offset - header < payload) {
+            break;
+        }
+
+        const char* record = data + offset + header;
+        if ((recordHeader & CompressionWire::kCompressedFlag) == 0) {
+            out.append(record, payload);
+        } else if (!inflateRecord(record, payload, out)) {
+            return false;
+        }
+        offset += header + payload;
+    }
+
+    if (data == pending_.data()) {
+        pending_.erase(0, offset);
+    } else {
+        pending_.assign(data + offset, length - offset);
+    }
+    return true;
+}
+
+bool StreamDecompressor::inflateRecord(const char* data, size_t length, std::string& out) {
+    if (stream_ == nullptr) {
+        return false;
+    }
+
+    // Frames compress 5-50x against the history; grow from there when needed
+    size_t start = out.size();
+    size_t written = 0;
+    size_t capacity = std::max<size_t>(length * 16, 4096);
+    out.resize(start + capacity);
+
+    if (codec_ == CompressionCodec::DEFLATE) {
+#ifdef CS16_HAVE_ZLIB
+        z_stream* stream = static_cast<z_stream*>(stream_);
+        // The payload, then the sync trailer the sender left off
+        for (int part = 0; part < 2; ++part) {
+            stream->next_in = part == 0 ? reinterpret_cast<Bytef*>(const_cast<char*>(data))
+                                        : const_cast<Bytef*>(kSyncTrailer);
+            stream->avail_in = part == 0 ? static_cast<uInt>(length) : static_cast<uInt>(sizeof(kSyncTrailer));
+            while (stream->avail_in > 0) {
+                stream->next_out = reinterpret_cast<Bytef*>(&out[start + written]);
+                stream->avail_out = static_cast<uInt>(out.size() - start - written);
+                int result = inflate(stream, Z_SYNC_FLUSH);
+                written = out.size() - start - stream->avail_out;
+                if (result != Z_OK && result != Z_BUF_ERROR) {
+                    out.resize(start);
+                    return false;
+                }
+                if (stream->avail_out == 0) {
+                    capacity *= 2;
+                    out.resize(start + capacity);
+                } else if (result == Z_BUF_ERROR) {
+                    break;
+                }
+            }
+        }
+#endif
+    } else if (codec_ == CompressionCodec::ZSTD) {
+#ifdef CS16_HAVE_ZSTD
+        ZSTD_DCtx* context = static_cast<ZSTD_DCtx*>(stream_);
+        ZSTD_inBuffer input = {data, length, 0};
+        while (true) {
+            ZSTD_outBuffer output = {&out[start], out.size() - start, written};
+            size_t result = ZSTD_decompressStream(context, &output, &input);
+            written = output.pos;
+            if (ZSTD_isError(result)) {
+                out.resize(start);
+                return false;
+            }
+            // A flushed block is complete once the input is used up with output space to spare
+            if (input.pos == input.size && output.pos < output.size) {
+                break;
+            }
+            capacity *= 2;
+            out.resize(start + capacity);
+        }
+#endif
+    }
+
+    out.resize(start + written);
+    return true;
+}
+
+void StreamDecompressor::release() {
+    if (stream_ == nullptr) {
+        return;
+    }
+#ifdef CS16_HAVE_ZLIB
+    if (codec_ == CompressionCodec::DEFLATE) {
+        z_stream* stream = static_cast<z_stream*>(stream_);
+        inflateEnd(stream);
+        delete stream;
+    }
+#endif
+#ifdef CS16_HAVE_ZSTD
+    if (codec_ == CompressionCodec::ZSTD) {
+        ZSTD_freeDCtx(static_cast<ZSTD_DCtx*>(stream_));
+    }
+#endif
+    stream_ = nullptr;
+}
+
+} // namespace CS16Capture
@@ -0,0 +1,145 @@
+#include "../include/subscription.h"
+#include <algorithm>
+#include <cmath>
+
+namespace CS16Capture {
+
+namespace {
+
+// Lowest "maxRate" honored (once an hour); a smaller rate from the server
+// would overflow the interval, so it is raised to this
+const double kMinMaxRate = 1.0 / 3600.0;
+
+struct FieldName {
+    const char* name;
+    uint32_t bit;
+};
+
+const FieldName kPlayerFieldNames[] = {
+    { "name", PlayerFields::NAME },
+    { "nameId", PlayerFields::NAME },
+    { "kills", PlayerFields::KILLS },
+    { "deaths", PlayerFields::DEATHS },
+    { "assists", PlayerFields::ASSISTS },
+    { "money", PlayerFields::MONEY },
+    { "team", PlayerFields::TEAM },
+    { "isAlive", PlayerFields::IS_ALIVE },
+};
+
+const FieldName kBombFieldNames[] = {
+    { "planted", BombFields::PLANTED },
+    { "timeRemaining", BombFields::TIME_REMAINING },
+    { "defused", BombFields::DEFUSED },
+};
+
+const FieldName kRoundFieldNames[] = {
+    { "roundNumber", RoundFields::NUMBER },
+    { "roundTime", RoundFields::TIME },
+};
+
+struct TopicName {
+    const char* name;
+    Topic topic;
+    const FieldName* fields;
+    size_t fieldCount;
+};
+
+const TopicName kTopicNames[] = {
+    { "players", Topic::PLAYERS, kPlayerFieldNames, sizeof(kPlayerFieldNames) / sizeof(kPlayerFieldNames[0]) },
+    { "bomb", Topic::BOMB, kBombFieldNames, sizeof(kBombFieldNames) / sizeof(kBombFieldNames[0]) },
+    { "events", Topic::EVENTS, nullptr, 0 },
+    { "round", Topic::ROUND, kRoundFieldNames, sizeof(kRoundFieldNames) / sizeof(kRoundFieldNames[0]) },
+    { "stats", Topic::STATS, nullptr, 0 },
+};
+
+bool parseTopic(const TopicName& topic, const JsonValue& value, TopicSubscription& out, std::string& error) {
+    if (!value.isObject()) {
+        error = std::string("topic ") + topic.name + " must be an object";
+        return false;
+    }
+
+    out.enabled = true;
+    out.fields = ~0u;
+    out.minIntervalNs = 0;
+
+    const JsonValue* fields = value.find("fields");
+    if (fields != nullptr) {
+        if (!fields->isArray()) {
+            error = std::string("fields of ") + topic.name + " must be an array";
+            return false;
+        }
+
+        out.fields = 0;
+        for (const auto& field : fields->array) {
+            bool known = false;
+            for (size_t i = 0; i < topic.fieldCount && field.isString(); ++i) {
+                if (field.string == topic.fields[i].name) {
+                    out.fields |= topic.fields[i].bit;
+                    known = true;
+                }
+            }
+            if (!known) {
+                error = std::string("unknown field of ") + topic.name +
+                        (field.isString() ? ": " + field.string : std::string());
+                return false;
+            }
+        }
+    }
+
+    const JsonValue* maxRate = value.find("maxRate");
+    if (maxRate != nullptr) {
+        if (!maxRate->isNumber() || !std::isfinite(maxRate->number) || maxRate->number < 0.0) {
+            error = std::string("maxRate of ") + topic.name + " must be a finite non-negative number";
+            return false;
+        }
+        if (maxRate->number > 0.0) {
+            out.minIntervalNs = static_cast<uint64_t>(1e9 / std::max(maxRate->number, kMinMaxRate));
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseSubscription(const JsonValue& message, Subscription& outSubscription, std::string& error) {
+    if (message.getString("type") != "subscribe") {
+        error = "not a subscribe message";
+        return false;
+    }
+
+    const JsonValue* topics = message.find("topics");
+    if (topics == nullptr) {
+        outSubscription = Subscription();
+        return true;
+    }
+    if (!topics->isObject()) {
+        error = "topics must be an object";
+        return false;
+    }
+
+    Subscription subscription;
+    for (auto& topic : subscription.topics) {
+        topic.enabled = false;
+    }
+
+    for (const auto& member : topics->object) {
+        const TopicName* topic = nullptr;
+        for (const auto& candidate : kTopicNames) {
+            if (member.key == candidate.name) {
+                topic = &candidate;
+            }
+        }
+        if (topic == nullptr) {
+            error = "unknown topic: " + member.key;
+            return false;
+        }
+        if (!parseTopic(*topic, member.value, subscription.get(topic->topic), error)) {
+            return false;
+        }
+    }
+
+    outSubscription = subscription;
+    return true;
+}
+
+} // namespace CS16Capture
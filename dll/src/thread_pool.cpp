@@ -0,0 +1,136 @@
+#include "../include/thread_pool.h"
+#include "../include/logger.h"
+#include <algorithm>
+
+namespace CS16Capture {
+
+namespace {
+
+// Identifies the pool and deque of the calling worker thread
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : nextQueue_(0)
+    , pendingTasks_(0)
+    , stealCount_(0)
+    , stopping_(false)
+{
+    if (threadCount == 0) {
+        threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 0; i < threadCount; ++i) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+
+    LOG_INFO("Thread pool started with " + std::to_string(threadCount) + " workers");
+}
+
+ThreadPool::~ThreadPool() {
+    shutdown();
+}
+
+void ThreadPool::submit(Task task) {
+    if (stopping_) {
+        return;
+    }
+
+    size_t index = (currentPool == this)
+        ? currentWorker
+        : nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+
+    pendingTasks_.fetch_add(1);
+    {
+        // Pairs with the predicate check in workerLoop so a wakeup is never lost
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+    }
+    wakeCondition_.notify_one();
+}
+
+void ThreadPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    wakeCondition_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+size_t ThreadPool::getThreadCount() const {
+    return workers_.size();
+}
+
+uint64_t ThreadPool::getStealCount() const {
+    return stealCount_;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            pendingTasks_.fetch_sub(1);
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wakeCondition_.wait(lock, [this] { return stopping_ || pendingTasks_ > 0; });
+        if (stopping_ && pendingTasks_ == 0) {
+            break;
+        }
+    }
+}
+
+bool ThreadPool::popLocal(size_t index, Task& task) {
+    WorkQueue& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t index, Task& task) {
+    for (size_t offset = 1; offset < queues_.size(); ++offset) {
+        WorkQueue& victim = *queues_[(index + offset) % queues_.size()];
+
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) {
+            continue;
+        }
+
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        stealCount_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace CS16Capture
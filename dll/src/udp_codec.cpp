@@ -0,0 +1,597 @@
+#include "../include/udp_codec.h"
+#include <cstring>
+
+namespace CS16Capture {
+
+namespace {
+
+// Per-slot field bits of the player section
+enum PlayerField : uint8_t {
+    FIELD_KILLS = 1u << 0,
+    FIELD_DEATHS = 1u << 1,
+    FIELD_ASSISTS = 1u << 2,
+    FIELD_MONEY = 1u << 3,
+    FIELD_TEAM = 1u << 4,
+    FIELD_ALIVE = 1u << 5,
+    FIELD_NAME = 1u << 6,
+    FIELD_ALL = (1u << 7) - 1
+};
+
+const uint8_t kBombPlanted = 1u << 0;
+const uint8_t kBombDefused = 1u << 1;
+
+class ByteWriter {
+public:
+    ByteWriter(uint8_t* data, size_t capacity)
+        : data_(data), size_(0), capacity_(capacity), overflow_(false) {}
+
+    void u8(uint8_t value) {
+        if (size_ + 1 > capacity_) {
+            overflow_ = true;
+            return;
+        }
+        data_[size_++] = value;
+    }
+
+    void u16(uint16_t value) {
+        u8(static_cast<uint8_t>(value));
+        u8(static_cast<uint8_t>(value >> 8));
+    }
+
+    void u32(uint32_t value) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            u8(static_cast<uint8_t>(value >> shift));
+        }
+    }
+
+    void u64(uint64_t value) {
+        u32(static_cast<uint32_t>(value));
+        u32(static_cast<uint32_t>(value >> 32));
+    }
+
+    void f32(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        u32(bits);
+    }
+
+    void varint(uint32_t value) {
+        while (value >= 0x80) {
+            u8(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        u8(static_cast<uint8_t>(value));
+    }
+
+    // Zigzag so small negative values stay one byte
+    void svarint(int32_t value) {
+        varint((static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31));
+    }
+
+    void bytes(const void* source, size_t length) {
+        if (size_ + length > capacity_) {
+            overflow_ = true;
+            return;
+        }
+        std::memcpy(data_ + size_, source, length);
+        size_ += length;
+    }
+
+    size_t size() const { return size_; }
+    bool overflow() const { return overflow_; }
+
+private:
+    uint8_t* data_;
+    size_t size_;
+    size_t capacity_;
+    bool overflow_;
+};
+
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size)
+        : data_(data), size_(size), position_(0), error_(false) {}
+
+    uint8_t u8() {
+        if (position_ >= size_) {
+            error_ = true;
+            return 0;
+        }
+        return data_[position_++];
+    }
+
+    uint16_t u16() {
+        uint16_t low = u8();
+        return static_cast<uint16_t>(low | (u8() << 8));
+    }
+
+    uint32_t u32() {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            value |= static_cast<uint32_t>(u8()) << shift;
+        }
+        return value;
+    }
+
+    uint64_t u64() {
+        uint64_t low = u32();
+        return low | (static_cast<uint64_t>(u32()) << 32);
+    }
+
+    float f32() {
+        uint32_t bits = u32();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    uint32_t varint() {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t byte = u8();
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        error_ = true;
+        return 0;
+    }
+
+    int32_t svarint() {
+        uint32_t value = varint();
+        return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    const uint8_t* bytes(size_t length) {
+        if (position_ + length > size_) {
+            error_ = true;
+            return nullptr;
+        }
+        const uint8_t* result = data_ + position_;
+        position_ += length;
+        return result;
+    }
+
+    bool error() const { return error_; }
+    bool atEnd() const { return position_ == size_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t position_;
+    bool error_;
+};
+
+void writeHeader(ByteWriter& writer, const UdpWire::Header& header) {
+    writer.u16(UdpWire::kMagic);
+    writer.u8(UdpWire::kVersion);
+    writer.u8(header.type);
+    writer.u8(header.flags);
+    writer.u32(header.instanceId);
+    writer.u32(header.sequence);
+    writer.u32(header.baseSequence);
+    writer.u64(header.captureTimeUs);
+}
+
+bool namesEqual(const PlayerTable& a, const PlayerTable& b, size_t slot) {
+    return std::strncmp(a.names[slot], b.names[slot], PlayerTable::kNameLength) == 0;
+}
+
+/**
+ * Players as a delta against base: full presence mask, then the fields that
+ * changed for each changed slot. A keyframe is a delta against an empty
+ * table with every field of every present slot forced.
+ */
+void writePlayers(ByteWriter& writer, const PlayerTable& players, const PlayerTable& base,
+                  bool forceAll, bool withNames) {
+    const uint32_t present = players.presentMask;
+    uint32_t kills = changedSlots(players.kills, base.kills);
+    uint32_t deaths = changedSlots(players.deaths, base.deaths);
+    uint32_t assists = changedSlots(players.assists, base.assists);
+    uint32_t money = changedSlots(players.money, base.money);
+    uint32_t team = changedSlots(players.team, base.team);
+    uint32_t alive = changedSlots(players.alive, base.alive);
+    uint32_t names = 0;
+    if (withNames) {
+        for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+            if (players.isPresent(slot) && (forceAll || !namesEqual(players, base, slot))) {
+                names |= 1u << slot;
+            }
+        }
+    }
+
+    uint32_t changed = forceAll ? present : (kills | deaths | assists | money | team | alive | names) & present;
+    writer.u32(present);
+    writer.u32(changed);
+
+    for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+        if (((changed >> slot) & 1u) == 0) {
+            continue;
+        }
+        const uint32_t bit = 1u << slot;
+        uint8_t fields = forceAll ? static_cast<uint8_t>(FIELD_ALL & ~(withNames ? 0 : FIELD_NAME)) :
+            static_cast<uint8_t>(((kills & bit) ? FIELD_KILLS : 0) | ((deaths & bit) ? FIELD_DEATHS : 0) |
+                                 ((assists & bit) ? FIELD_ASSISTS : 0) | ((money & bit) ? FIELD_MONEY : 0) |
+                                 ((team & bit) ? FIELD_TEAM : 0) | ((alive & bit) ? FIELD_ALIVE : 0) |
+                                 ((names & bit) ? FIELD_NAME : 0));
+        writer.u8(static_cast<uint8_t>(slot));
+        writer.u8(fields);
+        if (fields & FIELD_KILLS) writer.svarint(players.kills[slot]);
+        if (fields & FIELD_DEATHS) writer.svarint(players.deaths[slot]);
+        if (fields & FIELD_ASSISTS) writer.svarint(players.assists[slot]);
+        if (fields & FIELD_MONEY) writer.svarint(players.money[slot]);
+        if (fields & FIELD_TEAM) writer.svarint(players.team[slot]);
+        if (fields & FIELD_ALIVE) writer.u8(players.alive[slot]);
+        if (fields & FIELD_NAME) {
+            size_t length = strnlen(players.names[slot], PlayerTable::kNameLength - 1);
+            writer.u8(static_cast<uint8_t>(length));
+            writer.bytes(players.names[slot], length);
+        }
+    }
+}
+
+bool readPlayers(ByteReader& reader, PlayerTable& players) {
+    uint32_t present = reader.u32();
+    uint32_t changed = reader.u32();
+    if (reader.error() || (changed & ~present) != 0) {
+        return false;
+    }
+
+    for (size_t slot = 0; slot < PlayerTable::kMaxPlayers; ++slot) {
+        if (!((present >> slot) & 1u)) {
+            players.setAbsent(slot);
+        }
+    }
+    players.presentMask = present;
+
+    for (uint32_t remaining = changed; remaining != 0; remaining &= remaining - 1) {
+        size_t slot = reader.u8();
+        uint8_t fields = reader.u8();
+        if (reader.error() || slot >= PlayerTable::kMaxPlayers || !((remaining >> slot) & 1u) ||
+            (remaining & ((1u << slot) - 1)) != 0) {
+            return false;  // Slots must come in ascending order, each once
+        }
+        if (fields & FIELD_KILLS) players.kills[slot] = reader.svarint();
+        if (fields & FIELD_DEATHS) players.deaths[slot] = reader.svarint();
+        if (fields & FIELD_ASSISTS) players.assists[slot] = reader.svarint();
+        if (fields & FIELD_MONEY) players.money[slot] = reader.svarint();
+        if (fields & FIELD_TEAM) players.team[slot] = reader.svarint();
+        if (fields & FIELD_ALIVE) players.alive[slot] = reader.u8();
+        if (fields & FIELD_NAME) {
+            size_t length = reader.u8();
+            const uint8_t* name = reader.bytes(length);
+            if (name == nullptr || length >= PlayerTable::kNameLength) {
+                return false;
+            }
+            std::memcpy(players.names[slot], name, length);
+            players.names[slot][length] = '\0';
+        }
+    }
+    return !reader.error();
+}
+
+} // namespace
+
+namespace UdpWire {
+
+bool readHeader(const uint8_t* data, size_t size, Header& outHeader) {
+    ByteReader reader(data, size);
+    if (reader.u16() != kMagic || reader.u8() != kVersion) {
+        return false;
+    }
+    outHeader.type = reader.u8();
+    outHeader.flags = reader.u8();
+    outHeader.instanceId = reader.u32();
+    outHeader.sequence = reader.u32();
+    outHeader.baseSequence = reader.u32();
+    outHeader.captureTimeUs = reader.u64();
+    return !reader.error();
+}
+
+size_t writeAck(uint32_t instanceId, uint32_t keyframeSequence, uint32_t highestSequence, uint8_t* out) {
+    ByteWriter writer(out, kMaxDatagramSize);
+    Header header = {ACK, 0, instanceId, highestSequence, keyframeSequence, 0};
+    writeHeader(writer, header);
+    return writer.size();
+}
+
+bool readAck(const uint8_t* data, size_t size, uint32_t& instanceId, uint32_t& keyframeSequence,
+             uint32_t& highestSequence) {
+    Header header;
+    if (!readHeader(data, size, header) || header.type != ACK) {
+        return false;
+    }
+    instanceId = header.instanceId;
+    keyframeSequence = header.baseSequence;
+    highestSequence = header.sequence;
+    return true;
+}
+
+size_t writeKeyframeRequest(uint32_t instanceId, uint32_t missingBase, uint8_t* out) {
+    ByteWriter writer(out, kMaxDatagramSize);
+    Header header = {KEYFRAME_REQUEST, 0, instanceId, 0, missingBase, 0};
+    writeHeader(writer, header);
+    return writer.size();
+}
+
+bool readKeyframeRequest(const uint8_t* data, size_t size, uint32_t& instanceId, uint32_t& missingBase) {
+    Header header;
+    if (!readHeader(data, size, header) || header.type != KEYFRAME_REQUEST) {
+        return false;
+    }
+    instanceId = header.instanceId;
+    missingBase = header.baseSequence;
+    return true;
+}
+
+} // namespace UdpWire
+
+UdpSnapshotEncoder::UdpSnapshotEncoder(uint32_t instanceId)
+    : instanceId_(instanceId)
+    , sequence_(0)
+    , lastKeyframeKept_(0)
+    , ackedKeyframe_(0)
+    , nextKeyframe_(0)
+    , recentEvents_()
+    , eventCount_(0)
+{
+    for (Keyframe& keyframe : keyframes_) {
+        keyframe.sequence = 0;
+    }
+}
+
+size_t UdpSnapshotEncoder::encode(const GameState& state, uint8_t* out) {
+    ++sequence_;
+
+    for (GameEvent event : state.events) {
+        recentEvents_[eventCount_ % kMaxRecentEvents] = {event, sequence_};
+        ++eventCount_;
+    }
+
+    const Keyframe* base = findKeyframe(ackedKeyframe_);
+    bool keep = lastKeyframeKept_ == 0 || sequence_ - lastKeyframeKept_ >= kKeyframeInterval;
+    bool keyframe = base == nullptr || keep;
+
+    UdpWire::Header header;
+    header.type = keyframe ? UdpWire::KEYFRAME : UdpWire::DELTA;
+    header.flags = 0;
+    header.instanceId = instanceId_;
+    header.sequence = sequence_;
+    header.baseSequence = keyframe ? 0 : base->sequence;
+    header.captureTimeUs = state.captureTimeNs / 1000;
+
+    // Events still inside the repeat window are contiguous at the end
+    uint32_t firstEvent = eventCount_;
+    while (firstEvent > 0 && eventCount_ - (firstEvent - 1) <= kMaxRecentEvents &&
+           sequence_ - recentEvents_[(firstEvent - 1) % kMaxRecentEvents].frameSequence < kEventRepeatFrames) {
+        --firstEvent;
+    }
+
+    static const PlayerTable kEmptyTable;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        bool withNames = attempt == 0;
+        header.flags = static_cast<uint8_t>((withNames ? 0 : UdpWire::NAMES_OMITTED) |
+                                            (keyframe && !keep ? UdpWire::REFRESH : 0));
+
+        ByteWriter writer(out, UdpWire::kMaxDatagramSize);
+        writeHeader(writer, header);
+        writer.svarint(state.roundNumber);
+        writer.f32(state.roundTime);
+        writer.u8(static_cast<uint8_t>((state.bomb.planted ? kBombPlanted : 0) |
+                                       (state.bomb.defused ? kBombDefused : 0)));
+        writer.f32(state.bomb.timeRemaining);
+        writer.varint(firstEvent);
+        writer.u8(static_cast<uint8_t>(eventCount_ - firstEvent));
+        for (uint32_t i = firstEvent; i < eventCount_; ++i) {
+            writer.u8(static_cast<uint8_t>(recentEvents_[i % kMaxRecentEvents].event));
+        }
+        writePlayers(writer, state.players, keyframe ? kEmptyTable : base->players, keyframe, withNames);
+
+        if (!writer.overflow()) {
+            if (keep) {
+                // The base in use stays until an ack moves past it
+                if (keyframes_[nextKeyframe_].sequence == ackedKeyframe_ && ackedKeyframe_ != 0) {
+                    nextKeyframe_ = (nextKeyframe_ + 1) % kKeyframeHistory;
+                }
+                Keyframe& slot = keyframes_[nextKeyframe_];
+                nextKeyframe_ = (nextKeyframe_ + 1) % kKeyframeHistory;
+                slot.sequence = sequence_;
+                slot.players = state.players;
+                if (!withNames) {
+                    // The receiver keeps its previous names; never delta names against them
+                    for (size_t i = 0; i < PlayerTable::kMaxPlayers; ++i) {
+                        slot.players.names[i][0] = '\0';
+                    }
+                }
+                lastKeyframeKept_ = sequence_;
+            }
+            return writer.size();
+        }
+    }
+
+    // Unreachable: header, round, events and nameless players stay below the MTU
+    return 0;
+}
+
+void UdpSnapshotEncoder::onAck(uint32_t keyframeSequence) {
+    // Acks may arrive reordered; never move back to an older base
+    if (keyframeSequence > ackedKeyframe_ && findKeyframe(keyframeSequence) != nullptr) {
+        ackedKeyframe_ = keyframeSequence;
+    }
+}
+
+void UdpSnapshotEncoder::onKeyframeRequest(uint32_t missingBase) {
+    if (missingBase != 0 && missingBase == ackedKeyframe_) {
+        reset();
+    }
+}
+
+void UdpSnapshotEncoder::reset() {
+    ackedKeyframe_ = 0;
+    lastKeyframeKept_ = 0;
+}
+
+uint32_t UdpSnapshotEncoder::getSequence() const {
+    return sequence_;
+}
+
+uint32_t UdpSnapshotEncoder::getAckedKeyframe() const {
+    return ackedKeyframe_;
+}
+
+const UdpSnapshotEncoder::Keyframe* UdpSnapshotEncoder::findKeyframe(uint32_t sequence) const {
+    if (sequence == 0) {
+        return nullptr;
+    }
+    for (const Keyframe& keyframe : keyframes_) {
+        if (keyframe.sequence == sequence) {
+            return &keyframe;
+        }
+    }
+    return nullptr;
+}
+
+UdpSnapshotDecoder::UdpSnapshotDecoder()
+    : sequence_(0)
+    , newestKeyframe_(0)
+    , nextKeyframe_(0)
+    , eventsSynced_(false)
+    , nextEvent_(0)
+    , lost_(0)
+    , missedEvents_(0)
+{
+    for (Keyframe& keyframe : keyframes_) {
+        keyframe.sequence = 0;
+    }
+}
+
+UdpDecodeResult UdpSnapshotDecoder::decode(const uint8_t* data, size_t size, const UdpWire::Header& header) {
+    if (header.type != UdpWire::KEYFRAME && header.type != UdpWire::DELTA) {
+        return UdpDecodeResult::MALFORMED;
+    }
+    // A keyframe far behind means the sender restarted and counts from 1 again
+    if (header.type == UdpWire::KEYFRAME && header.sequence + kRestartWindow < sequence_) {
+        sequence_ = 0;
+        newestKeyframe_ = 0;
+        eventsSynced_ = false;
+        for (Keyframe& keyframe : keyframes_) {
+            keyframe.sequence = 0;
+        }
+    }
+
+    // Freshness over completeness: a reordered older frame is of no use
+    if (header.sequence <= sequence_) {
+        return UdpDecodeResult::STALE;
+    }
+
+    const Keyframe* base = nullptr;
+    if (header.type == UdpWire::DELTA) {
+        base = findKeyframe(header.baseSequence);
+        if (base == nullptr) {
+            return UdpDecodeResult::MISSING_BASE;
+        }
+    }
+
+    ByteReader reader(data, size);
+    reader.bytes(UdpWire::kHeaderSize);
+    int32_t roundNumber = reader.svarint();
+    float roundTime = reader.f32();
+    uint8_t bombFlags = reader.u8();
+    float bombTime = reader.f32();
+    uint32_t firstEvent = reader.varint();
+    uint8_t eventCount = reader.u8();
+    const uint8_t* events = reader.bytes(eventCount);
+    if (reader.error()) {
+        return UdpDecodeResult::MALFORMED;
+    }
+
+    // Decode into a scratch table so a malformed datagram leaves the state alone
+    PlayerTable players = base != nullptr ? base->players : PlayerTable();
+    if ((header.flags & UdpWire::NAMES_OMITTED) != 0) {
+        std::memcpy(players.names, state_.players.names, sizeof(players.names));
+    }
+    if (!readPlayers(reader, players) || !reader.atEnd()) {
+        return UdpDecodeResult::MALFORMED;
+    }
+
+    if (sequence_ != 0 && header.sequence > sequence_ + 1) {
+        lost_ += header.sequence - sequence_ - 1;
+    }
+    sequence_ = header.sequence;
+
+    state_.players = players;
+    state_.roundNumber = roundNumber;
+    state_.roundTime = roundTime;
+    state_.bomb.planted = (bombFlags & kBombPlanted) != 0;
+    state_.bomb.defused = (bombFlags & kBombDefused) != 0;
+    state_.bomb.timeRemaining = bombTime;
+    state_.captureTimeNs = header.captureTimeUs * 1000;
+
+    state_.events.clear();
+    if (!eventsSynced_) {
+        // Events from before we started listening are not reported
+        nextEvent_ = firstEvent + eventCount;
+        eventsSynced_ = true;
+    } else {
+        if (firstEvent > nextEvent_) {
+            missedEvents_ += firstEvent - nextEvent_;
+            nextEvent_ = firstEvent;
+        }
+        for (uint32_t i = nextEvent_ - firstEvent; i < eventCount; ++i) {
+            state_.events.push_back(static_cast<GameEvent>(events[i]));
+        }
+        if (firstEvent + eventCount > nextEvent_) {
+            nextEvent_ = firstEvent + eventCount;
+        }
+    }
+
+    if (header.type == UdpWire::KEYFRAME && (header.flags & UdpWire::REFRESH) == 0) {
+        Keyframe& slot = keyframes_[nextKeyframe_];
+        nextKeyframe_ = (nextKeyframe_ + 1) % kKeyframeHistory;
+        slot.sequence = header.sequence;
+        slot.players = players;
+        if ((header.flags & UdpWire::NAMES_OMITTED) != 0) {
+            // Mirror the sender, which deltas names of this keyframe against empty ones
+            for (size_t i = 0; i < PlayerTable::kMaxPlayers; ++i) {
+                slot.players.names[i][0] = '\0';
+            }
+        }
+        newestKeyframe_ = header.sequence;
+    }
+    return UdpDecodeResult::UPDATED;
+}
+
+const GameState& UdpSnapshotDecoder::getState() const {
+    return state_;
+}
+
+uint32_t UdpSnapshotDecoder::getSequence() const {
+    return sequence_;
+}
+
+uint32_t UdpSnapshotDecoder::getNewestKeyframe() const {
+    return newestKeyframe_;
+}
+
+uint64_t UdpSnapshotDecoder::getLostCount() const {
+    return lost_;
+}
+
+uint64_t UdpSnapshotDecoder::getMissedEventCount() const {
+    return missedEvents_;
+}
+
+const UdpSnapshotDecoder::Keyframe* UdpSnapshotDecoder::findKeyframe(uint32_t sequence) const {
+    if (sequence == 0) {
+        return nullptr;
+    }
+    for (const Keyframe& keyframe : keyframes_) {
+        if (keyframe.sequence == sequence) {
+            return &keyframe;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace CS16Capture
@@ -0,0 +1,484 @@
+#include "../include/udp_transport.h"
+#include "../include/logger.h"
+#include <algorithm>
+#include <chrono>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace CS16Capture {
+
+namespace {
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+const SocketHandle kNoSocket = INVALID_SOCKET;
+
+SocketHandle toHandle(void* socket) {
+    return socket == nullptr ? INVALID_SOCKET : reinterpret_cast<SOCKET>(socket);
+}
+
+void* fromHandle(SocketHandle handle) {
+    return handle == INVALID_SOCKET ? nullptr : reinterpret_cast<void*>(handle);
+}
+
+void closeHandle(SocketHandle handle) {
+    closesocket(handle);
+}
+#else
+using SocketHandle = int;
+const SocketHandle kNoSocket = -1;
+
+SocketHandle toHandle(int socket) {
+    return socket;
+}
+
+int fromHandle(SocketHandle handle) {
+    return handle;
+}
+
+void closeHandle(SocketHandle handle) {
+    ::close(handle);
+}
+#endif
+
+} // namespace
+
+UdpClient::UdpClient()
+    : batch_(kMaxBatch * UdpWire::kMaxDatagramSize)
+    , batchLengths_()
+    , batchCount_(0)
+    , batchSize_(1)
+    , stats_()
+    , socket_(fromHandle(kNoSocket))
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        LOG_ERROR("WSAStartup failed");
+    }
+#endif
+}
+
+UdpClient::~UdpClient() {
+    close();
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool UdpClient::open(const std::string& host, int port) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (toHandle(socket_) != kNoSocket) {
+        return true;
+    }
+
+    SocketHandle sock = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock == kNoSocket) {
+        LOG_ERROR("Failed to create UDP socket");
+        return false;
+    }
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        LOG_ERROR("Invalid UDP receiver address " + host);
+        closeHandle(sock);
+        return false;
+    }
+
+    // A connected datagram socket needs no address per send and only sees the receiver's acks
+    if (::connect(sock, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        LOG_ERROR("Failed to set UDP receiver " + host + ":" + std::to_string(port));
+        closeHandle(sock);
+        return false;
+    }
+
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(sock, FIONBIO, &nonBlocking);
+#endif
+
+    socket_ = fromHandle(sock);
+    encoders_.clear();
+    LOG_INFO("Sending UDP frames to " + host + ":" + std::to_string(port));
+    return true;
+}
+
+void UdpClient::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SocketHandle sock = toHandle(socket_);
+    if (sock == kNoSocket) {
+        return;
+    }
+
+    flushLocked();
+    closeHandle(sock);
+    socket_ = fromHandle(kNoSocket);
+}
+
+bool UdpClient::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return toHandle(socket_) != kNoSocket;
+}
+
+void UdpClient::setBatchSize(size_t batchSize) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batchSize_ = std::max<size_t>(1, std::min(batchSize, kMaxBatch));
+    if (batchCount_ >= batchSize_) {
+        flushLocked();
+    }
+}
+
+bool UdpClient::send(const GameState& state, uint32_t instanceId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (toHandle(socket_) == kNoSocket) {
+        return false;
+    }
+
+    drainAcks();
+
+    std::unique_ptr<UdpSnapshotEncoder>& encoder = encoders_[instanceId];
+    if (!encoder) {
+        encoder = std::make_unique<UdpSnapshotEncoder>(instanceId);
+    }
+
+    uint8_t* datagram = batch_.data() + batchCount_ * UdpWire::kMaxDatagramSize;
+    size_t length = encoder->encode(state, datagram);
+    if (length == 0) {
+        return false;
+    }
+    UdpWire::Header header;
+    if (UdpWire::readHeader(datagram, length, header) && header.type == UdpWire::KEYFRAME) {
+        ++stats_.keyframes;
+    }
+    batchLengths_[batchCount_++] = length;
+
+    if (batchCount_ >= batchSize_) {
+        return flushLocked();
+    }
+    return true;
+}
+
+bool UdpClient::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return flushLocked();
+}
+
+bool UdpClient::flushLocked() {
+    if (batchCount_ == 0 || toHandle(socket_) == kNoSocket) {
+        return true;
+    }
+
+    SocketHandle sock = toHandle(socket_);
+    size_t sent = 0;
+    bool ok = true;
+
+#ifdef _WIN32
+    for (; sent < batchCount_; ++sent) {
+        const char* data = reinterpret_cast<const char*>(batch_.data() + sent * UdpWire::kMaxDatagramSize);
+        ++stats_.sendCalls;
+        if (::send(sock, data, static_cast<int>(batchLengths_[sent]), 0) == SOCKET_ERROR) {
+            ok = false;
+            break;
+        }
+        stats_.bytes += batchLengths_[sent];
+    }
+#else
+    iovec vectors[kMaxBatch];
+    mmsghdr messages[kMaxBatch] = {};
+    for (size_t i = 0; i < batchCount_; ++i) {
+        vectors[i].iov_base = batch_.data() + i * UdpWire::kMaxDatagramSize;
+        vectors[i].iov_len = batchLengths_[i];
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while (sent < batchCount_) {
+        ++stats_.sendCalls;
+        int result = sendmmsg(sock, messages + sent, static_cast<unsigned int>(batchCount_ - sent), 0);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // ECONNREFUSED reports an earlier datagram that found no receiver; keep going
+            if (errno == ECONNREFUSED) {
+                continue;
+            }
+            ok = false;
+            break;
+        }
+        for (int i = 0; i < result; ++i) {
+            stats_.bytes += batchLengths_[sent + static_cast<size_t>(i)];
+        }
+        sent += static_cast<size_t>(result);
+    }
+#endif
+
+    // Freshness over completeness: what could not be sent now is dropped
+    stats_.datagrams += sent;
+    if (!ok) {
+        ++stats_.sendErrors;
+    }
+    batchCount_ = 0;
+    return ok;
+}
+
+void UdpClient::drainAcks() {
+    uint8_t buffer[UdpWire::kMaxDatagramSize];
+    SocketHandle sock = toHandle(socket_);
+
+    for (;;) {
+#ifdef _WIN32
+        int received = recv(sock, reinterpret_cast<char*>(buffer), sizeof(buffer), 0);
+#else
+        ssize_t received = recv(sock, buffer, sizeof(buffer), MSG_DONTWAIT);
+#endif
+        if (received <= 0) {
+            return;
+        }
+
+        uint32_t instanceId;
+        uint32_t keyframeSequence;
+        uint32_t highestSequence;
+        if (UdpWire::readAck(buffer, static_cast<size_t>(received), instanceId, keyframeSequence,
+                             highestSequence)) {
+            auto it = encoders_.find(instanceId);
+            if (it != encoders_.end()) {
+                it->second->onAck(keyframeSequence);
+                ++stats_.acks;
+            }
+        } else if (UdpWire::readKeyframeRequest(buffer, static_cast<size_t>(received), instanceId,
+                                                keyframeSequence)) {
+            auto it = encoders_.find(instanceId);
+            if (it != encoders_.end()) {
+                it->second->onKeyframeRequest(keyframeSequence);
+                ++stats_.keyframeRequests;
+            }
+        }
+    }
+}
+
+UdpClientStats UdpClient::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+UdpReceiver::UdpReceiver()
+    : stats_()
+    , lossRate_(0.0)
+    , random_(1)
+    , port_(0)
+    , buffer_(65536)
+    , socket_(fromHandle(kNoSocket))
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        LOG_ERROR("WSAStartup failed");
+    }
+#endif
+}
+
+UdpReceiver::~UdpReceiver() {
+    close();
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool UdpReceiver::bind(int port) {
+    close();
+
+    SocketHandle sock = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock == kNoSocket) {
+        LOG_ERROR("Failed to create UDP socket");
+        return false;
+    }
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    socklen_t length = sizeof(address);
+    if (::bind(sock, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        getsockname(sock, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        LOG_ERROR("Failed to bind UDP port " + std::to_string(port));
+        closeHandle(sock);
+        return false;
+    }
+
+    socket_ = fromHandle(sock);
+    port_ = ntohs(address.sin_port);
+    decoders_.clear();
+    stats_ = UdpReceiverStats();
+    return true;
+}
+
+void UdpReceiver::close() {
+    SocketHandle sock = toHandle(socket_);
+    if (sock != kNoSocket) {
+        closeHandle(sock);
+        socket_ = fromHandle(kNoSocket);
+    }
+}
+
+int UdpReceiver::getPort() const {
+    return port_;
+}
+
+void UdpReceiver::setSimulatedLoss(double rate, uint32_t seed) {
+    lossRate_ = std::max(0.0, std::min(rate, 1.0));
+    random_.seed(seed);
+}
+
+const GameState* UdpReceiver::receive(int timeoutMs, UdpFrameInfo& outInfo) {
+    SocketHandle sock = toHandle(socket_);
+    if (sock == kNoSocket) {
+        return nullptr;
+    }
+
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    for (;;) {
+        int remainingMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count());
+        if (remainingMs < 0) {
+            return nullptr;
+        }
+
+#ifdef _WIN32
+        WSAPOLLFD pollFd = {sock, POLLIN, 0};
+        int ready = WSAPoll(&pollFd, 1, remainingMs);
+#else
+        pollfd pollFd = {sock, POLLIN, 0};
+        int ready = poll(&pollFd, 1, remainingMs);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (ready <= 0) {
+            return nullptr;
+        }
+
+        sockaddr_in sender = {};
+        socklen_t senderLength = sizeof(sender);
+#ifdef _WIN32
+        int received = recvfrom(sock, reinterpret_cast<char*>(buffer_.data()), static_cast<int>(buffer_.size()), 0,
+                                reinterpret_cast<sockaddr*>(&sender), &senderLength);
+#else
+        ssize_t received = recvfrom(sock, buffer_.data(), buffer_.size(), 0,
+                                    reinterpret_cast<sockaddr*>(&sender), &senderLength);
+#endif
+        if (received <= 0) {
+            continue;
+        }
+        ++stats_.datagrams;
+
+        if (lossRate_ > 0.0 && chance(random_) < lossRate_) {
+            ++stats_.simulatedDrops;
+            continue;
+        }
+
+        UdpWire::Header header;
+        if (!UdpWire::readHeader(buffer_.data(), static_cast<size_t>(received), header)) {
+            ++stats_.malformed;
+            continue;
+        }
+
+        std::unique_ptr<UdpSnapshotDecoder>& decoder = decoders_[header.instanceId];
+        if (!decoder) {
+            decoder = std::make_unique<UdpSnapshotDecoder>();
+        }
+
+        uint64_t lostBefore = decoder->getLostCount();
+        uint64_t missedBefore = decoder->getMissedEventCount();
+        UdpDecodeResult result = decoder->decode(buffer_.data(), static_cast<size_t>(received), header);
+        stats_.lost += decoder->getLostCount() - lostBefore;
+        stats_.missedEvents += decoder->getMissedEventCount() - missedBefore;
+
+        switch (result) {
+            case UdpDecodeResult::UPDATED:
+                ++stats_.updates;
+                break;
+            case UdpDecodeResult::STALE:
+                ++stats_.stale;
+                continue;
+            case UdpDecodeResult::MISSING_BASE:
+                // The sender's base is one we never got (or lost in a restart): ask for a keyframe
+                ++stats_.missingBase;
+                sendKeyframeRequest(header, &sender, senderLength);
+                continue;
+            case UdpDecodeResult::MALFORMED:
+                ++stats_.malformed;
+                continue;
+        }
+
+        if (header.type == UdpWire::KEYFRAME || header.sequence % kAckInterval == 0) {
+            sendAck(header, *decoder, &sender, senderLength);
+        }
+
+        outInfo.instanceId = header.instanceId;
+        outInfo.sequence = header.sequence;
+        outInfo.keyframe = header.type == UdpWire::KEYFRAME;
+        return &decoder->getState();
+    }
+}
+
+void UdpReceiver::sendAck(const UdpWire::Header& header, const UdpSnapshotDecoder& decoder, const void* address,
+                          size_t addressLength) {
+    if (decoder.getNewestKeyframe() == 0) {
+        return;
+    }
+
+    uint8_t ack[UdpWire::kMaxDatagramSize];
+    size_t length = UdpWire::writeAck(header.instanceId, decoder.getNewestKeyframe(), decoder.getSequence(), ack);
+    if (sendControl(ack, length, address, addressLength)) {
+        ++stats_.acksSent;
+    }
+}
+
+void UdpReceiver::sendKeyframeRequest(const UdpWire::Header& header, const void* address, size_t addressLength) {
+    uint8_t request[UdpWire::kMaxDatagramSize];
+    size_t length = UdpWire::writeKeyframeRequest(header.instanceId, header.baseSequence, request);
+    if (sendControl(request, length, address, addressLength)) {
+        ++stats_.keyframeRequestsSent;
+    }
+}
+
+bool UdpReceiver::sendControl(const uint8_t* data, size_t length, const void* address, size_t addressLength) {
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    if (lossRate_ > 0.0 && chance(random_) < lossRate_) {
+        ++stats_.simulatedDrops;
+        return false;
+    }
+
+#ifdef _WIN32
+    sendto(toHandle(socket_), reinterpret_cast<const char*>(data), static_cast<int>(length), 0,
+           static_cast<const sockaddr*>(address), static_cast<int>(addressLength));
+#else
+    sendto(toHandle(socket_), data, length, 0, static_cast<const sockaddr*>(address),
+           static_cast<socklen_t>(addressLength));
+#endif
+    return true;
+}
+
+UdpReceiverStats UdpReceiver::getStats() const {
+    return stats_;
+}
+
+} // namespace CS16Capture
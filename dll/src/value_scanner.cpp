@@ -0,0 +1,605 @@
+#include "../include/value_scanner.h"
+#include "../include/logger.h"
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+namespace CS16Capture {
+
+namespace {
+
+// Bytes covered by one bitmap word of 4-byte slots; chunks start on these
+const size_t kBytesPerWord = 64 * 4;
+
+inline uint32_t load32(const uint8_t* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline float asFloat(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline uint64_t popcount(uint64_t bits) {
+    return static_cast<uint64_t>(std::bitset<64>(bits).count());
+}
+
+/**
+ * Match 4-byte slots of current against previous into a bitmap, 64 slots per
+ * word. The inner loop has no branches so it vectorizes; with an input
+ * bitmap, words without candidates are skipped.
+ */
+template<typename Predicate>
+uint64_t matchSlots(const uint8_t* current, const uint8_t* previous, const uint64_t* input, uint64_t* output,
+                    size_t slotCount, Predicate predicate) {
+    uint64_t count = 0;
+    size_t words = (slotCount + 63) / 64;
+    for (size_t word = 0; word < words; ++word) {
+        if (input != nullptr && input[word] == 0) {
+            output[word] = 0;
+            continue;
+        }
+
+        const uint8_t* c = current + word * kBytesPerWord;
+        const uint8_t* p = previous + word * kBytesPerWord;
+        size_t slots = std::min<size_t>(64, slotCount - word * 64);
+        uint64_t bits = 0;
+        if (slots == 64) {
+            for (size_t j = 0; j < 64; ++j) {
+                bits |= static_cast<uint64_t>(predicate(load32(c + j * 4), load32(p + j * 4))) << j;
+            }
+        } else {
+            for (size_t j = 0; j < slots; ++j) {
+                bits |= static_cast<uint64_t>(predicate(load32(c + j * 4), load32(p + j * 4))) << j;
+            }
+        }
+
+        if (input != nullptr) {
+            bits &= input[word];
+        }
+        output[word] = bits;
+        count += popcount(bits);
+    }
+    return count;
+}
+
+} // namespace
+
+struct ValueScanner::Region {
+    uintptr_t base;
+    size_t size;
+    bool dense;                        // bitmap + snapshot, else slots + values
+    std::vector<uint64_t> bitmap;      // Dense: bit per 4-byte slot
+    std::vector<std::vector<uint8_t>> snapshot;  // Dense: bytes of each chunk as of the last scan
+    std::vector<uint32_t> slots;       // Sparse: ascending slot indices
+    std::vector<uint32_t> values;      // Sparse: values as of the last scan (numbers only)
+    std::vector<uint64_t> newBitmap;   // Output of the running scan
+    size_t firstChunk;
+    size_t chunkCount;
+};
+
+struct ValueScanner::ChunkResult {
+    size_t region;
+    size_t begin;      // Bytes within the region, or indices into its slots for list regions
+    size_t end;
+    uint64_t count;
+    bool dense;        // Matches are in newBitmap and the chunk bytes are kept
+    std::vector<uint8_t> bytes;
+    std::vector<uint32_t> slots;
+    std::vector<uint32_t> values;
+    uint64_t bytesRead;
+    uint64_t unreadable;
+};
+
+struct ValueScanner::Matcher {
+    ScanValueType type;
+    bool exact;            // Compare with the value below, else with the previous scan
+    ScanCompare compare;
+    uint32_t bits;         // Exact int or float value
+    float tolerance;
+    std::string text;      // Strings: text searched for, or the last one for relative scans
+};
+
+namespace {
+
+// Call fn with the predicate (current, previous) -> bool of a numeric scan
+template<typename Matcher, typename Fn>
+void withPredicate(const Matcher& matcher, Fn&& fn) {
+    if (matcher.type == ScanValueType::INT32) {
+        if (matcher.exact) {
+            uint32_t value = matcher.bits;
+            fn([value](uint32_t current, uint32_t) { return current == value; });
+            return;
+        }
+        switch (matcher.compare) {
+            case ScanCompare::CHANGED:
+                fn([](uint32_t current, uint32_t previous) { return current != previous; });
+                break;
+            case ScanCompare::UNCHANGED:
+                fn([](uint32_t current, uint32_t previous) { return current == previous; });
+                break;
+            case ScanCompare::INCREASED:
+                fn([](uint32_t current, uint32_t previous) {
+                    return static_cast<int32_t>(current) > static_cast<int32_t>(previous);
+                });
+                break;
+            case ScanCompare::DECREASED:
+                fn([](uint32_t current, uint32_t previous) {
+                    return static_cast<int32_t>(current) < static_cast<int32_t>(previous);
+                });
+                break;
+        }
+        return;
+    }
+
+    if (matcher.exact) {
+        float value = asFloat(matcher.bits);
+        float tolerance = matcher.tolerance;
+        fn([value, tolerance](uint32_t current, uint32_t) { return std::fabs(asFloat(current) - value) <= tolerance; });
+        return;
+    }
+    switch (matcher.compare) {
+        case ScanCompare::CHANGED:
+            fn([](uint32_t current, uint32_t previous) { return current != previous; });
+            break;
+        case ScanCompare::UNCHANGED:
+            fn([](uint32_t current, uint32_t previous) { return current == previous; });
+            break;
+        case ScanCompare::INCREASED:
+            fn([](uint32_t current, uint32_t previous) { return asFloat(current) > asFloat(previous); });
+            break;
+        case ScanCompare::DECREASED:
+            fn([](uint32_t current, uint32_t previous) { return asFloat(current) < asFloat(previous); });
+            break;
+    }
+}
+
+size_t alignmentOf(ScanValueType type) {
+    return type == ScanValueType::STRING ? 1 : 4;
+}
+
+} // namespace
+
+ValueScanner::ValueScanner(MemoryReader& reader, size_t threadCount)
+    : reader_(reader)
+    , pool_(std::make_unique<ThreadPool>(threadCount))
+    , hasScan_(false)
+    , type_(ScanValueType::INT32)
+    , tolerance_(0.0f)
+    , stats_()
+{
+}
+
+ValueScanner::~ValueScanner() {
+    pool_->shutdown();
+}
+
+bool ValueScanner::firstScanInt(int32_t value) {
+    Matcher matcher = {ScanValueType::INT32, true, ScanCompare::UNCHANGED, static_cast<uint32_t>(value), 0.0f, ""};
+    return runScan(matcher, true);
+}
+
+bool ValueScanner::firstScanFloat(float value, float tolerance) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    Matcher matcher = {ScanValueType::FLOAT, true, ScanCompare::UNCHANGED, bits, std::fabs(tolerance), ""};
+    return runScan(matcher, true);
+}
+
+bool ValueScanner::firstScanString(const std::string& value) {
+    if (value.empty()) {
+        return false;
+    }
+    Matcher matcher = {ScanValueType::STRING, true, ScanCompare::UNCHANGED, 0, 0.0f, value};
+    return runScan(matcher, true);
+}
+
+bool ValueScanner::nextScanInt(int32_t value) {
+    if (!hasScan_ || type_ != ScanValueType::INT32) {
+        return false;
+    }
+    Matcher matcher = {ScanValueType::INT32, true, ScanCompare::UNCHANGED, static_cast<uint32_t>(value), 0.0f, ""};
+    return runScan(matcher, false);
+}
+
+bool ValueScanner::nextScanFloat(float value) {
+    if (!hasScan_ || type_ != ScanValueType::FLOAT) {
+        return false;
+    }
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    Matcher matcher = {ScanValueType::FLOAT, true, ScanCompare::UNCHANGED, bits, tolerance_, ""};
+    return runScan(matcher, false);
+}
+
+bool ValueScanner::nextScanString(const std::string& value) {
+    if (!hasScan_ || type_ != ScanValueType::STRING || value.empty()) {
+        return false;
+    }
+    Matcher matcher = {ScanValueType::STRING, true, ScanCompare::UNCHANGED, 0, 0.0f, value};
+    return runScan(matcher, false);
+}
+
+bool ValueScanner::nextScan(ScanCompare compare) {
+    if (!hasScan_) {
+        return false;
+    }
+    if (type_ == ScanValueType::STRING && compare != ScanCompare::CHANGED && compare != ScanCompare::UNCHANGED) {
+        LOG_WARNING("Strings can only be scanned for changed or unchanged text");
+        return false;
+    }
+    Matcher matcher = {type_, false, compare, 0, tolerance_, lastText_};
+    return runScan(matcher, false);
+}
+
+void ValueScanner::reset() {
+    regions_.clear();
+    hasScan_ = false;
+    lastText_.clear();
+}
+
+bool ValueScanner::hasScan() const {
+    return hasScan_;
+}
+
+ScanValueType ValueScanner::getValueType() const {
+    return type_;
+}
+
+uint64_t ValueScanner::getCandidateCount() const {
+    return stats_.candidates;
+}
+
+void ValueScanner::getCandidates(std::vector<uintptr_t>& outAddresses, size_t limit) const {
+    outAddresses.clear();
+    const size_t alignment = alignmentOf(type_);
+    for (const Region& region : regions_) {
+        if (region.dense) {
+            for (size_t word = 0; word < region.bitmap.size(); ++word) {
+                for (uint64_t bits = region.bitmap[word]; bits != 0; bits &= bits - 1) {
+                    if (outAddresses.size() >= limit) {
+                        return;
+                    }
+                    size_t slot = word * 64 + static_cast<size_t>(std::bitset<64>((bits & (~bits + 1)) - 1).count());
+                    outAddresses.push_back(region.base + slot * alignment);
+                }
+            }
+        } else {
+            for (uint32_t slot : region.slots) {
+                if (outAddresses.size() >= limit) {
+                    return;
+                }
+                outAddresses.push_back(region.base + static_cast<uintptr_t>(slot) * alignment);
+            }
+        }
+    }
+}
+
+const ScanStats& ValueScanner::getLastStats() const {
+    return stats_;
+}
+
+bool ValueScanner::runScan(const Matcher& matcher, bool first) {
+    auto start = std::chrono::steady_clock::now();
+
+    if (first) {
+        std::vector<MemoryRegion> maps;
+        if (!reader_.getWritableRegions(maps)) {
+            return false;
+        }
+
+        regions_.clear();
+        regions_.resize(maps.size());
+        for (size_t i = 0; i < maps.size(); ++i) {
+            regions_[i].base = maps[i].base;
+            regions_[i].size = maps[i].size;
+            regions_[i].dense = matcher.type != ScanValueType::STRING;
+        }
+        type_ = matcher.type;
+        tolerance_ = matcher.tolerance;
+    }
+
+    // Split every region into independent pieces of work
+    std::vector<ChunkResult> chunks;
+    for (size_t index = 0; index < regions_.size(); ++index) {
+        Region& region = regions_[index];
+        region.firstChunk = chunks.size();
+
+        bool byBytes = region.dense || first;
+        size_t total = byBytes ? region.size : region.slots.size();
+        size_t step = byBytes ? kChunkSize : kListTaskSize;
+        if (region.dense) {
+            region.newBitmap.assign((region.size / 4 + 63) / 64, 0);
+        }
+        for (size_t begin = 0; begin < total; begin += step) {
+            ChunkResult chunk = {};
+            chunk.region = index;
+            chunk.begin = begin;
+            chunk.end = std::min(total, begin + step);
+            chunks.push_back(std::move(chunk));
+        }
+        region.chunkCount = chunks.size() - region.firstChunk;
+    }
+
+    std::vector<ThreadPool::Task> tasks;
+    tasks.reserve(chunks.size());
+    for (ChunkResult& chunk : chunks) {
+        Region& region = regions_[chunk.region];
+        ChunkResult* result = &chunk;
+        const Matcher* m = &matcher;
+        if (region.dense) {
+            tasks.push_back([this, m, &region, result, first] { scanBitmapChunk(*m, region, *result, first); });
+        } else if (first) {
+            tasks.push_back([this, m, &region, result] { scanStringChunk(*m, region, *result); });
+        } else {
+            tasks.push_back([this, m, &region, result] { scanListRange(*m, region, *result); });
+        }
+    }
+    runTasks(tasks);
+
+    stats_ = ScanStats();
+    for (const ChunkResult& chunk : chunks) {
+        stats_.bytesRead += chunk.bytesRead;
+        stats_.unreadableBytes += chunk.unreadable;
+    }
+
+    for (Region& region : regions_) {
+        finishRegion(region, chunks);
+    }
+    regions_.erase(std::remove_if(regions_.begin(), regions_.end(), [](const Region& region) {
+        return region.dense ? region.bitmap.empty() : region.slots.empty();
+    }), regions_.end());
+
+    for (const Region& region : regions_) {
+        if (region.dense) {
+            ++stats_.bitmapRegions;
+            for (uint64_t bits : region.bitmap) {
+                stats_.candidates += popcount(bits);
+            }
+        } else {
+            ++stats_.listRegions;
+            stats_.candidates += region.slots.size();
+        }
+    }
+
+    if (matcher.type == ScanValueType::STRING && matcher.exact) {
+        lastText_ = matcher.text;
+    }
+    hasScan_ = true;
+    stats_.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_DEBUG("Scan kept " + std::to_string(stats_.candidates) + " candidates in " +
+              std::to_string(regions_.size()) + " regions");
+    return true;
+}
+
+void ValueScanner::scanBitmapChunk(const Matcher& matcher, Region& region, ChunkResult& result, bool first) {
+    const size_t firstWord = result.begin / kBytesPerWord;
+    const size_t slotCount = (result.end - result.begin) / 4;
+    const size_t wordCount = (slotCount + 63) / 64;
+    uint64_t* output = region.newBitmap.data() + firstWord;
+    const uint64_t* input = first ? nullptr : region.bitmap.data() + firstWord;
+
+    // Nothing to re-check in this chunk: do not even read it
+    if (input != nullptr && std::all_of(input, input + wordCount, [](uint64_t bits) { return bits == 0; })) {
+        return;
+    }
+
+    result.bytes.resize(result.end - result.begin);
+    if (!reader_.readBuffer(region.base + result.begin, result.bytes.data(), result.bytes.size())) {
+        result.unreadable = result.bytes.size();
+        std::fill(output, output + wordCount, 0);
+        std::vector<uint8_t>().swap(result.bytes);
+        return;
+    }
+    result.bytesRead = result.bytes.size();
+
+    const uint8_t* current = result.bytes.data();
+    const uint8_t* previous = first ? current : region.snapshot[result.begin / kChunkSize].data();
+    withPredicate(matcher, [&](auto predicate) {
+        result.count = matchSlots(current, previous, input, output, slotCount, predicate);
+    });
+
+    result.dense = result.count * kListDensity >= slotCount;
+    if (!result.dense) {
+        // Few matches: keep them as a list and let the chunk bytes go
+        const uint32_t baseSlot = static_cast<uint32_t>(result.begin / 4);
+        result.slots.reserve(result.count);
+        result.values.reserve(result.count);
+        for (size_t word = 0; word < wordCount; ++word) {
+            for (uint64_t bits = output[word]; bits != 0; bits &= bits - 1) {
+                size_t bit = static_cast<size_t>(std::bitset<64>((bits & (~bits + 1)) - 1).count());
+                size_t slot = word * 64 + bit;
+                result.slots.push_back(baseSlot + static_cast<uint32_t>(slot));
+                result.values.push_back(load32(current + slot * 4));
+            }
+        }
+        std::vector<uint8_t>().swap(result.bytes);
+    }
+}
+
+void ValueScanner::scanListRange(const Matcher& matcher, const Region& region, ChunkResult& result) {
+    const size_t alignment = alignmentOf(matcher.type);
+    const size_t valueSize = matcher.type == ScanValueType::STRING ? matcher.text.size() : 4;
+    const std::vector<uint32_t>& slots = region.slots;
+    std::vector<uint8_t> window(kReadWindow);
+    uint8_t single[256];
+
+    auto keep = [&](uint32_t slot, const uint8_t* data, size_t index) {
+        if (matcher.type == ScanValueType::STRING) {
+            bool same = std::memcmp(data, matcher.text.data(), valueSize) == 0;
+            bool wanted = matcher.exact || matcher.compare == ScanCompare::UNCHANGED ? same : !same;
+            if (wanted) {
+                result.slots.push_back(slot);
+            }
+            return;
+        }
+        withPredicate(matcher, [&](auto predicate) {
+            uint32_t current = load32(data);
+            if (predicate(current, region.values[index])) {
+                result.slots.push_back(slot);
+                result.values.push_back(current);
+            }
+        });
+    };
+
+    size_t i = result.begin;
+    while (i < result.end) {
+        // Read the candidates that fit into one window with a single call
+        size_t start = static_cast<size_t>(slots[i]) * alignment;
+        size_t j = i + 1;
+        while (j < result.end && static_cast<size_t>(slots[j]) * alignment + valueSize - start <= kReadWindow) {
+            ++j;
+        }
+        size_t length = static_cast<size_t>(slots[j - 1]) * alignment + valueSize - start;
+        if (start + length > region.size) {
+            length = region.size - start;
+        }
+
+        if (reader_.readBuffer(region.base + start, window.data(), length)) {
+            result.bytesRead += length;
+            for (size_t k = i; k < j; ++k) {
+                size_t offset = static_cast<size_t>(slots[k]) * alignment - start;
+                if (offset + valueSize <= length) {
+                    keep(slots[k], window.data() + offset, k);
+                }
+            }
+        } else {
+            // Part of the window is gone; salvage the candidates one by one
+            for (size_t k = i; k < j; ++k) {
+                uintptr_t address = region.base + static_cast<uintptr_t>(slots[k]) * alignment;
+                if (valueSize <= sizeof(single) && reader_.readBuffer(address, single, valueSize)) {
+                    result.bytesRead += valueSize;
+                    keep(slots[k], single, k);
+                } else {
+                    result.unreadable += valueSize;
+                }
+            }
+        }
+        i = j;
+    }
+    result.count = result.slots.size();
+}
+
+void ValueScanner::scanStringChunk(const Matcher& matcher, const Region& region, ChunkResult& result) {
+    const std::string& text = matcher.text;
+    // Overlap the next chunk so a string across the boundary is found
+    size_t readEnd = std::min(region.size, result.end + text.size() - 1);
+    std::vector<uint8_t> bytes(readEnd - result.begin);
+    if (!reader_.readBuffer(region.base + result.begin, bytes.data(), bytes.size())) {
+        result.unreadable = bytes.size();
+        return;
+    }
+    result.bytesRead = bytes.size();
+
+    const uint8_t* data = bytes.data();
+    const size_t limit = result.end - result.begin;
+    const uint8_t firstByte = static_cast<uint8_t>(text[0]);
+    size_t position = 0;
+    while (position < limit) {
+        const void* hit = std::memchr(data + position, firstByte, limit - position);
+        if (hit == nullptr) {
+            break;
+        }
+        position = static_cast<size_t>(static_cast<const uint8_t*>(hit) - data);
+        if (position + text.size() <= bytes.size() && std::memcmp(data + position, text.data(), text.size()) == 0) {
+            result.slots.push_back(static_cast<uint32_t>(result.begin + position));
+        }
+        ++position;
+    }
+    result.count = result.slots.size();
+}
+
+void ValueScanner::finishRegion(Region& region, std::vector<ChunkResult>& chunks) {
+    ChunkResult* begin = chunks.data() + region.firstChunk;
+    ChunkResult* end = begin + region.chunkCount;
+
+    uint64_t total = 0;
+    for (ChunkResult* chunk = begin; chunk != end; ++chunk) {
+        total += chunk->count;
+    }
+
+    const size_t slotCount = region.size / 4;
+    if (region.dense && total * kListDensity >= slotCount) {
+        // Still dense: the new bitmap plus the bytes each candidate had now
+        // Dense chunks hand over their buffers; sparse ones rebuild theirs
+        region.bitmap.swap(region.newBitmap);
+        region.snapshot.resize(region.chunkCount);
+        for (size_t index = 0; index < region.chunkCount; ++index) {
+            ChunkResult& chunk = begin[index];
+            std::vector<uint8_t> bytes;
+            if (chunk.dense) {
+                bytes.swap(chunk.bytes);
+            } else if (chunk.count > 0) {
+                bytes.resize(chunk.end - chunk.begin);
+                for (size_t i = 0; i < chunk.slots.size(); ++i) {
+                    std::memcpy(bytes.data() + static_cast<size_t>(chunk.slots[i]) * 4 - chunk.begin,
+                                &chunk.values[i], sizeof(uint32_t));
+                }
+            }
+            region.snapshot[index].swap(bytes);
+        }
+        std::vector<uint64_t>().swap(region.newBitmap);
+        return;
+    }
+
+    // Sparse (or strings): a sorted list, chunks are already in address order
+    std::vector<uint32_t> slots;
+    std::vector<uint32_t> values;
+    slots.reserve(total);
+    if (type_ != ScanValueType::STRING) {
+        values.reserve(total);
+    }
+    for (ChunkResult* chunk = begin; chunk != end; ++chunk) {
+        if (chunk->dense) {
+            const size_t firstWord = chunk->begin / kBytesPerWord;
+            const size_t lastWord = firstWord + ((chunk->end - chunk->begin) / 4 + 63) / 64;
+            for (size_t word = firstWord; word < lastWord; ++word) {
+                for (uint64_t bits = region.newBitmap[word]; bits != 0; bits &= bits - 1) {
+                    size_t slot = word * 64 + static_cast<size_t>(std::bitset<64>((bits & (~bits + 1)) - 1).count());
+                    slots.push_back(static_cast<uint32_t>(slot));
+                    values.push_back(load32(chunk->bytes.data() + slot * 4 - chunk->begin));
+                }
+            }
+            std::vector<uint8_t>().swap(chunk->bytes);
+        } else {
+            slots.insert(slots.end(), chunk->slots.begin(), chunk->slots.end());
+            values.insert(values.end(), chunk->values.begin(), chunk->values.end());
+        }
+    }
+
+    region.dense = false;
+    region.slots.swap(slots);
+    region.values.swap(values);
+    std::vector<uint64_t>().swap(region.bitmap);
+    std::vector<uint64_t>().swap(region.newBitmap);
+    std::vector<std::vector<uint8_t>>().swap(region.snapshot);
+}
+
+void ValueScanner::runTasks(std::vector<ThreadPool::Task>& tasks) {
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t remaining = tasks.size();
+
+    for (ThreadPool::Task& task : tasks) {
+        pool_->submit([&mutex, &done, &remaining, work = std::move(task)] {
+            work();
+            // Notify under the lock: the waiter may destroy the condition variable once it sees 0
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0) {
+                done.notify_one();
+            }
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&remaining] { return remaining == 0; });
+}
+
+} // namespace CS16Capture
@@ -1,6 +1,6 @@
 #include "../include/websocket_client.h"
 #include "../include/logger.h"
-#include <sstream>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
@@ -13,6 +13,7 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <cerrno>
 #endif
 
 namespace CS16Capture {
@@ -21,13 +22,21 @@ WebSocketClient::WebSocketClient()
     : connected_(false)
     , autoReconnect_(true)
     , shouldStop_(false)
+    , connectionGeneration_(0)
     , port_(0)
+    , reconnecting_(false)
+    , stopReconnect_(false)
+    , droppedAtConnect_(0)
+    , supersededAtConnect_(0)
+    , subscriptionVersion_(0)
 #ifdef _WIN32
     , socket_(nullptr)
 #else
     , socket_(-1)
 #endif
 {
+    freeBuffers_.reserve(kMaxFreeBuffers);
+
 #ifdef _WIN32
     WSADATA wsaData;
     if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
@@ -94,28 +103,90 @@ bool WebSocketClient::connect(const std::string& host, int port) {
     socket_ = sock;
 #endif
 
+    // Every connection starts a fresh compressed stream, announced in plain text
+    compressor_.reset(compression_);
+    if (compressor_.isEnabled()) {
+        // A failed write shows up again with the first frame
+        std::string hello;
+        compressor_.makeHello(hello);
+        sendBytes(hello.data(), hello.size());
+    }
+
     connected_ = true;
     shouldStop_ = false;
+    {
+        // Queued frames refer to names and "seq" of the previous server
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        lanes_.clear();
+        droppedAtConnect_ = lanes_.getDroppedCount();
+        supersededAtConnect_ = lanes_.getSupersededCount();
+        ++connectionGeneration_;
+    }
+
+    // A new server starts from the default subscription
+    {
+        std::lock_guard<std::mutex> lock(subscriptionMutex_);
+        subscription_ = Subscription();
+    }
+    ++subscriptionVersion_;
+    latency_.reset();
 
-    // Start send thread
+    // Start send and receive threads
     sendThread_ = std::make_unique<std::thread>(&WebSocketClient::sendThreadFunc, this);
+    receiveThread_ = std::make_unique<std::thread>(&WebSocketClient::receiveThreadFunc, this);
 
     LOG_INFO("Connected to WebSocket server at " + host + ":" + std::to_string(port));
     return true;
 }
 
 void WebSocketClient::disconnect() {
-    if (!connected_) {
+    {
+        std::lock_guard<std::mutex> lock(reconnectMutex_);
+        stopReconnect_ = true;
+    }
+    reconnectCondition_.notify_all();
+    if (reconnectThread_ && reconnectThread_->joinable()) {
+        reconnectThread_->join();
+    }
+    reconnectThread_.reset();
+
+    closeConnection();
+
+    std::lock_guard<std::mutex> lock(reconnectMutex_);
+    stopReconnect_ = false;
+}
+
+void WebSocketClient::closeConnection() {
+    // The send thread clears connected_ itself on a send error, so the thread
+    // and socket may still need cleaning up while already disconnected
+    bool wasConnected = connected_.exchange(false);
+    if (!wasConnected && !sendThread_) {
         return;
     }
 
     shouldStop_ = true;
-    connected_ = false;
+    queueCondition_.notify_all();
+
+    // Unblock the receive thread; the socket is closed once both threads exit
+#ifdef _WIN32
+    if (socket_ != nullptr) {
+        shutdown(reinterpret_cast<SOCKET>(socket_), SD_BOTH);
+    }
+#else
+    if (socket_ >= 0) {
+        shutdown(socket_, SHUT_RDWR);
+    }
+#endif
 
-    // Wait for send thread to finish
+    // Wait for send and receive threads to finish
     if (sendThread_ && sendThread_->joinable()) {
         sendThread_->join();
     }
+    sendThread_.reset();
+    if (receiveThread_ && receiveThread_->joinable()) {
+        receiveThread_->join();
+    }
+    receiveThread_.reset();
 
 #ifdef _WIN32
     if (socket_ != nullptr) {
@@ -129,7 +200,9 @@ void WebSocketClient::disconnect() {
     }
 #endif
 
-    LOG_INFO("Disconnected from WebSocket server");
+    if (wasConnected) {
+        LOG_INFO("Disconnected from WebSocket server");
+    }
 }
 
 bool WebSocketClient::isConnected() const {
@@ -137,148 +210,392 @@ bool WebSocketClient::isConnected() const {
 }
 
 bool WebSocketClient::sendGameState(const GameState& state) {
-    std::string json = gameStateToJson(state);
-    return sendMessage(json);
+    std::string json = acquireBuffer();
+    // Held until the frame is queued, so a refused frame is the one discarded
+    std::lock_guard<std::mutex> lock(encoderMutex_);
+    applySubscription(encoder_);
+    encoder_.encode(state, connectionGeneration_, json);
+    // All frames of this encoder form one stream
+    return sendFrame(std::move(json), encoder_, state.captureTimeNs, 1);
+}
+
+bool WebSocketClient::sendMessage(const std::string& jsonMessage, SendLane lane) {
+    std::string buffer = acquireBuffer();
+    buffer.assign(jsonMessage);
+    return sendMessage(std::move(buffer), 0, lane);
+}
+
+bool WebSocketClient::sendMessage(std::string&& message, uint64_t captureTimeNs, SendLane lane) {
+    return enqueue(message, captureTimeNs, lane, 0, 0, 0);
+}
+
+bool WebSocketClient::sendFrame(std::string&& frame, StateEncoder& encoder, uint64_t captureTimeNs,
+                                uint64_t stream) {
+    SendLane lane = encoder.isFrameReplaceable() ? SendLane::STATE : SendLane::EVENTS;
+    if (!enqueue(frame, captureTimeNs, lane, stream, encoder.getFrameTopics(), encoder.getConnectionGeneration())) {
+        // Names and events are sent once: the next frame carries them instead
+        encoder.discardFrame();
+        return false;
+    }
+    return true;
 }
 
-bool WebSocketClient::sendMessage(const std::string& jsonMessage) {
+bool WebSocketClient::enqueue(std::string& message, uint64_t captureTimeNs, SendLane lane, uint64_t stream,
+                              uint32_t topics, uint64_t generation) {
+    // Encoders produce nothing when no subscribed topic is due
+    if (message.empty()) {
+        releaseBuffer(message);
+        return true;
+    }
+
     if (!connected_) {
+        // Fail fast: the caller may be a capture tick that must not miss its slot
         if (autoReconnect_) {
-            tryReconnect();
-            if (!connected_) {
-                return false;
-            }
-        } else {
-            return false;
+            requestReconnect();
         }
+        releaseBuffer(message);
+        return false;
     }
 
-    std::lock_guard<std::mutex> lock(queueMutex_);
-    messageQueue_.push(jsonMessage);
+    bool queued;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        // The lanes hand back a spent buffer, or the message itself when
+        // they refuse it; either goes back to the pool
+        // A frame encoded before a reconnect would reach the new server
+        queued = (generation == 0 || generation == connectionGeneration_) &&
+                 lanes_.push(lane, message, captureTimeNs, stream, topics);
+        recycleBuffer(message);
+    }
+    if (!queued) {
+        return false;
+    }
+    queueCondition_.notify_one();
     
     return true;
 }
 
+std::string WebSocketClient::acquireBuffer() {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    if (freeBuffers_.empty()) {
+        return std::string();
+    }
+
+    std::string buffer = std::move(freeBuffers_.back());
+    freeBuffers_.pop_back();
+    buffer.clear();
+    return buffer;
+}
+
+void WebSocketClient::releaseBuffer(std::string& buffer) {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    recycleBuffer(buffer);
+}
+
+void WebSocketClient::recycleBuffer(std::string& buffer) {
+    // Empty slots hand back small-string buffers, which are not worth keeping
+    if (buffer.capacity() > std::string().capacity() && freeBuffers_.size() < kMaxFreeBuffers) {
+        freeBuffers_.push_back(std::move(buffer));
+    }
+}
+
 void WebSocketClient::setAutoReconnect(bool enable) {
     autoReconnect_ = enable;
 }
 
+bool WebSocketClient::setCompression(const CompressionConfig& config) {
+    if (!isCompressionCodecAvailable(config.codec)) {
+        LOG_WARNING(std::string("Compression codec '") + compressionCodecToString(config.codec) +
+                    "' was not compiled in");
+        return false;
+    }
+    compression_ = config;
+    return true;
+}
+
+void WebSocketClient::setLaneConfig(const SendLaneConfig& config) {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    lanes_.configure(config);
+    droppedAtConnect_ = 0;
+    supersededAtConnect_ = 0;
+}
+
 size_t WebSocketClient::getPendingMessageCount() const {
-    std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(queueMutex_));
-    return messageQueue_.size();
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return lanes_.size();
 }
 
-std::string WebSocketClient::gameStateToJson(const GameState& state) {
-    std::ostringstream json;
-    json << "{\n";
-    
-    // Players array
-    json << "  \"players\": [\n";
-    for (size_t i = 0; i < state.players.size(); ++i) {
-        const auto& player = state.players[i];
-        json << "    {\n";
-        json << "      \"name\": \"" << player.name << "\",\n";
-        json << "      \"kills\": " << player.kills << ",\n";
-        json << "      \"deaths\": " << player.deaths << ",\n";
-        json << "      \"assists\": " << player.assists << ",\n";
-        json << "      \"money\": " << player.money << ",\n";
-        json << "      \"team\": " << player.team << ",\n";
-        json << "      \"isAlive\": " << (player.isAlive ? "true" : "false") << "\n";
-        json << "    }";
-        if (i < state.players.size() - 1) {
-            json << ",";
-        }
-        json << "\n";
-    }
-    json << "  ],\n";
-    
-    // Bomb data
-    json << "  \"bomb\": {\n";
-    json << "    \"planted\": " << (state.bomb.planted ? "true" : "false") << ",\n";
-    json << "    \"timeRemaining\": " << state.bomb.timeRemaining << ",\n";
-    json << "    \"defused\": " << (state.bomb.defused ? "true" : "false") << "\n";
-    json << "  },\n";
-    
-    // Events array
-    json << "  \"events\": [\n";
-    for (size_t i = 0; i < state.events.size(); ++i) {
-        json << "    \"" << gameEventToString(state.events[i]) << "\"";
-        if (i < state.events.size() - 1) {
-            json << ",";
-        }
-        json << "\n";
-    }
-    json << "  ],\n";
-    
-    // Round info
-    json << "  \"roundNumber\": " << state.roundNumber << ",\n";
-    json << "  \"roundTime\": " << state.roundTime << "\n";
-    
-    json << "}";
-    
-    return json.str();
+uint64_t WebSocketClient::getDroppedMessageCount() const {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return lanes_.getDroppedCount();
+}
+
+uint64_t WebSocketClient::getSupersededMessageCount() const {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return lanes_.getSupersededCount();
+}
+
+SendLaneStats WebSocketClient::getLaneStats(SendLane lane) const {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return lanes_.getStats(lane);
+}
+
+LatencyStats WebSocketClient::getLatencyStats() const {
+    return latency_.getStats();
+}
+
+uint64_t WebSocketClient::getConnectionGeneration() const {
+    return connectionGeneration_;
+}
+
+uint64_t WebSocketClient::getSubscriptionVersion() const {
+    return subscriptionVersion_;
 }
 
-std::string WebSocketClient::gameEventToString(GameEvent event) {
-    switch (event) {
-        case GameEvent::ROUND_START:    return "Round Start";
-        case GameEvent::ROUND_END:      return "Round End";
-        case GameEvent::BOMB_PLANTED:   return "Bomb Planted";
-        case GameEvent::BOMB_DEFUSED:   return "Bomb Defused";
-        case GameEvent::BOMB_EXPLODED:  return "Bomb Exploded";
-        case GameEvent::PLAYER_KILLED:  return "Player Killed";
-        default:                        return "Unknown";
+Subscription WebSocketClient::getSubscription() const {
+    std::lock_guard<std::mutex> lock(subscriptionMutex_);
+    return subscription_;
+}
+
+void WebSocketClient::applySubscription(StateEncoder& encoder) const {
+    if (encoder.getSubscriptionVersion() == subscriptionVersion_) {
+        return;
     }
+
+    std::lock_guard<std::mutex> lock(subscriptionMutex_);
+    encoder.setSubscription(subscription_, subscriptionVersion_);
 }
 
 void WebSocketClient::sendThreadFunc() {
     LOG_INFO("WebSocket send thread started");
 
+    // Reused across messages; swapped with queue slots so no copy is made
+    std::string message;
+    std::string control;
+    uint64_t nextPingUs = monotonicMicros();
+    uint64_t nextReportUs = nextPingUs + kLatencyReportIntervalUs;
+    uint64_t nextCountersUs = nextPingUs + kCountersReportIntervalUs;
+    // Queue counters of this connection as last reported to the server
+    uint64_t reportedDropped = 0;
+    uint64_t reportedSuperseded = 0;
+
     while (!shouldStop_) {
-        std::string message;
-        
+        // Pings bypass the queue so queued frames do not inflate the round trip
+        uint64_t nowUs = monotonicMicros();
+        if (connected_ && nowUs >= nextPingUs) {
+            latency_.makePing(nowUs, control);
+            if (!writeMessage(control.data(), control.size())) {
+                connected_ = false;
+            }
+            nextPingUs = nowUs + kPingIntervalUs;
+        }
+        if (connected_ && nowUs >= nextCountersUs) {
+            // Counted for this connection, like the "seq" gaps the server sees
+            uint64_t dropped;
+            uint64_t superseded;
+            {
+                std::lock_guard<std::mutex> lock(queueMutex_);
+                dropped = lanes_.getDroppedCount() - droppedAtConnect_;
+                superseded = lanes_.getSupersededCount() - supersededAtConnect_;
+            }
+
+            // Changed counters go out at once so the server can net its gaps
+            // without waiting for a pong; latency figures ride along every few seconds
+            bool periodic = nowUs >= nextReportUs;
+            bool changed = dropped != reportedDropped || superseded != reportedSuperseded;
+            LatencyStats stats;
+            if (periodic) {
+                stats = latency_.getStats();
+                nextReportUs = nowUs + kLatencyReportIntervalUs;
+            }
+            if (changed || stats.hasClockOffset) {
+                latency_.makeReport(dropped, superseded, control);
+                if (!writeMessage(control.data(), control.size())) {
+                    connected_ = false;
+                }
+                reportedDropped = dropped;
+                reportedSuperseded = superseded;
+            }
+            if (stats.hasClockOffset) {
+                LOG_DEBUG("Latency: rtt " + std::to_string(static_cast<int64_t>(stats.rttUs)) +
+                          "us, p50 " + std::to_string(static_cast<int64_t>(stats.p50Us)) +
+                          "us, p99 " + std::to_string(static_cast<int64_t>(stats.p99Us)) + "us");
+            }
+            nextCountersUs = nowUs + kCountersReportIntervalUs;
+        }
+
+        uint64_t captureTimeNs = 0;
+        SendLane lane;
         {
-            std::lock_guard<std::mutex> lock(queueMutex_);
-            if (!messageQueue_.empty()) {
-                message = messageQueue_.front();
-                messageQueue_.pop();
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCondition_.wait_for(lock, std::chrono::milliseconds(100),
+                                     [this] { return shouldStop_ || !lanes_.empty(); });
+            if (shouldStop_ || !lanes_.pop(message, captureTimeNs, lane)) {
+                continue;
             }
         }
 
         if (!message.empty() && connected_) {
-#ifdef _WIN32
-            SOCKET sock = reinterpret_cast<SOCKET>(socket_);
-            int result = send(sock, message.c_str(), static_cast<int>(message.length()), 0);
-            if (result == SOCKET_ERROR) {
-                LOG_ERROR("Failed to send message: " + std::to_string(WSAGetLastError()));
+            if (!writeMessage(message.data(), message.size())) {
                 connected_ = false;
             } else {
+                latency_.recordFrame(captureTimeNs / 1000, monotonicMicros());
                 LOG_DEBUG("Sent message: " + message.substr(0, 100) + "...");
             }
+        }
+    }
+
+    LOG_INFO("WebSocket send thread stopped");
+}
+
+void WebSocketClient::receiveThreadFunc() {
+    std::string pending;
+    char buffer[4096];
+
+    while (!shouldStop_) {
+#ifdef _WIN32
+        int received = recv(reinterpret_cast<SOCKET>(socket_), buffer, sizeof(buffer), 0);
 #else
-            ssize_t result = send(socket_, message.c_str(), message.length(), 0);
-            if (result < 0) {
-                LOG_ERROR("Failed to send message");
+        ssize_t received = recv(socket_, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (received <= 0) {
+            // Server closed the connection (or disconnect() shut the socket down)
+            if (!shouldStop_) {
+                LOG_WARNING("Connection closed by WebSocket server");
                 connected_ = false;
-            } else {
-                LOG_DEBUG("Sent message: " + message.substr(0, 100) + "...");
             }
-#endif
+            break;
+        }
+
+        pending.append(buffer, static_cast<size_t>(received));
+
+        size_t start = 0;
+        size_t newline;
+        while ((newline = pending.find('\n', start)) != std::string::npos) {
+            if (newline > start) {
+                handleServerMessage(pending.substr(start, newline - start));
+            }
+            start = newline + 1;
+        }
+        pending.erase(0, start);
+
+        if (pending.size() > kMaxReceiveLine) {
+            LOG_WARNING("Dropping oversized message from WebSocket server");
+            pending.clear();
         }
+    }
+}
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+void WebSocketClient::handleServerMessage(const std::string& line) {
+    JsonValue message;
+    std::string error;
+    if (!JsonValue::parse(line, message, error)) {
+        LOG_WARNING("Ignoring malformed server message: " + error);
+        return;
     }
 
-    LOG_INFO("WebSocket send thread stopped");
+    std::string type = message.getString("type");
+    if (type == "subscribe") {
+        Subscription subscription;
+        if (!parseSubscription(message, subscription, error)) {
+            LOG_WARNING("Ignoring invalid subscription: " + error);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(subscriptionMutex_);
+            subscription_ = subscription;
+        }
+        ++subscriptionVersion_;
+        LOG_INFO("Server subscription updated");
+    } else if (type == "pong") {
+        uint64_t nowUs = monotonicMicros();
+        if (!latency_.onPong(static_cast<uint64_t>(message.getNumber("id", 0.0)),
+                             static_cast<uint64_t>(message.getNumber("t", 0.0)),
+                             message.getNumber("serverTime", 0.0), nowUs)) {
+            LOG_DEBUG("Ignoring stale or unknown pong");
+        }
+    } else {
+        LOG_DEBUG("Ignoring server message of type '" + type + "'");
+    }
+}
+
+bool WebSocketClient::writeMessage(const char* data, size_t length) {
+    if (!compressor_.isEnabled()) {
+        return sendBytes(data, length);
+    }
+    if (!compressor_.compress(data, length, record_)) {
+        return false;
+    }
+    return sendBytes(record_.data(), record_.size());
+}
+
+bool WebSocketClient::sendBytes(const char* data, size_t length) {
+    // send() may accept only part of a large frame
+    while (length > 0) {
+#ifdef _WIN32
+        SOCKET sock = reinterpret_cast<SOCKET>(socket_);
+        int result = send(sock, data, static_cast<int>(length), 0);
+        if (result == SOCKET_ERROR) {
+            LOG_ERROR("Failed to send message: " + std::to_string(WSAGetLastError()));
+            return false;
+        }
+#else
+        ssize_t result = send(socket_, data, length, MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Failed to send message");
+            return false;
+        }
+#endif
+        data += result;
+        length -= static_cast<size_t>(result);
+    }
+    return true;
 }
 
-bool WebSocketClient::tryReconnect() {
-    LOG_INFO("Attempting to reconnect to WebSocket server...");
+void WebSocketClient::requestReconnect() {
+    bool expected = false;
+    if (!reconnecting_.compare_exchange_strong(expected, true)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(reconnectMutex_);
+    if (stopReconnect_) {
+        reconnecting_ = false;
+        return;
+    }
+    // A previous reconnect thread has already returned, it only needs joining
+    if (reconnectThread_ && reconnectThread_->joinable()) {
+        reconnectThread_->join();
+    }
+    reconnectThread_ = std::make_unique<std::thread>(&WebSocketClient::reconnectThreadFunc, this);
+}
     
-    disconnect();
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+void WebSocketClient::reconnectThreadFunc() {
+    uint32_t delayMs = kReconnectInitialDelayMs;
+    while (true) {
+        // Wait first: the server just went away or refused the last attempt
+        {
+            std::unique_lock<std::mutex> lock(reconnectMutex_);
+            if (reconnectCondition_.wait_for(lock, std::chrono::milliseconds(delayMs),
+                                             [this] { return stopReconnect_; })) {
+                break;
+            }
+        }
     
-    return connect(host_, port_);
+        LOG_INFO("Attempting to reconnect to WebSocket server...");
+        closeConnection();
+        if (connect(host_, port_)) {
+            break;
+        }
+        delayMs = std::min(delayMs * 2, kReconnectMaxDelayMs);
+    }
+    reconnecting_ = false;
 }
 
 } // namespace CS16Capture